@@ -0,0 +1,211 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <yenxo/string_map.hpp>
+#include <yenxo/variant.hpp>
+
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace yenxo {
+
+/// 8 byte counterpart of `Variant` for large numeric arrays and deep trees
+/// \ingroup group-datatypes
+///
+/// The value is NaN-boxed: a double is stored as is, every other type is packed into
+/// the payload bits of a negative quiet NaN, NaN doubles are canonicalized to a positive
+/// one. Integers up to 32 bits and the 64-bit integers fitting 48 bits are stored
+/// inline, bigger integers, strings, `Vec`s and `Map`s are heap payloads shared by
+/// copies like the ones of `Variant`. Pointers are assumed to fit 48 bits, as they do on
+/// x86-64 and AArch64.
+///
+/// The getters convert and throw exactly like the `Variant` ones.
+class CompactVariant {
+public:
+    using NullType = Variant::NullType;
+    using TypeTag = Variant::TypeTag;
+    using Map = StringMap<CompactVariant>;
+    using Vec = std::vector<CompactVariant>;
+
+    ~CompactVariant() noexcept;
+
+    CompactVariant() noexcept;
+
+    CompactVariant(NullType) noexcept;
+    CompactVariant(bool) noexcept;
+    CompactVariant(char) noexcept;
+    CompactVariant(int8_t) noexcept;
+    CompactVariant(uint8_t) noexcept;
+    CompactVariant(int16_t) noexcept;
+    CompactVariant(uint16_t) noexcept;
+    CompactVariant(int32_t) noexcept;
+    CompactVariant(uint32_t) noexcept;
+    CompactVariant(int64_t);
+    CompactVariant(uint64_t);
+    CompactVariant(double) noexcept;
+
+    CompactVariant(char const* const&);
+    CompactVariant(std::string const&);
+    CompactVariant(std::string&&);
+    CompactVariant(std::string_view);
+
+    CompactVariant(Vec const&);
+    CompactVariant(Vec&&);
+
+    CompactVariant(Map const&);
+    CompactVariant(Map&&);
+
+    /// Deep conversion from `Variant`
+    explicit CompactVariant(Variant const& var);
+
+    // copy
+    CompactVariant(CompactVariant const& rhs) noexcept;
+    CompactVariant& operator=(CompactVariant const& rhs) noexcept;
+
+    // move
+    CompactVariant(CompactVariant&& rhs) noexcept;
+    CompactVariant& operator=(CompactVariant&& rhs) noexcept;
+
+    /// Deep conversion to `Variant`
+    Variant expand() const;
+
+    /// Get the value
+    /// \throw VariantEmpty, VariantBadType, VariantIntegralOverflow
+    /// @{
+    bool boolean() const;
+    char character() const;
+    int8_t int8() const;
+    uint8_t uint8() const;
+    int16_t int16() const;
+    uint16_t uint16() const;
+    int32_t int32() const;
+    uint32_t uint32() const;
+    int64_t int64() const;
+    uint64_t uint64() const;
+    double floating() const;
+    /// @}
+
+    /// Get the value or `x` if the object is null
+    /// \throw VariantBadType, VariantIntegralOverflow
+    /// @{
+    bool booleanOr(bool x) const;
+    char characterOr(char x) const;
+    int8_t int8Or(int8_t x) const;
+    uint8_t uint8Or(uint8_t x) const;
+    int16_t int16Or(int16_t x) const;
+    uint16_t uint16Or(uint16_t x) const;
+    int32_t int32Or(int32_t x) const;
+    uint32_t uint32Or(uint32_t x) const;
+    int64_t int64Or(int64_t x) const;
+    uint64_t uint64Or(uint64_t x) const;
+    double floatingOr(double x) const;
+    /// @}
+
+    /// Get string
+    ///
+    /// The view is valid as long as the object is alive and not modified.
+    /// \throw VariantEmpty, VariantBadType
+    std::string_view str() const;
+
+    /// Get string or `x` if the object is null
+    /// \throw VariantBadType
+    std::string strOr(std::string const& x) const;
+
+    /// Get Vec
+    /// \throw VariantEmpty, VariantBadType
+    Vec const& vec() const;
+
+    /// Get Vec for modification, a Vec shared with copies is copied first
+    ///
+    /// The reference must not be used after `*this` is copied.
+    /// \throw VariantEmpty, VariantBadType
+    Vec& modifyVec();
+
+    /// Get Map
+    /// \throw VariantEmpty, VariantBadType
+    Map const& map() const;
+
+    /// Get Map for modification, a Map shared with copies is copied first
+    ///
+    /// The reference must not be used after `*this` is copied.
+    /// \throw VariantEmpty, VariantBadType
+    Map& modifyMap();
+
+    /// Check if the object contains null
+    bool null() const noexcept {
+        return bits_ == null_bits;
+    }
+
+    bool operator==(CompactVariant const& rhs) const noexcept;
+    bool operator!=(CompactVariant const& rhs) const noexcept;
+
+    /// \ingroup group-json
+    /// @{
+    /// \throw std::runtime_error on `json` parse
+    static CompactVariant fromJson(std::string const& json);
+
+    std::string toJson() const;
+    std::string toPrettyJson() const;
+    /// @}
+
+    TypeTag type() const noexcept;
+
+    static constexpr std::string_view typeName() noexcept {
+        return "compact_variant";
+    }
+
+    /// Test if the value is a scalar
+    bool isScalar() const noexcept {
+        auto const t = type();
+        return t != TypeTag::map && t != TypeTag::vec;
+    }
+
+private:
+    struct Impl;
+
+    /// Kind of a boxed value, stored in the bits 48-50
+    enum class Box : uint64_t {
+        small,  ///< `TypeTag` in the bits 32-39, the value in the bits 0-31
+        int48,  ///< `int64` in the bits 0-47
+        uint48, ///< `uint64` in the bits 0-47
+        int64,  ///< pointer to a shared `int64_t`
+        uint64, ///< pointer to a shared `uint64_t`
+        string, ///< pointer to a shared `std::string`
+        vec,    ///< pointer to a shared `Vec`
+        map     ///< pointer to a shared `Map`
+    };
+
+    /// Sign and exponent bits all set plus the quiet bit
+    static constexpr uint64_t box_mask = 0xfff8'0000'0000'0000;
+    static constexpr uint64_t null_bits = box_mask;
+
+    uint64_t bits_;
+};
+
+} // namespace yenxo
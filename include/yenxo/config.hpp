@@ -33,3 +33,37 @@
 #define YENXO_ENABLE_TYPE_SAFE 1
 #endif
 #endif
+
+#ifdef YENXO_DOXYGEN_INVOKED
+/// \ingroup group-config
+/// Maximum number of `Variant::Map` entries searched by a linear scan, bigger maps
+/// maintain an open addressing hash index.
+#define YENXO_MAP_LINEAR_LIMIT 16
+#else
+#ifndef YENXO_MAP_LINEAR_LIMIT
+#define YENXO_MAP_LINEAR_LIMIT 16
+#endif
+#endif
+
+#ifdef YENXO_DOXYGEN_INVOKED
+/// \ingroup group-config
+/// Minimum number of elements of a homogeneous numeric or boolean array stored packed
+/// by `Variant::fromJson()` and `toVariant()`, see `Variant::packedType()`.
+#define YENXO_PACKED_MIN_SIZE 16
+#else
+#ifndef YENXO_PACKED_MIN_SIZE
+#define YENXO_PACKED_MIN_SIZE 16
+#endif
+#endif
+
+#ifdef YENXO_DOXYGEN_INVOKED
+/// \ingroup group-config
+/// Number of freed `Variant` payloads of each size class a thread keeps for reuse, 0
+/// disables the pooling. Can be changed at runtime by `setPayloadPoolLimit()` of
+/// `yenxo/variant_stats.hpp`.
+#define YENXO_PAYLOAD_POOL_LIMIT 64
+#else
+#ifndef YENXO_PAYLOAD_POOL_LIMIT
+#define YENXO_PAYLOAD_POOL_LIMIT 64
+#endif
+#endif
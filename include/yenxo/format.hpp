@@ -0,0 +1,390 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#pragma once
+
+#include <yenxo/meta.hpp>
+#include <yenxo/type_name.hpp>
+#include <yenxo/variant_conversion.hpp>
+#include <yenxo/when.hpp>
+
+#include <boost/hana.hpp>
+
+#include <charconv>
+#include <cstddef>
+#include <ostream>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <type_traits>
+
+namespace yenxo {
+
+/// Character buffer the text is formatted into by `format`
+/// \ingroup group-utility
+///
+/// `clear()` keeps the capacity, so a buffer reused for many messages stops allocating
+/// once it has grown to the longest of them.
+///
+/// Numbers and booleans are formatted like by a default constructed `std::ostream`
+/// unless the buffer is constructed from the stream the text is written to.
+class Buffer {
+public:
+    Buffer() = default;
+
+    /// A buffer formatting the numbers and booleans like `os`, e.g. with its
+    /// `precision()`, `std::hex` or `std::boolalpha`
+    ///
+    /// The width of `os` applies to the whole text once written by `os << view()`.
+    explicit Buffer(std::ios_base const& os)
+            : flags_(os.flags())
+            , precision_(os.precision()) {
+    }
+
+    void append(std::string_view text) {
+        str_.append(text.data(), text.size());
+    }
+
+    void push_back(char c) {
+        str_.push_back(c);
+    }
+
+    /// Append `x` formatted by `std::to_chars`, floating point numbers with the default
+    /// `std::ostream` precision of 6 significant digits
+    ///
+    /// Through a `std::ostringstream` if the format differs from the default one.
+    template <class T>
+    void appendNumber(T x) {
+        static_assert(std::is_arithmetic_v<T>);
+        if (!hasDefaultFormat()) {
+            std::ostringstream os;
+            applyFormat(os);
+            os << x;
+            append(os.str());
+            return;
+        }
+        if constexpr (std::is_same_v<T, bool>) {
+            push_back(x ? '1' : '0');
+        } else {
+            char chars[max_number_size];
+            std::to_chars_result r;
+            if constexpr (std::is_floating_point_v<T>) {
+                r = std::to_chars(chars, chars + max_number_size, x,
+                                  std::chars_format::general, 6);
+            } else {
+                r = std::to_chars(chars, chars + max_number_size, x);
+            }
+            str_.append(chars, static_cast<std::size_t>(r.ptr - chars));
+        }
+    }
+
+    std::string_view view() const noexcept {
+        return str_;
+    }
+
+    std::string const& str() const noexcept {
+        return str_;
+    }
+
+    std::size_t size() const noexcept {
+        return str_.size();
+    }
+
+    bool empty() const noexcept {
+        return str_.empty();
+    }
+
+    void reserve(std::size_t n) {
+        str_.reserve(n);
+    }
+
+    void clear() noexcept {
+        str_.clear();
+    }
+
+    /// Give `os` the number format of the buffer
+    void applyFormat(std::ios_base& os) const {
+        os.flags(flags_);
+        os.precision(precision_);
+    }
+
+private:
+    static constexpr std::size_t max_number_size = 32;
+    static constexpr std::ios_base::fmtflags default_flags =
+            std::ios_base::skipws | std::ios_base::dec;
+    static constexpr std::ios_base::fmtflags number_flags =
+            std::ios_base::basefield | std::ios_base::floatfield | std::ios_base::boolalpha
+            | std::ios_base::showbase | std::ios_base::showpoint | std::ios_base::showpos
+            | std::ios_base::uppercase;
+
+    bool hasDefaultFormat() const noexcept {
+        return (flags_ & number_flags) == (default_flags & number_flags)
+            && precision_ == 6;
+    }
+
+    std::string str_;
+    std::ios_base::fmtflags flags_{default_flags};
+    std::streamsize precision_{6};
+};
+
+namespace trait {
+
+template <typename Derived>
+struct OStream;
+
+} // namespace trait
+
+namespace detail {
+
+/// \ingroup group-details
+/// Is `std::ostream& operator<<(std::ostream&, T)` defined.
+inline constexpr auto const hasOStreamOperator = boost::hana::is_valid(
+        [](auto t) -> decltype(operator<<(std::declval<std::ostream>(),
+                                          std::declval<typename decltype(t)::type>())) {
+        });
+
+template <class T>
+inline constexpr bool isCharacter = std::is_same_v<T, char> || std::is_same_v<T, signed char>
+                                 || std::is_same_v<T, unsigned char>;
+
+/// \ingroup group-details
+/// Is `T` formatted by `format` itself rather than by its `operator<<`.
+template <class T>
+inline constexpr bool isFormattedDirectly =
+        std::is_arithmetic_v<T> || std::is_convertible_v<T const&, std::string_view>
+        || isString(boost::hana::type_c<T>) || isReflectiveEnum(boost::hana::type_c<T>)
+        || std::is_same_v<T, Variant> || std::is_base_of_v<trait::OStream<T>, T>;
+
+/// \ingroup group-details
+/// Is `T` formatted by `format` through the formatting of its parts.
+template <class T>
+inline constexpr bool isFormattedByParts =
+        !hasOStreamOperator(boost::hana::type_c<T>) && !isFormattedDirectly<T>;
+
+} // namespace detail
+
+/// Format `val` to `buf` as `oStream` would write it to a `std::ostream`
+/// \ingroup group-utility
+///
+/// The text is produced by `std::to_chars` and appended to the buffer without going
+/// through `std::ostream`. The function object is enabled for:
+/// * arithmetic types, `bool` as `0` or `1` and the character types as characters,
+/// the numbers in the format of the `Buffer`;
+/// * strings and anything convertible to `std::string_view`;
+/// * enums with specialized `EnumTraits`;
+/// * `Variant`;
+/// * Boost.Hana.Structs, in the format of `trait::OStream`;
+/// * `std::optional`, `std::pair`, `std::variant` and containers of the above;
+/// * any type with `std::ostream& operator<<(std::ostream&, T)`, through a
+/// `std::ostringstream`.
+///
+/// Specialize `FormatImpl` to enable it for other types.
+#ifdef YENXO_DOXYGEN_INVOKED
+inline auto format = [](Buffer& buf, T const& val) { FormatImpl<T>::apply(buf, val); };
+#else
+struct FormatT {
+    template <class T>
+    void operator()(Buffer& buf, T const& val) const;
+};
+
+inline constexpr FormatT format;
+
+template <class T>
+void formatImpl(Buffer& buf, T const& x);
+
+template <class T, class = void>
+struct FormatImpl : FormatImpl<T, When<true>> {};
+
+template <class T, bool condition>
+struct FormatImpl<T, When<condition>> {
+    static void apply(Buffer&, T const&) {
+        static_assert(T::pay_attention_no_format_defined_for);
+    }
+};
+
+template <class T>
+struct FormatImpl<T, When<std::is_same_v<T, bool>>> {
+    static void apply(Buffer& buf, T val) {
+        buf.appendNumber(val);
+    }
+};
+
+template <class T>
+struct FormatImpl<T, When<detail::isCharacter<T>>> {
+    static void apply(Buffer& buf, T val) {
+        buf.push_back(static_cast<char>(val));
+    }
+};
+
+template <class T>
+struct FormatImpl<T,
+                  When<std::is_arithmetic_v<T> && !std::is_same_v<T, bool>
+                       && !detail::isCharacter<T>>> {
+    static void apply(Buffer& buf, T val) {
+        buf.appendNumber(val);
+    }
+};
+
+template <class T>
+struct FormatImpl<T,
+                  When<!std::is_arithmetic_v<T>
+                       && (std::is_convertible_v<T const&, std::string_view>
+                           || isString(boost::hana::type_c<T>))>> {
+    static void apply(Buffer& buf, T const& val) {
+        buf.append(std::string_view(val));
+    }
+};
+
+template <class T>
+struct FormatImpl<T, When<isReflectiveEnum(boost::hana::type_c<T>)>> {
+    static void apply(Buffer& buf, T val) {
+        buf.append(EnumTraits<T>::toString(val));
+    }
+};
+
+template <>
+struct FormatImpl<Variant> {
+    static void apply(Buffer& buf, Variant const& val);
+};
+
+template <class T>
+struct FormatImpl<T,
+                  When<boost::hana::Struct<T>::value
+                       && (std::is_base_of_v<trait::OStream<T>, T>
+                           || detail::isFormattedByParts<T>)>> {
+    static void apply(Buffer& buf, T const& val) {
+        formatImpl(buf, val);
+    }
+};
+
+template <class T>
+struct FormatImpl<T,
+                  When<detail::hasOStreamOperator(boost::hana::type_c<T>)
+                       && !detail::isFormattedDirectly<T>>> {
+    static void apply(Buffer& buf, T const& val) {
+        std::ostringstream os;
+        buf.applyFormat(os);
+        os << val;
+        buf.append(os.str());
+    }
+};
+
+template <class T>
+struct FormatImpl<T,
+                  When<detail::isFormattedByParts<T> && isOptional(boost::hana::type_c<T>)>> {
+    static void apply(Buffer& buf, T const& val) {
+        if (val.has_value()) {
+            format(buf, *val);
+        } else {
+            buf.append("None");
+        }
+    }
+};
+
+template <class T>
+struct FormatImpl<T,
+                  When<detail::isFormattedByParts<T> && isContainer(boost::hana::type_c<T>)
+                       && isPair(boost::hana::type_c<typename T::value_type>)>> {
+    static void apply(Buffer& buf, T const& val) {
+        buf.append("{ ");
+        bool first = true;
+        for (auto const& x : val) {
+            if (!first) {
+                buf.push_back(' ');
+            }
+            first = false;
+            format(buf, x);
+            buf.push_back(';');
+        }
+        buf.append(" }");
+    }
+};
+
+template <class T>
+struct FormatImpl<T,
+                  When<detail::isFormattedByParts<T> && isContainer(boost::hana::type_c<T>)
+                       && !isPair(boost::hana::type_c<typename T::value_type>)>> {
+    static void apply(Buffer& buf, T const& val) {
+        buf.push_back('[');
+        bool first = true;
+        for (auto const& x : val) {
+            if (!first) {
+                buf.append(", ");
+            }
+            first = false;
+            format(buf, x);
+        }
+        buf.push_back(']');
+    }
+};
+
+template <class T>
+struct FormatImpl<T, When<detail::isFormattedByParts<T> && isPair(boost::hana::type_c<T>)>> {
+    static void apply(Buffer& buf, T const& val) {
+        format(buf, val.first);
+        buf.append(": ");
+        format(buf, val.second);
+    }
+};
+
+#if YENXO_ENABLE_TYPE_SAFE
+template <class T>
+struct FormatImpl<T,
+                  When<detail::isFormattedByParts<T> && strongTypeDef(boost::hana::type_c<T>)>> {
+    static void apply(Buffer& buf, T const& val) {
+        format(buf, static_cast<type_safe::underlying_type<T>>(val));
+    }
+};
+#endif
+
+template <class T>
+struct FormatImpl<T,
+                  When<detail::isFormattedByParts<T> && isStdVariant(boost::hana::type_c<T>)>> {
+    static void apply(Buffer& buf, T const& val) {
+        std::visit([&buf](auto const& x) { format(buf, x); }, val);
+    }
+};
+
+template <class T>
+void FormatT::operator()(Buffer& buf, T const& val) const {
+    FormatImpl<T>::apply(buf, val);
+}
+#endif
+
+/// Format a Boost.Hana.Struct as `TypeName { member: value; ... }`
+/// \pre `T` should be a Boost.Hana.Struct.
+template <class T>
+void formatImpl(Buffer& buf, T const& x) {
+    buf.append(typeName(boost::hana::type_c<T>));
+    buf.append(" { ");
+    boost::hana::for_each(x, boost::hana::fuse([&](auto name, auto const& value) {
+                              buf.append(boost::hana::to<char const*>(name));
+                              buf.append(": ");
+                              format(buf, value);
+                              buf.append("; ");
+                          }));
+    buf.push_back('}');
+}
+
+} // namespace yenxo
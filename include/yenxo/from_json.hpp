@@ -0,0 +1,334 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <yenxo/interned_key.hpp>
+#include <yenxo/meta.hpp>
+#include <yenxo/variant.hpp>
+#include <yenxo/variant_conversion.hpp>
+#include <yenxo/variant_traits.hpp>
+
+#include <boost/hana.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace yenxo {
+
+namespace detail {
+
+struct JsonReader;
+
+/// Where the next value of the JSON text goes
+/// \ingroup group-details
+struct JsonSlot {
+    void* obj;
+    /// nullptr to skip the value
+    JsonReader const* reader;
+    /// Element of `VariantErr::path()` naming the slot, empty for none
+    std::string_view name;
+};
+
+/// State of an object being read, kept by the parser
+/// \ingroup group-details
+struct JsonObjectState {
+    /// The members found so far, one bit per member
+    std::uint64_t seen{0};
+    /// The member expected next, the members usually come in the declared order
+    std::size_t next{0};
+};
+
+/// Operations writing the JSON text into an object of some type
+/// \ingroup group-details
+///
+/// A null operation means the type is not read that way, the value is then parsed into a
+/// `Variant` and converted by `assign`, like `fromVariant` does. So the mismatches report
+/// the same errors as the `Variant` route.
+struct JsonReader {
+    /// Assign a scalar, or a container parsed into a `Variant`
+    void (*assign)(void* obj, Variant const& x);
+    /// Assign a string
+    void (*string)(void* obj, std::string_view x);
+    /// Redirect to the slot of the contained value, called before any other operation
+    JsonSlot (*unwrap)(void* obj);
+    /// Start an array
+    void (*startArray)(void* obj);
+    /// Slot of the next element of the array
+    JsonSlot (*element)(void* obj);
+    /// Start an object
+    void (*startObject)(void* obj);
+    /// Slot of the member `key` of the object
+    JsonSlot (*member)(void* obj, std::string_view key, JsonObjectState& state);
+    /// Finish the object, the missing members are defaulted or reported
+    void (*endObject)(void* obj, JsonObjectState const& state);
+};
+
+/// Parse `json` into `root`
+/// \ingroup group-details
+/// \throw std::runtime_error on `json` parse
+/// \throw VariantErr with the path of the value failed to convert
+void parseJsonInto(std::string_view json, JsonSlot root);
+
+template <class T>
+JsonReader const& jsonReader();
+
+/// \ingroup group-details
+template <class D, class P>
+struct VarBase {
+    using Derived = D;
+    using Policy = P;
+};
+
+/// \ingroup group-details
+template <class D, class P>
+VarBase<D, P> varBase(trait::Var<D, P> const&);
+
+/// Is `T` converted by `trait::Var` with a policy the struct reader implements: no tag,
+/// no custom member conversion, no `post_from_variant` hook and the keys interned once
+/// \ingroup group-details
+template <class T, class = void>
+struct IsJsonStruct : std::false_type {};
+
+template <class T>
+struct IsJsonStruct<T, std::void_t<decltype(varBase(std::declval<T const&>()))>> {
+    using Base = decltype(varBase(std::declval<T const&>()));
+    using Policy = typename Base::Policy;
+
+    static constexpr bool value = [] {
+        if constexpr (std::is_same_v<typename Base::Derived, T>) {
+            return &T::fromVariant == &trait::Var<T, Policy>::fromVariant
+                && std::is_same_v<std::remove_const_t<decltype(Policy::tag)>,
+                                  typename Policy::NoTag>
+                && std::is_same_v<std::remove_const_t<decltype(Policy::from_variant)>,
+                                  FromVariantT2>
+                && std::is_same_v<decltype(Policy::post_from_variant),
+                                  decltype(trait::VarPolicy::post_from_variant)>
+                && decltype(boost::hana::length(boost::hana::accessors<T>()))::value <= 64
+                && std::is_default_constructible_v<T> && std::is_move_assignable_v<T>
+                && boost::hana::all_of(boost::hana::accessors<T>(), [](auto member) {
+                       using Name = std::decay_t<decltype(boost::hana::first(member))>;
+                       return boost::hana::bool_c<trait::detail::cachedKey<T, Policy, Name>>;
+                   });
+        } else {
+            return false;
+        }
+    }();
+};
+
+/// Fallback of every type: through `Variant` and `fromVariant`
+/// \ingroup group-details
+template <class T>
+void assignJson(void* obj, Variant const& x) {
+    *static_cast<T*>(obj) = fromVariant<T>(x);
+}
+
+/// \ingroup group-details
+template <class T, class Policy>
+struct StructJsonReader {
+    static constexpr std::size_t size = boost::hana::length(boost::hana::accessors<T>());
+
+    struct Member {
+        InternedKey const* key;
+        JsonSlot (*slot)(void* obj, std::string_view key);
+        void (*missing)(void* obj);
+    };
+
+    template <std::size_t I>
+    static auto& get(void* obj) {
+        return boost::hana::second(boost::hana::at_c<I>(boost::hana::accessors<T>()))(
+                *static_cast<T*>(obj));
+    }
+
+    /// The `hana::string` name of the member `I`
+    template <std::size_t I>
+    using Name = std::decay_t<decltype(boost::hana::first(
+            boost::hana::at_c<I>(boost::hana::accessors<T>())))>;
+
+    /// Same as `trait::fromVariantImpl()` does for a missing member
+    template <std::size_t I>
+    static void missing([[maybe_unused]] void* obj) {
+        using namespace std::literals;
+        using M = std::remove_reference_t<decltype(get<I>(obj))>;
+        constexpr auto type = boost::hana::type_c<T>;
+        if constexpr (Policy::Defaults::has(type)) {
+            if constexpr (Policy::Defaults::hasValue(type, Name<I>())) {
+                get<I>(obj) = Policy::Defaults::value(type, Name<I>());
+                return;
+            }
+        }
+        constexpr auto member = boost::hana::type_c<M>;
+        if constexpr (!isOptional(member)
+                      && ((isContainer(member) && !Policy::empty_container_not_required)
+                          || !isContainer(member))) {
+            auto const& key = trait::detail::memberKey<T, Policy>(Name<I>());
+            throw std::logic_error("'"s + key.c_str() + "' is required"s);
+        }
+    }
+
+    template <std::size_t... I>
+    static std::array<Member, size> makeMembers(std::index_sequence<I...>) {
+        return {Member{&trait::detail::memberKey<T, Policy>(Name<I>()),
+                       [](void* obj, std::string_view key) {
+                           using M = std::remove_reference_t<decltype(get<I>(obj))>;
+                           return JsonSlot{&get<I>(obj), &jsonReader<M>(), key};
+                       },
+                       &missing<I>}...};
+    }
+
+    static std::array<Member, size> const& members() {
+        static auto const ret = makeMembers(std::make_index_sequence<size>());
+        return ret;
+    }
+
+    static void startObject(void* obj) {
+        *static_cast<T*>(obj) = T();
+    }
+
+    static JsonSlot member(void* obj, std::string_view key, JsonObjectState& state) {
+        auto const& xs = members();
+        for (std::size_t n = 0; n < size; ++n) {
+            auto const i = (state.next + n) % size;
+            auto const x = xs[i].key->view();
+            if (x == key) {
+                state.seen |= std::uint64_t(1) << i;
+                state.next = i + 1;
+                return xs[i].slot(obj, x);
+            }
+        }
+        if constexpr (!Policy::allow_additional_properties) {
+            throw std::logic_error("'" + std::string(key) + "' is unknown");
+        }
+        return {nullptr, nullptr, {}};
+    }
+
+    static void endObject(void* obj, JsonObjectState const& state) {
+        auto const& xs = members();
+        for (std::size_t i = 0; i < size; ++i) {
+            if (!(state.seen & std::uint64_t(1) << i)) {
+                xs[i].missing(obj);
+            }
+        }
+    }
+};
+
+/// Which `JsonReader` operations `T` has
+/// \ingroup group-details
+template <class T>
+constexpr JsonReader makeJsonReader() {
+    constexpr auto type = boost::hana::type_c<T>;
+    JsonReader ret{};
+    if constexpr (!isOptional(type)) {
+        ret.assign = &assignJson<T>;
+    }
+
+    if constexpr (isOptional(type)) {
+        using V = typename T::value_type;
+        ret.unwrap = [](void* obj) {
+            auto& x = static_cast<T*>(obj)->emplace();
+            return JsonSlot{&x, &jsonReader<V>(), {}};
+        };
+    } else if constexpr (std::is_same_v<T, std::string>) {
+        ret.string = [](void* obj, std::string_view x) {
+            static_cast<std::string*>(obj)->assign(x);
+        };
+    } else if constexpr (IsJsonStruct<T>::value) {
+        using Reader = StructJsonReader<T, typename IsJsonStruct<T>::Policy>;
+        ret.startObject = &Reader::startObject;
+        ret.member = &Reader::member;
+        ret.endObject = &Reader::endObject;
+    } else if constexpr (hasFromVariant(type)) {
+        // converted by its own `fromVariant`
+    } else if constexpr (isCollectionTypeWithPushBack(type)) {
+        using V = typename T::value_type;
+        if constexpr (std::is_same_v<decltype(std::declval<T&>().emplace_back()), V&>) {
+            ret.startArray = [](void* obj) { static_cast<T*>(obj)->clear(); };
+            ret.element = [](void* obj) {
+                auto& x = static_cast<T*>(obj)->emplace_back();
+                return JsonSlot{&x, &jsonReader<V>(), {}};
+            };
+        }
+    } else if constexpr (isMapType(type)) {
+        using K = typename T::key_type;
+        using V = typename T::mapped_type;
+        if constexpr (std::is_constructible_v<K, std::string_view>
+                      && std::is_default_constructible_v<V>) {
+            ret.startObject = [](void* obj) { static_cast<T*>(obj)->clear(); };
+            // the last of the repeated keys wins, like in `Variant::Map`
+            ret.member = [](void* obj, std::string_view key, JsonObjectState&) {
+                auto const [it, inserted] = static_cast<T*>(obj)->try_emplace(K(key));
+                if (!inserted) {
+                    it->second = V();
+                }
+                // the entries are not in the path, like in `fromVariant`
+                return JsonSlot{&it->second, &jsonReader<V>(), {}};
+            };
+            ret.endObject = [](void*, JsonObjectState const&) {};
+        }
+    }
+    return ret;
+}
+
+/// The `JsonReader` of `T`, looked up when a value of `T` is met so recursive types work
+/// \ingroup group-details
+template <class T>
+JsonReader const& jsonReader() {
+    static constexpr JsonReader ret = makeJsonReader<T>();
+    return ret;
+}
+
+} // namespace detail
+
+/// Parse `json` straight into `T`
+/// \ingroup group-json
+///
+/// Same as `fromVariant<T>(Variant::fromJson(json))` without the `Variant` tree: the
+/// members of the structs with `trait::Var`, the sequences with `emplace_back()`, the
+/// maps with string keys, `std::optional` and `std::string` are written as the SAX
+/// events come. The other values, and the ones which do not match the type, like a
+/// number for a struct, are parsed into a `Variant` and converted by `fromVariant`.
+///
+/// The struct policies with a tag, a custom `from_variant` or a `post_from_variant`
+/// hook are converted through `Variant` as a whole.
+///
+/// Of several errors in a document the first one in the document order is thrown, the
+/// missing members at the end of their object.
+/// \throw std::runtime_error on `json` parse
+/// \throw VariantErr with the same path as `fromVariant`
+template <class T>
+T fromJson(std::string_view json) {
+    T ret{};
+    detail::parseJsonInto(json, {&ret, &detail::jsonReader<T>(), {}});
+    return ret;
+}
+
+} // namespace yenxo
@@ -0,0 +1,327 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <yenxo/variant.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace yenxo {
+
+/// Read-only node of a `FrozenVariant`
+/// \ingroup group-datatypes
+///
+/// A reference is a pair of pointers, it stays valid as long as its document.
+class FrozenRef {
+public:
+    using Member = std::pair<std::string_view, FrozenRef>;
+
+    template <class Value>
+    class Iterator;
+
+    template <class Value>
+    class Range;
+
+    /// Null node of no document
+    FrozenRef() noexcept;
+
+    Variant::TypeTag type() const noexcept {
+        return node_->type;
+    }
+
+    /// Check if the node is null
+    bool null() const noexcept {
+        return node_->type == Variant::TypeTag::null;
+    }
+
+    /// Test if the value is a scalar
+    bool isScalar() const noexcept {
+        return node_->type != Variant::TypeTag::map
+            && node_->type != Variant::TypeTag::vec;
+    }
+
+    /// Get the value, the conversions are the ones of the same `Variant` getters
+    /// \throw VariantEmpty, VariantBadType, VariantIntegralOverflow
+    /// @{
+    bool boolean() const;
+    char character() const;
+    int8_t int8() const;
+    uint8_t uint8() const;
+    int16_t int16() const;
+    uint16_t uint16() const;
+    int32_t int32() const;
+    uint32_t uint32() const;
+    int64_t int64() const;
+    uint64_t uint64() const;
+    double floating() const;
+    /// @}
+
+    /// Get string
+    ///
+    /// The view is valid as long as the document.
+    /// \throw VariantEmpty, VariantBadType
+    std::string_view str() const;
+
+    /// Get the elements of a Vec
+    /// \throw VariantEmpty, VariantBadType
+    Range<FrozenRef> vec() const;
+
+    /// Get the members of a Map ordered by key
+    /// \throw VariantEmpty, VariantBadType
+    Range<Member> map() const;
+
+    /// Number of the elements of a Vec or the members of a Map, 0 for a scalar
+    std::size_t size() const noexcept {
+        return isScalar() ? 0 : node_->size;
+    }
+
+    /// Get an element of a Vec
+    /// \throw VariantEmpty, VariantBadType, std::out_of_range
+    FrozenRef at(std::size_t i) const;
+
+    /// Get a member of a Map
+    /// \throw VariantEmpty, VariantBadType, std::out_of_range if the key is absent
+    FrozenRef at(std::string_view key) const;
+
+    /// Find a member of a Map by binary search
+    /// \throw VariantEmpty, VariantBadType
+    std::optional<FrozenRef> find(std::string_view key) const;
+
+    /// Copy the node and its children into a `Variant`
+    Variant thaw() const;
+
+    /// The members of a Map are written ordered by key
+    /// \ingroup group-json
+    /// @{
+    std::string toJson() const;
+    std::string toPrettyJson() const;
+    /// @}
+
+    /// Check if two nodes are equal, see `equal(Variant const&, Variant const&)`
+    friend bool equal(FrozenRef lhs, FrozenRef rhs);
+    friend bool equal(FrozenRef lhs, Variant const& rhs);
+    friend bool equal(Variant const& lhs, FrozenRef rhs);
+
+private:
+    friend class FrozenVariant;
+
+    /// Scalar value or the location of a string or of the children of a container
+    struct Node {
+        Variant::TypeTag type;
+        /// Bytes of a string, elements of a Vec or members of a Map
+        uint32_t size;
+        union Value {
+            bool bool_;
+            char char_;
+            int8_t int8;
+            uint8_t uint8;
+            int16_t int16;
+            uint16_t uint16;
+            int32_t int32;
+            uint32_t uint32;
+            int64_t int64;
+            uint64_t uint64;
+            double double_;
+            /// Of a string in the characters, of the first child in the nodes
+            uint64_t offset;
+        } value;
+    };
+
+    /// Header of the memory block of a document, followed by the nodes and the
+    /// characters
+    struct Tape {
+        mutable std::atomic<std::size_t> refs;
+        uint32_t node_count;
+        uint32_t char_count;
+
+        Node const* nodes() const noexcept {
+            return reinterpret_cast<Node const*>(this + 1);
+        }
+        char const* chars() const noexcept {
+            return reinterpret_cast<char const*>(nodes() + node_count);
+        }
+    };
+
+    FrozenRef(Tape const* tape, Node const* node) noexcept
+            : tape_(tape)
+            , node_(node) {
+    }
+
+    /// The node as a `Variant`, allocates only for a string or a container
+    Variant scalar() const;
+
+    /// \throw VariantEmpty, VariantBadType unless the node is of `type`
+    void expect(Variant::TypeTag type) const;
+
+    std::string_view string(Node const& x) const noexcept {
+        return std::string_view(tape_->chars() + x.value.offset, x.size);
+    }
+
+    Node const* children() const noexcept {
+        return tape_->nodes() + node_->value.offset;
+    }
+
+    Tape const* tape_;
+    Node const* node_;
+};
+
+/// Iterator over the elements of a Vec or the members of a Map of a `FrozenVariant`
+///
+/// A member is a key node followed by the value node.
+template <class Value>
+class FrozenRef::Iterator {
+    static constexpr bool member = std::is_same_v<Value, Member>;
+
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type = Value;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = Value;
+
+    Iterator() noexcept = default;
+
+    Value operator*() const noexcept {
+        if constexpr (member) {
+            return Member(FrozenRef(tape_, node_).string(*node_),
+                          FrozenRef(tape_, node_ + 1));
+        } else {
+            return FrozenRef(tape_, node_);
+        }
+    }
+
+    Iterator& operator++() noexcept {
+        node_ += member ? 2 : 1;
+        return *this;
+    }
+
+    Iterator operator++(int) noexcept {
+        auto ret = *this;
+        ++*this;
+        return ret;
+    }
+
+    friend bool operator==(Iterator const& lhs, Iterator const& rhs) noexcept {
+        return lhs.node_ == rhs.node_;
+    }
+
+    friend bool operator!=(Iterator const& lhs, Iterator const& rhs) noexcept {
+        return lhs.node_ != rhs.node_;
+    }
+
+private:
+    friend class FrozenRef;
+
+    Iterator(Tape const* tape, Node const* node) noexcept
+            : tape_(tape)
+            , node_(node) {
+    }
+
+    Tape const* tape_{nullptr};
+    Node const* node_{nullptr};
+};
+
+/// Children of a Vec or a Map of a `FrozenVariant`
+template <class Value>
+class FrozenRef::Range {
+public:
+    Iterator<Value> begin() const noexcept {
+        return first_;
+    }
+    Iterator<Value> end() const noexcept {
+        return last_;
+    }
+    std::size_t size() const noexcept {
+        return size_;
+    }
+    bool empty() const noexcept {
+        return size_ == 0;
+    }
+
+private:
+    friend class FrozenRef;
+
+    Range(Iterator<Value> first, Iterator<Value> last, std::size_t size) noexcept
+            : first_(first)
+            , last_(last)
+            , size_(size) {
+    }
+
+    Iterator<Value> first_;
+    Iterator<Value> last_;
+    std::size_t size_;
+};
+
+/// Immutable `Variant` document stored in a single memory block
+/// \ingroup group-datatypes
+///
+/// The document is a tape of fixed size nodes. The elements of a Vec, and the members
+/// of a Map as key and value nodes, are adjacent and a container refers to them by
+/// offset. Strings refer to the character area at the end of the block. Map members are
+/// ordered by key and found by binary search, repeated keys are stored once.
+///
+/// Copies share the block through an atomic reference count, the document can be read
+/// from any number of threads. The object itself is the root node.
+class FrozenVariant : public FrozenRef {
+public:
+    /// Null document
+    FrozenVariant() noexcept = default;
+
+    /// \throw std::length_error if the document exceeds 4 GiB of characters or
+    /// 2^32 nodes
+    explicit FrozenVariant(Variant const& var);
+
+    ~FrozenVariant() noexcept;
+
+    FrozenVariant(FrozenVariant const& rhs) noexcept;
+    FrozenVariant(FrozenVariant&& rhs) noexcept;
+    FrozenVariant& operator=(FrozenVariant rhs) noexcept;
+
+    /// Parse `json` straight into a document, a repeated key keeps the last value
+    /// \ingroup group-json
+    /// \throw std::runtime_error on `json` parse, std::length_error as the constructor
+    static FrozenVariant fromJson(std::string const& json);
+
+    /// Size of the memory block
+    std::size_t bytes() const noexcept;
+
+private:
+    struct Builder;
+
+    explicit FrozenVariant(Tape const* tape) noexcept
+            : FrozenRef(tape, tape->nodes()) {
+    }
+};
+
+} // namespace yenxo
@@ -0,0 +1,185 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+namespace yenxo {
+
+/// Immutable string shared through a global pool, used as `Variant::Map` key
+/// \ingroup group-datatypes
+///
+/// Constructing a key with the contents of an existing key yields a handle to the same
+/// pooled string, so equal keys are stored once and compare by a pointer. The hash is
+/// computed once when the string enters the pool. A pooled string is released when the
+/// last key referring to it is destroyed.
+class InternedKey {
+    /// Enables a comparison with anything convertible to `std::string_view`
+    template <class S>
+    using IfStringLike =
+            std::enable_if_t<std::is_convertible_v<S const&, std::string_view>
+                             && !std::is_same_v<S, InternedKey>>;
+
+public:
+    /// The empty key, it is not pooled
+    InternedKey() noexcept = default;
+
+    InternedKey(std::string_view str);
+    InternedKey(char const* str)
+            : InternedKey(std::string_view(str)) {
+    }
+    InternedKey(std::string const& str)
+            : InternedKey(std::string_view(str)) {
+    }
+
+    InternedKey(InternedKey const& rhs) noexcept
+            : entry_(rhs.entry_) {
+        if (entry_) {
+            entry_->refs.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    InternedKey(InternedKey&& rhs) noexcept
+            : entry_(rhs.entry_) {
+        rhs.entry_ = nullptr;
+    }
+
+    InternedKey& operator=(InternedKey rhs) noexcept {
+        std::swap(entry_, rhs.entry_);
+        return *this;
+    }
+
+    ~InternedKey() {
+        if (entry_ && entry_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            release(entry_);
+        }
+    }
+
+    /// Hash of a string as stored by the pool
+    static uint32_t hash(std::string_view str) noexcept {
+        auto const h = static_cast<uint64_t>(std::hash<std::string_view>()(str));
+        return static_cast<uint32_t>(h ^ (h >> 32));
+    }
+
+    uint32_t hash() const noexcept {
+        return entry_ ? entry_->hash : hash(std::string_view());
+    }
+
+    /// Null terminated string
+    char const* c_str() const noexcept {
+        return entry_ ? entry_->data() : "";
+    }
+    char const* data() const noexcept {
+        return c_str();
+    }
+    std::size_t size() const noexcept {
+        return entry_ ? entry_->size : 0;
+    }
+    bool empty() const noexcept {
+        return !entry_;
+    }
+
+    std::string_view view() const noexcept {
+        return std::string_view(c_str(), size());
+    }
+    operator std::string_view() const noexcept {
+        return view();
+    }
+    explicit operator std::string() const {
+        return std::string(view());
+    }
+
+    friend bool operator==(InternedKey const& lhs, InternedKey const& rhs) noexcept {
+        return lhs.entry_ == rhs.entry_;
+    }
+    friend bool operator!=(InternedKey const& lhs, InternedKey const& rhs) noexcept {
+        return lhs.entry_ != rhs.entry_;
+    }
+    template <class S, class = IfStringLike<S>>
+    friend bool operator==(InternedKey const& lhs, S const& rhs) noexcept {
+        return lhs.view() == std::string_view(rhs);
+    }
+    template <class S, class = IfStringLike<S>>
+    friend bool operator==(S const& lhs, InternedKey const& rhs) noexcept {
+        return std::string_view(lhs) == rhs.view();
+    }
+    template <class S, class = IfStringLike<S>>
+    friend bool operator!=(InternedKey const& lhs, S const& rhs) noexcept {
+        return lhs.view() != std::string_view(rhs);
+    }
+    template <class S, class = IfStringLike<S>>
+    friend bool operator!=(S const& lhs, InternedKey const& rhs) noexcept {
+        return std::string_view(lhs) != rhs.view();
+    }
+    friend bool operator<(InternedKey const& lhs, InternedKey const& rhs) noexcept {
+        return lhs.view() < rhs.view();
+    }
+
+    friend std::ostream& operator<<(std::ostream& os, InternedKey const& key);
+
+    static constexpr std::string_view typeName() noexcept {
+        return "string";
+    }
+
+    /// Number of distinct strings in the pool
+    static std::size_t poolSize();
+
+private:
+    struct Entry {
+        char const* data() const noexcept {
+            return reinterpret_cast<char const*>(this + 1);
+        }
+
+        std::atomic<std::size_t> refs;
+        uint32_t hash;
+        uint32_t size;
+    };
+
+    /// Remove `entry` from the pool and free it
+    static void release(Entry* entry) noexcept;
+
+    Entry* entry_{nullptr};
+};
+
+} // namespace yenxo
+
+namespace std {
+
+template <>
+struct hash<yenxo::InternedKey> {
+    size_t operator()(yenxo::InternedKey const& key) const noexcept {
+        return key.hash();
+    }
+};
+
+} // namespace std
@@ -0,0 +1,127 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#pragma once
+
+#include <yenxo/json_pointer.hpp>
+#include <yenxo/variant.hpp>
+#include <yenxo/variant_traits.hpp>
+
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace yenxo {
+
+/// RFC 6902 JSON Patch
+/// \ingroup group-datatypes
+///
+/// Converts to and from its JSON representation, an array of operation objects.
+struct JsonPatch {
+    enum class Op { add, remove, replace, move, copy, test };
+
+    struct Operation {
+        Op op;
+        JsonPointer path;
+        /// The source of `move` and `copy`
+        JsonPointer from;
+        /// The value of `add`, `replace` and `test`
+        Variant value;
+    };
+
+    std::vector<Operation> operations;
+
+    static std::string_view toString(Op op) noexcept;
+
+    /// \throw VariantErr with the path of the malformed operation
+    static JsonPatch fromVariant(Variant const& x);
+    static Variant toVariant(JsonPatch const& x);
+};
+
+/// RFC 7396 JSON Merge Patch
+/// \ingroup group-datatypes
+///
+/// A `Map` entry of the patch replaces the entry of the target, a null removes it and a
+/// `Map` is merged into the entry recursively. Any other patch replaces the whole target.
+/// A patch cannot set a value to null.
+struct MergePatch {
+    Variant value;
+
+    static MergePatch fromVariant(Variant const& x) {
+        return {x};
+    }
+
+    static Variant toVariant(MergePatch const& x) {
+        return x.value;
+    }
+};
+
+/// JSON Patch turning `from` into `to`
+/// \ingroup group-json
+///
+/// `Map`s are compared entry by entry and arrays element by element, any other change
+/// is a `replace`. The subtrees are compared by their structural hashes first, see
+/// `Variant::hash()`, so identical subtrees, and those shared between the trees, are
+/// skipped in O(1) once the hashes are cached.
+JsonPatch diff(Variant const& from, Variant const& to);
+
+/// Merge Patch turning `from` into `to`, see `diff()`
+/// \ingroup group-json
+///
+/// The entries of `to` which are null cannot be expressed, they are removed instead.
+MergePatch mergeDiff(Variant const& from, Variant const& to);
+
+/// Apply the operations of `patch` to `target` in order
+/// \ingroup group-json
+///
+/// The values of an rvalue `patch` are moved into `target`. The containers on the way
+/// are made unshared like by `Variant::modifyMap()`.
+/// \throw VariantErr with the path of the failed operation, `target` is left unchanged
+void apply(Variant& target, JsonPatch patch);
+
+/// Merge `patch` into `target`
+/// \ingroup group-json
+///
+/// The values of an rvalue `patch` are moved into `target`.
+void apply(Variant& target, MergePatch patch);
+
+/// Merge `patch` into a struct with `mergeVar` or `updateVar`
+/// \ingroup group-json
+///
+/// With `mergeVar`, see `trait::mergeVarImpl()`, a null resets a `std::optional` member
+/// as RFC 7396 removes it. With `updateVar` only, a null is converted like any other
+/// value.
+template <class T,
+          class = std::enable_if_t<!std::is_same_v<T, Variant>>,
+          class = decltype(std::declval<T&>().updateVar(std::declval<Variant const&>()))>
+void apply(T& target, MergePatch const& patch) {
+    if constexpr (trait::detail::hasMergeVar(boost::hana::type_c<T>)) {
+        target.mergeVar(patch.value);
+    } else {
+        target.updateVar(patch.value);
+    }
+}
+
+} // namespace yenxo
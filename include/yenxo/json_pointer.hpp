@@ -0,0 +1,122 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#pragma once
+
+#include <yenxo/interned_key.hpp>
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace yenxo {
+
+/// Parsed RFC 6901 JSON Pointer, e.g. `/servers/0/host`
+/// \ingroup group-datatypes
+///
+/// The string is split and unescaped once, each reference token is kept as an
+/// `InternedKey` along with its array index, so `Variant::at()` and `Variant::find()`
+/// resolve a pointer by comparing pointers and indices, without allocating.
+/// `VariantErr::path()` is a pointer of the same syntax.
+class JsonPointer {
+public:
+    /// Reference token
+    struct Token {
+        /// Not an array index
+        static constexpr std::size_t npos = static_cast<std::size_t>(-1);
+
+        /// Unescaped token, the key of a `Variant::Map`
+        InternedKey key;
+
+        /// Index into a `Variant::Vec` or `npos`
+        std::size_t index{npos};
+    };
+
+    using const_iterator = std::vector<Token>::const_iterator;
+
+    /// The pointer to the whole document
+    JsonPointer() = default;
+
+    /// \throw std::invalid_argument if `str` is not a JSON Pointer
+    explicit JsonPointer(std::string_view str);
+
+    const_iterator begin() const noexcept {
+        return tokens_.begin();
+    }
+    const_iterator end() const noexcept {
+        return tokens_.end();
+    }
+
+    std::size_t size() const noexcept {
+        return tokens_.size();
+    }
+    bool empty() const noexcept {
+        return tokens_.empty();
+    }
+
+    Token const& operator[](std::size_t i) const noexcept {
+        return tokens_[i];
+    }
+
+    Token const& back() const noexcept {
+        return tokens_.back();
+    }
+
+    /// Append a reference token, `token` is not escaped
+    ///
+    /// A key of a `Variant::Map` is appended without being interned again.
+    JsonPointer& push_back(InternedKey token);
+
+    /// Append an array index, the keys of the small ones are interned once
+    JsonPointer& push_back(std::size_t index);
+
+    void pop_back() noexcept {
+        tokens_.pop_back();
+    }
+
+    /// The pointer without the last token
+    /// \pre `!empty()`
+    JsonPointer parent() const {
+        JsonPointer ret;
+        ret.tokens_.assign(tokens_.begin(), tokens_.end() - 1);
+        return ret;
+    }
+
+    /// Is `*this` a prefix of `rhs` other than `rhs` itself
+    bool properPrefixOf(JsonPointer const& rhs) const noexcept;
+
+    /// The escaped string representation of the pointer
+    std::string toString() const;
+
+    friend bool operator==(JsonPointer const& lhs, JsonPointer const& rhs) noexcept;
+    friend bool operator!=(JsonPointer const& lhs, JsonPointer const& rhs) noexcept {
+        return !(lhs == rhs);
+    }
+
+private:
+    std::vector<Token> tokens_;
+};
+
+} // namespace yenxo
@@ -0,0 +1,98 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#pragma once
+
+#include <functional>
+#include <iosfwd>
+#include <string_view>
+#include <utility>
+
+namespace yenxo {
+
+/// Destination of the text written by `Variant::toJson(JsonSink&)`
+/// \ingroup group-json
+///
+/// The serializer stages the text in a fixed-size buffer and passes it on in chunks, so
+/// the memory used does not depend on the size of the document.
+class JsonSink {
+public:
+    virtual ~JsonSink() = default;
+
+    /// Consume the next `chunk` of the text
+    virtual void write(std::string_view chunk) = 0;
+};
+
+/// Writes the text to a `std::ostream`
+/// \ingroup group-json
+class OstreamSink final : public JsonSink {
+public:
+    explicit OstreamSink(std::ostream& os) noexcept
+            : os_(os) {
+    }
+
+    /// \throw std::ios_base::failure if the stream fails
+    void write(std::string_view chunk) override;
+
+private:
+    std::ostream& os_;
+};
+
+/// Writes the text to a POSIX file descriptor
+/// \ingroup group-json
+///
+/// The descriptor is not closed by the sink.
+class FdSink final : public JsonSink {
+public:
+    explicit FdSink(int fd) noexcept
+            : fd_(fd) {
+    }
+
+    /// Retries the interrupted and partial writes
+    /// \throw std::system_error on a write error
+    void write(std::string_view chunk) override;
+
+private:
+    int fd_;
+};
+
+/// Passes the chunks of the text to a user function
+/// \ingroup group-json
+///
+/// A chunk refers to the staging buffer, it is valid only during the call.
+class CallbackSink final : public JsonSink {
+public:
+    explicit CallbackSink(std::function<void(std::string_view)> callback)
+            : callback_(std::move(callback)) {
+    }
+
+    void write(std::string_view chunk) override {
+        callback_(chunk);
+    }
+
+private:
+    std::function<void(std::string_view)> callback_;
+};
+
+} // namespace yenxo
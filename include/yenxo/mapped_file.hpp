@@ -0,0 +1,74 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+namespace yenxo {
+
+/// Read-only memory mapping of a whole file
+/// \ingroup group-json
+///
+/// The pages are advised for sequential access and are read in by the kernel as the
+/// text is parsed, so a file needs no copy in the heap. The mapping can also back a
+/// tree: `Variant::fromJsonView(file.view())` keeps the long strings in the mapping,
+/// which must outlive the tree then, see `Variant::fromJsonView()`.
+class MappedFile {
+public:
+    /// \throw std::system_error if the file cannot be opened or mapped
+    explicit MappedFile(std::string path);
+
+    MappedFile(MappedFile&& rhs) noexcept;
+    MappedFile& operator=(MappedFile&& rhs) noexcept;
+    ~MappedFile();
+
+    std::string_view view() const noexcept {
+        return {data_, size_};
+    }
+
+    char const* data() const noexcept {
+        return data_;
+    }
+
+    std::size_t size() const noexcept {
+        return size_;
+    }
+
+    std::string const& path() const noexcept {
+        return path_;
+    }
+
+private:
+    void unmap() noexcept;
+
+    std::string path_;
+    char const* data_{nullptr};
+    std::size_t size_{0};
+};
+
+} // namespace yenxo
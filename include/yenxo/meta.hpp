@@ -25,6 +25,7 @@
 #pragma once
 
 #include <yenxo/config.hpp>
+#include <yenxo/interned_key.hpp>
 #include <yenxo/when.hpp>
 
 #if YENXO_ENABLE_TYPE_SAFE
@@ -235,19 +236,23 @@ constexpr auto isContainer(boost::hana::basic_type<T> const& x) {
 template <class T>
 using IsContainer = std::conjunction<IsIterable<T>, std::negation<IsString<T>>>;
 
-/// Test if `T` is a `std::pair` with `std::string` key
+/// Test if `T` is a `std::pair` with `std::string` or `InternedKey` key
 /// \ingroup group-meta
 template <typename T>
 constexpr auto isKeyValue(boost::hana::basic_type<T> const&) {
     if constexpr (isPair(boost::hana::type_c<T>)) {
-        return isString(boost::hana::type_c<typename T::first_type>);
+        return isString(boost::hana::type_c<typename T::first_type>)
+            || std::is_same_v<typename T::first_type, InternedKey>;
     } else {
         return false;
     }
 }
 
 template <class T>
-using IsKeyValue = std::conjunction<IsPair<T>, IsString<typename T::first_type>>;
+using IsKeyValue = std::conjunction<
+        IsPair<T>,
+        std::disjunction<IsString<typename T::first_type>,
+                         std::is_same<typename T::first_type, InternedKey>>>;
 
 /// Test if `type` is has `push_back` method
 /// \ingroup group-meta
@@ -262,6 +267,12 @@ inline constexpr auto hasEmplace = boost::hana::is_valid(
         [](auto x) -> decltype((void)boost::hana::traits::declval(x).emplace(
                            std::declval<typename decltype(x)::type::value_type>())) {});
 
+/// Test if `type` is has `reserve` method
+/// \ingroup group-meta
+inline constexpr auto hasReserve = boost::hana::is_valid(
+        [](auto x) -> decltype((void)boost::hana::traits::declval(x).reserve(
+                           std::size_t())) {});
+
 #if YENXO_ENABLE_TYPE_SAFE
 /// Tests if type is `type_safe::strong_typedef`
 /// \ingroup group-meta
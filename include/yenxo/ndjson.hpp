@@ -0,0 +1,286 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#pragma once
+
+#include <yenxo/exception.hpp>
+#include <yenxo/json_sink.hpp>
+#include <yenxo/variant.hpp>
+#include <yenxo/variant_conversion.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <iosfwd>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace yenxo {
+
+/// Order in which `readNdjson()` delivers the records
+/// \ingroup group-json
+enum class NdjsonOrder {
+    /// The order of the input
+    input,
+    /// The order in which the chunks of the input are parsed
+    completion
+};
+
+/// Parallelism of `readNdjson()` and `writeNdjson()`
+/// \ingroup group-json
+struct NdjsonOptions {
+    /// Number of workers, 0 for `std::thread::hardware_concurrency()`
+    std::size_t threads{0};
+    /// Bytes of input handed to a worker at once, cut at the next line end
+    std::size_t chunk_size{1 << 20};
+    /// Records serialized by a worker at once
+    std::size_t batch_size{1024};
+    NdjsonOrder order{NdjsonOrder::input};
+};
+
+namespace detail {
+
+/// Whole lines of an NDJSON input handed to a worker
+struct NdjsonChunk {
+    std::string_view text;
+    /// Number of the first line of `text`, counting from 1
+    std::size_t line{1};
+    /// Owns `text` when the input is a stream, reused by the next chunk of the slot
+    std::string buffer;
+};
+
+/// Cuts an NDJSON input into `NdjsonChunk`s on the calling thread
+class NdjsonSplitter {
+public:
+    NdjsonSplitter(std::string_view text, std::size_t chunk_size) noexcept
+            : text_(text)
+            , chunk_size_(std::max<std::size_t>(chunk_size, 1)) {
+    }
+
+    NdjsonSplitter(std::istream& is, std::size_t chunk_size) noexcept
+            : is_(&is)
+            , chunk_size_(std::max<std::size_t>(chunk_size, 1)) {
+    }
+
+    /// Fill `chunk` with the next lines, false at the end of the input
+    /// \throw std::ios_base::failure if the stream fails
+    bool next(NdjsonChunk& chunk);
+
+private:
+    std::string_view text_;
+    std::istream* is_{nullptr};
+    /// The incomplete last line read from `is_`
+    std::string carry_;
+    std::size_t chunk_size_;
+    std::size_t line_{1};
+};
+
+/// Work of `runNdjson()`, its slots hold the chunks in flight
+class NdjsonJob {
+public:
+    virtual ~NdjsonJob() = default;
+
+    /// Prepare the next chunk in `slot`, false when there is none, runs on the calling
+    /// thread
+    virtual bool next(std::size_t slot) = 0;
+    /// Process the chunk of `slot`, runs on a worker
+    virtual void run(std::size_t slot) = 0;
+    /// Pass the result of `slot` on, runs on the calling thread
+    virtual void deliver(std::size_t slot) = 0;
+};
+
+/// Number of slots a job needs, two chunks in flight per worker
+std::size_t ndjsonSlots(NdjsonOptions const& options) noexcept;
+
+/// Run `job` on a pool of workers, the first exception of a chunk or of a delivery is
+/// rethrown once the workers are stopped
+void runNdjson(NdjsonJob& job, NdjsonOptions const& options);
+
+/// Call `f(line, number)` for the non-blank lines of `chunk`, "\r\n" ends a line too
+template <class F>
+void forEachLine(NdjsonChunk const& chunk, F&& f) {
+    auto text = chunk.text;
+    for (auto number = chunk.line; !text.empty(); ++number) {
+        auto const end = std::min(text.find('\n'), text.size());
+        auto line = text.substr(0, end);
+        text.remove_prefix(std::min(end + 1, text.size()));
+        if (!line.empty() && line.back() == '\r') {
+            line.remove_suffix(1);
+        }
+        if (line.find_first_not_of(" \t") != std::string_view::npos) {
+            f(line, number);
+        }
+    }
+}
+
+template <class T, class F>
+class NdjsonReader final : public NdjsonJob {
+public:
+    NdjsonReader(NdjsonSplitter splitter, F& f, NdjsonOptions const& options)
+            : splitter_(std::move(splitter))
+            , f_(f)
+            , slots_(ndjsonSlots(options)) {
+    }
+
+    bool next(std::size_t slot) override {
+        return splitter_.next(slots_[slot].chunk);
+    }
+
+    void run(std::size_t slot) override {
+        auto& x = slots_[slot];
+        x.records.clear();
+        forEachLine(x.chunk, [&](std::string_view line, std::size_t number) {
+            try {
+                if constexpr (std::is_same_v<T, Variant>) {
+                    x.records.push_back(Variant::fromJson(line));
+                } else {
+                    x.records.push_back(fromVariant<T>(Variant::fromJson(line)));
+                }
+            } catch (VariantErr& e) {
+                e.prependPath(std::to_string(number));
+                throw;
+            } catch (std::exception const& e) {
+                throw std::runtime_error("line " + std::to_string(number) + ": "
+                                         + e.what());
+            }
+        });
+    }
+
+    void deliver(std::size_t slot) override {
+        for (auto& x : slots_[slot].records) {
+            f_(std::move(x));
+        }
+    }
+
+private:
+    struct Slot {
+        NdjsonChunk chunk;
+        std::vector<T> records;
+    };
+
+    NdjsonSplitter splitter_;
+    F& f_;
+    std::vector<Slot> slots_;
+};
+
+template <class T>
+class NdjsonWriter final : public NdjsonJob {
+public:
+    NdjsonWriter(std::vector<T> const& records,
+                 JsonSink& sink,
+                 NdjsonOptions const& options)
+            : records_(records)
+            , sink_(sink)
+            , batch_(std::max<std::size_t>(options.batch_size, 1))
+            , slots_(ndjsonSlots(options)) {
+    }
+
+    bool next(std::size_t slot) override {
+        if (begin_ == records_.size()) {
+            return false;
+        }
+        auto const end = begin_ + std::min(batch_, records_.size() - begin_);
+        slots_[slot].range = {begin_, end};
+        begin_ = end;
+        return true;
+    }
+
+    void run(std::size_t slot) override {
+        auto& x = slots_[slot];
+        x.text.clear();
+        for (auto i = x.range.first; i < x.range.second; ++i) {
+            if constexpr (std::is_same_v<T, Variant>) {
+                records_[i].appendJson(x.text);
+            } else {
+                toVariant(records_[i]).appendJson(x.text);
+            }
+            x.text += '\n';
+        }
+    }
+
+    void deliver(std::size_t slot) override {
+        sink_.write(slots_[slot].text);
+    }
+
+private:
+    struct Slot {
+        std::pair<std::size_t, std::size_t> range;
+        /// Reused by the batches of the slot
+        std::string text;
+    };
+
+    std::vector<T> const& records_;
+    JsonSink& sink_;
+    std::size_t batch_;
+    std::size_t begin_{0};
+    std::vector<Slot> slots_;
+};
+
+} // namespace detail
+
+/// Parse the newline-delimited JSON `text` in parallel and call `f(T&&)` for each record
+/// \ingroup group-json
+///
+/// The input is cut into chunks of whole lines which the workers parse, and convert by
+/// `fromVariant<T>` unless `T` is `Variant`. `f` runs on the calling thread in the order
+/// of `options.order`. Blank lines are skipped.
+/// \throw std::runtime_error naming the line of the first malformed record
+/// \throw VariantErr of the first failed conversion, its path starts with the line
+template <class T = Variant, class F>
+void readNdjson(std::string_view text, F&& f, NdjsonOptions const& options = {}) {
+    detail::NdjsonReader<T, F> job({text, options.chunk_size}, f, options);
+    detail::runNdjson(job, options);
+}
+
+/// Read newline-delimited JSON from `is`, see `readNdjson(std::string_view)`
+/// \ingroup group-json
+///
+/// The chunks are read on the calling thread while the workers parse the previous ones.
+/// \throw std::ios_base::failure if the stream fails
+template <class T = Variant, class F>
+void readNdjson(std::istream& is, F&& f, NdjsonOptions const& options = {}) {
+    detail::NdjsonReader<T, F> job({is, options.chunk_size}, f, options);
+    detail::runNdjson(job, options);
+}
+
+/// Write `records` as newline-delimited JSON to `sink`
+/// \ingroup group-json
+///
+/// The workers serialize batches of `options.batch_size` records into buffers reused
+/// from batch to batch, the calling thread writes them to `sink` in order.
+template <class T>
+void writeNdjson(std::vector<T> const& records,
+                 JsonSink& sink,
+                 NdjsonOptions const& options = {}) {
+    detail::NdjsonWriter<T> job(records, sink, options);
+    auto ordered = options;
+    ordered.order = NdjsonOrder::input;
+    detail::runNdjson(job, ordered);
+}
+
+} // namespace yenxo
@@ -24,27 +24,13 @@
 
 #pragma once
 
-#include <yenxo/meta.hpp>
-#include <yenxo/type_name.hpp>
-#include <yenxo/variant_conversion.hpp>
+#include <yenxo/format.hpp>
 
 #include <boost/hana.hpp>
 
-#include <iomanip>
 #include <ostream>
 
 namespace yenxo {
-namespace detail {
-
-/// \ingroup group-details
-/// Is `std::ostream& operator<<(std::ostream&, T)` defined.
-inline constexpr auto const hasOStreamOperator = boost::hana::is_valid(
-        [](auto t) -> decltype(operator<<(std::declval<std::ostream>(),
-                                          std::declval<typename decltype(t)::type>())) {
-        });
-
-} // namespace detail
-
 
 #ifdef YENXO_DOXYGEN_INVOKED
 inline auto oStream = [](std::ostream& os, T const& val) { return return os << val; };
@@ -67,80 +53,11 @@ struct OStreamImpl<T, When<condition>> {
 };
 
 template <class T>
-struct OStreamImpl<T,
-                   When<!detail::hasOStreamOperator(boost::hana::type_c<T>)
-                        && isOptional(boost::hana::type_c<T>)>> {
-    static void apply(std::ostream& os, T const& val) {
-        if (val.has_value()) {
-            oStream(os, *val);
-        } else {
-            os << "None";
-        }
-    }
-};
-
-template <class T>
-struct OStreamImpl<T,
-                   When<!detail::hasOStreamOperator(boost::hana::type_c<T>)
-                        && isContainer(boost::hana::type_c<T>)
-                        && isPair(boost::hana::type_c<typename T::value_type>)>> {
-    static void apply(std::ostream& os, T const& val) {
-        auto const s = size(val);
-        std::size_t i = 0;
-        os << "{ ";
-        for (auto const& x : val) {
-            oStream(os, x);
-            os << ((i++ == s - 1) ? ";" : "; ");
-        }
-        os << " }";
-    }
-};
-
-template <class T>
-struct OStreamImpl<T,
-                   When<!detail::hasOStreamOperator(boost::hana::type_c<T>)
-                        && isContainer(boost::hana::type_c<T>)
-                        && !isPair(boost::hana::type_c<typename T::value_type>)>> {
-    static void apply(std::ostream& os, T const& val) {
-        auto const s = size(val);
-        std::size_t i = 0;
-        os << "[";
-        for (auto const& x : val) {
-            oStream(os, x);
-            os << ((i++ == s - 1) ? "" : ", ");
-        }
-        os << "]";
-    }
-};
-
-template <class T>
-struct OStreamImpl<T,
-                   When<!detail::hasOStreamOperator(boost::hana::type_c<T>)
-                        && isPair(boost::hana::type_c<T>)>> {
-    static void apply(std::ostream& os, T const& val) {
-        oStream(os, val.first);
-        os << ": ";
-        oStream(os, val.second);
-    }
-};
-
-#if YENXO_ENABLE_TYPE_SAFE
-template <class T>
-struct OStreamImpl<T,
-                   When<!detail::hasOStreamOperator(boost::hana::type_c<T>)
-                        && strongTypeDef(boost::hana::type_c<T>)>> {
-    static void apply(std::ostream& os, T const& val) {
-        oStream(os, static_cast<type_safe::underlying_type<decltype(val)>>(val));
-    }
-};
-#endif
-
-template <class T>
-struct OStreamImpl<T,
-                   When<!detail::hasOStreamOperator(boost::hana::type_c<T>)
-                        && isStdVariant(boost::hana::type_c<T>)>> {
+struct OStreamImpl<T, When<!detail::hasOStreamOperator(boost::hana::type_c<T>)>> {
     static void apply(std::ostream& os, T const& val) {
-        std::visit([&os](auto const& x) { oStream(os, x); }, val);
+        Buffer buf(os);
+        format(buf, val);
+        os << buf.view();
     }
 };
 
@@ -160,13 +77,9 @@ void OStreamT::operator()(std::ostream& os, T const& val) const {
 /// \pre `T` should be a Boost.Hana.Struct.
 template <class T>
 void ostreamImpl(std::ostream& os, T const& x) {
-    os << typeName(boost::hana::type_c<T>) << " { ";
-    boost::hana::for_each(x, boost::hana::fuse([&](auto name, auto value) {
-                              os << boost::hana::to<char const*>(name) << ": ";
-                              oStream(os, value);
-                              os << "; ";
-                          }));
-    os << "}";
+    Buffer buf(os);
+    formatImpl(buf, x);
+    os << buf.view();
 }
 
 namespace trait {
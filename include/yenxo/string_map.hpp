@@ -0,0 +1,443 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#pragma once
+
+#include <yenxo/config.hpp>
+#include <yenxo/interned_key.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <initializer_list>
+#include <memory_resource>
+#include <stdexcept>
+#include <string_view>
+#include <tuple>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace yenxo {
+
+/// Flat string keyed associative container used as `Variant::Map`
+/// \ingroup group-datatypes
+///
+/// Entries are kept contiguously in insertion order. Maps with up to
+/// `YENXO_MAP_LINEAR_LIMIT` entries are searched by a linear scan over 32-bit key
+/// hashes, bigger maps additionally maintain an open addressing index. Keys are
+/// `InternedKey`s, lookup accepts them as well as anything convertible to
+/// `std::string_view`. Looking up an `InternedKey` neither hashes nor compares the
+/// characters.
+///
+/// Unlike `std::unordered_map`, any insertion, including the ones of `operator[]` and
+/// `try_emplace()`, may invalidate all the iterators and references to the entries like
+/// `std::vector::push_back()` does. Erasing invalidates the ones at and after the
+/// erased entry and costs linear time, the following entries are moved.
+template <class T>
+class StringMap {
+public:
+    using key_type = InternedKey;
+    using mapped_type = T;
+    using value_type = std::pair<InternedKey, T>;
+    using size_type = std::size_t;
+    using difference_type = std::ptrdiff_t;
+    using reference = value_type&;
+    using const_reference = value_type const&;
+    using pointer = value_type*;
+    using const_pointer = value_type const*;
+    using allocator_type = std::pmr::polymorphic_allocator<value_type>;
+
+private:
+    using Entries = std::vector<value_type, allocator_type>;
+    using Hashes = std::vector<uint32_t, std::pmr::polymorphic_allocator<uint32_t>>;
+
+    /// Enables a member template for the keys other than `key_type`
+    template <class K>
+    using IfStringLike =
+            std::enable_if_t<std::is_convertible_v<K const&, std::string_view>
+                             && !std::is_same_v<K, key_type>>;
+
+public:
+    using iterator = typename Entries::iterator;
+    using const_iterator = typename Entries::const_iterator;
+
+    StringMap() = default;
+
+    explicit StringMap(allocator_type const& alloc)
+            : entries_(alloc)
+            , hashes_(alloc)
+            , index_(alloc) {
+    }
+
+    StringMap(std::initializer_list<value_type> init,
+              allocator_type const& alloc = allocator_type())
+            : StringMap(init.begin(), init.end(), alloc) {
+    }
+
+    template <class InputIt>
+    StringMap(InputIt first, InputIt last, allocator_type const& alloc = allocator_type())
+            : StringMap(alloc) {
+        for (; first != last; ++first) {
+            emplace(*first);
+        }
+    }
+
+    StringMap(StringMap const&) = default;
+    StringMap(StringMap&&) noexcept = default;
+    StringMap& operator=(StringMap const&) = default;
+    StringMap& operator=(StringMap&&) = default;
+
+    StringMap(StringMap const& rhs, allocator_type const& alloc)
+            : entries_(rhs.entries_, alloc)
+            , hashes_(rhs.hashes_, alloc)
+            , index_(rhs.index_, alloc) {
+    }
+
+    StringMap& operator=(std::initializer_list<value_type> init) {
+        clear();
+        for (auto const& x : init) {
+            emplace(x);
+        }
+        return *this;
+    }
+
+    allocator_type get_allocator() const noexcept {
+        return entries_.get_allocator();
+    }
+
+    iterator begin() noexcept {
+        return entries_.begin();
+    }
+    const_iterator begin() const noexcept {
+        return entries_.begin();
+    }
+    const_iterator cbegin() const noexcept {
+        return entries_.cbegin();
+    }
+    iterator end() noexcept {
+        return entries_.end();
+    }
+    const_iterator end() const noexcept {
+        return entries_.end();
+    }
+    const_iterator cend() const noexcept {
+        return entries_.cend();
+    }
+
+    // found by the unqualified `begin`/`end` of `isIterable`
+    friend iterator begin(StringMap& x) noexcept {
+        return x.begin();
+    }
+    friend const_iterator begin(StringMap const& x) noexcept {
+        return x.begin();
+    }
+    friend iterator end(StringMap& x) noexcept {
+        return x.end();
+    }
+    friend const_iterator end(StringMap const& x) noexcept {
+        return x.end();
+    }
+
+    bool empty() const noexcept {
+        return entries_.empty();
+    }
+    size_type size() const noexcept {
+        return entries_.size();
+    }
+    size_type capacity() const noexcept {
+        return entries_.capacity();
+    }
+
+    /// Number of slots of the hash index, 0 while the map is searched linearly
+    size_type bucket_count() const noexcept {
+        return index_.size();
+    }
+
+    void clear() noexcept {
+        entries_.clear();
+        hashes_.clear();
+        index_.clear();
+    }
+
+    void reserve(size_type n) {
+        entries_.reserve(n);
+        hashes_.reserve(n);
+        if (n > linear_limit) {
+            rehash(n);
+        }
+    }
+
+    iterator find(key_type const& key) noexcept {
+        return begin() + static_cast<difference_type>(position(key, key.hash()));
+    }
+    const_iterator find(key_type const& key) const noexcept {
+        return begin() + static_cast<difference_type>(position(key, key.hash()));
+    }
+    template <class K, class = IfStringLike<K>>
+    iterator find(K const& key) noexcept {
+        std::string_view const view = key;
+        return begin() + static_cast<difference_type>(position(view, hash(view)));
+    }
+    template <class K, class = IfStringLike<K>>
+    const_iterator find(K const& key) const noexcept {
+        std::string_view const view = key;
+        return begin() + static_cast<difference_type>(position(view, hash(view)));
+    }
+
+    template <class K>
+    size_type count(K const& key) const noexcept {
+        return find(key) == end() ? 0 : 1;
+    }
+
+    /// \throw std::out_of_range if the key is absent
+    template <class K>
+    T& at(K const& key) {
+        auto const it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("StringMap::at");
+        }
+        return it->second;
+    }
+    template <class K>
+    T const& at(K const& key) const {
+        auto const it = find(key);
+        if (it == end()) {
+            throw std::out_of_range("StringMap::at");
+        }
+        return it->second;
+    }
+
+    T& operator[](key_type const& key) {
+        return try_emplace(key).first->second;
+    }
+    T& operator[](key_type&& key) {
+        return try_emplace(std::move(key)).first->second;
+    }
+    template <class K, class = IfStringLike<K>>
+    T& operator[](K const& key) {
+        return try_emplace(key).first->second;
+    }
+
+    template <class... Args>
+    std::pair<iterator, bool> try_emplace(key_type const& key, Args&&... args) {
+        return tryEmplace(key, key.hash(), key, std::forward<Args>(args)...);
+    }
+    template <class... Args>
+    std::pair<iterator, bool> try_emplace(key_type&& key, Args&&... args) {
+        auto const h = key.hash();
+        return tryEmplace(key, h, std::move(key), std::forward<Args>(args)...);
+    }
+    /// The key enters the pool only if it is absent from the map
+    template <class K, class... Args, class = IfStringLike<K>>
+    std::pair<iterator, bool> try_emplace(K const& key, Args&&... args) {
+        std::string_view const view = key;
+        return tryEmplace(view, hash(view), view, std::forward<Args>(args)...);
+    }
+
+    template <class... Args>
+    std::pair<iterator, bool> emplace(Args&&... args) {
+        value_type x(std::forward<Args>(args)...);
+        auto const h = x.first.hash();
+        auto const i = position(x.first, h);
+        if (i != size()) {
+            return {begin() + static_cast<difference_type>(i), false};
+        }
+        return {append(h, std::move(x)), true};
+    }
+
+    std::pair<iterator, bool> insert(value_type const& x) {
+        return try_emplace(x.first, x.second);
+    }
+    std::pair<iterator, bool> insert(value_type&& x) {
+        return try_emplace(std::move(x.first), std::move(x.second));
+    }
+
+    template <class K, class M>
+    std::pair<iterator, bool> insert_or_assign(K const& key, M&& x) {
+        auto ret = try_emplace(key, std::forward<M>(x));
+        if (!ret.second) {
+            ret.first->second = std::forward<M>(x);
+        }
+        return ret;
+    }
+
+    iterator erase(const_iterator pos) {
+        auto const i = static_cast<size_type>(pos - cbegin());
+        if (size() - 1 <= linear_limit) {
+            index_.clear();
+        } else {
+            eraseIndex(i);
+        }
+        hashes_.erase(hashes_.begin() + static_cast<difference_type>(i));
+        return entries_.erase(pos);
+    }
+
+    template <class K, class = std::enable_if_t<!std::is_convertible_v<K, const_iterator>>>
+    size_type erase(K const& key) {
+        auto const it = find(key);
+        if (it == end()) {
+            return 0;
+        }
+        erase(it);
+        return 1;
+    }
+
+    /// Compares with `rhs` without allocating: each key of `*this` is looked up in `rhs`,
+    /// a key found at the same position skips the lookup
+    /// \return true if both have the same keys and `pred(value, rhs_value)` holds for each
+    template <class BinaryPredicate>
+    bool equal(StringMap const& rhs, BinaryPredicate pred) const {
+        if (size() != rhs.size()) {
+            return false;
+        }
+        for (size_type i = 0; i < size(); ++i) {
+            auto const& [key, value] = entries_[i];
+            auto const j = hashes_[i] == rhs.hashes_[i] && key == rhs.entries_[i].first
+                                 ? i
+                                 : rhs.position(key, hashes_[i]);
+            if (j == rhs.size() || !pred(value, rhs.entries_[j].second)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /// Equal if both have the same keys mapped to equal values, the order is ignored
+    friend bool operator==(StringMap const& lhs, StringMap const& rhs) {
+        return lhs.equal(rhs, [](T const& lhs, T const& rhs) { return lhs == rhs; });
+    }
+
+    friend bool operator!=(StringMap const& lhs, StringMap const& rhs) {
+        return !(lhs == rhs);
+    }
+
+private:
+    static constexpr size_type linear_limit = YENXO_MAP_LINEAR_LIMIT;
+
+    static uint32_t hash(std::string_view key) noexcept {
+        return InternedKey::hash(key);
+    }
+
+    /// \return position of `key` or `size()`
+    template <class K>
+    size_type position(K const& key, uint32_t h) const noexcept {
+        if (index_.empty()) {
+            for (size_type i = 0; i < hashes_.size(); ++i) {
+                if (hashes_[i] == h && entries_[i].first == key) {
+                    return i;
+                }
+            }
+            return size();
+        }
+        auto const mask = index_.size() - 1;
+        for (auto slot = h & mask;; slot = (slot + 1) & mask) {
+            auto const x = index_[slot];
+            if (x == 0) {
+                return size();
+            }
+            if (hashes_[x - 1] == h && entries_[x - 1].first == key) {
+                return x - 1;
+            }
+        }
+    }
+
+    template <class Q, class K, class... Args>
+    std::pair<iterator, bool> tryEmplace(Q const& query, uint32_t h, K&& key, Args&&... args) {
+        auto const i = position(query, h);
+        if (i != size()) {
+            return {begin() + static_cast<difference_type>(i), false};
+        }
+        return {append(h,
+                       value_type(std::piecewise_construct,
+                                  std::forward_as_tuple(std::forward<K>(key)),
+                                  std::forward_as_tuple(std::forward<Args>(args)...))),
+                true};
+    }
+
+    iterator append(uint32_t h, value_type&& x) {
+        hashes_.reserve(hashes_.size() + 1);
+        entries_.push_back(std::move(x));
+        hashes_.push_back(h);
+        // `reserve()` may have built the index ahead
+        if (!index_.empty() || size() > linear_limit) {
+            if (index_.size() < 2 * size()) {
+                rehash(size());
+            } else {
+                insertIndex(size() - 1);
+            }
+        }
+        return end() - 1;
+    }
+
+    void rehash(size_type n) {
+        size_type capacity = 2 * linear_limit;
+        while (capacity < 2 * n) {
+            capacity *= 2;
+        }
+        index_.assign(std::max(capacity, index_.size()), 0);
+        for (size_type i = 0; i < size(); ++i) {
+            insertIndex(i);
+        }
+    }
+
+    void insertIndex(size_type i) noexcept {
+        auto const mask = index_.size() - 1;
+        auto slot = hashes_[i] & mask;
+        while (index_[slot] != 0) {
+            slot = (slot + 1) & mask;
+        }
+        index_[slot] = static_cast<uint32_t>(i + 1);
+    }
+
+    /// Remove the entry `i` from the index, the entries after it move down by one
+    void eraseIndex(size_type i) noexcept {
+        auto const mask = index_.size() - 1;
+        auto const x = static_cast<uint32_t>(i + 1);
+        auto hole = hashes_[i] & mask;
+        while (index_[hole] != x) {
+            hole = (hole + 1) & mask;
+        }
+        // backward shift: pull up the following entries of the probe run which may not
+        // be found past the hole
+        for (auto slot = (hole + 1) & mask; index_[slot] != 0; slot = (slot + 1) & mask) {
+            auto const home = hashes_[index_[slot] - 1] & mask;
+            if (((slot - home) & mask) >= ((slot - hole) & mask)) {
+                index_[hole] = index_[slot];
+                hole = slot;
+            }
+        }
+        index_[hole] = 0;
+        if (i + 1 != size()) {
+            for (auto& y : index_) {
+                y -= y > x;
+            }
+        }
+    }
+
+    Entries entries_;
+    Hashes hashes_;
+    Hashes index_;
+};
+
+} // namespace yenxo
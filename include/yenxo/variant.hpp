@@ -26,6 +26,7 @@
 
 #include <yenxo/enum_traits.hpp>
 #include <yenxo/meta.hpp>
+#include <yenxo/string_map.hpp>
 
 #include <rapidjson/fwd.h>
 
@@ -33,13 +34,33 @@
 #include <string>
 #include <string_view>
 #include <type_traits>
-#include <unordered_map>
 #include <vector>
 
 namespace yenxo {
 
+class FrozenVariant;
+class JsonPointer;
+class JsonSink;
+class VariantArena;
+struct VariantStats;
+
 /// Serialized object representation. Think of it as a DOM object.
 /// \ingroup group-datatypes
+///
+/// Copies share the heap allocated strings, `Vec`s and `Map`s of the original through
+/// an atomic reference count, so copying a tree costs O(1). `modifyVec()` and
+/// `modifyMap()` copy a shared container before returning it, the elements of the copy
+/// stay shared. Distinct copies of a tree can be used from different threads.
+///
+/// An array of numbers or booleans can be stored packed, as an `Int64Vec`, `Uint64Vec`,
+/// `DoubleVec` or `BoolVec`. `fromJson()` and `toVariant()` pack the homogeneous arrays
+/// of at least `YENXO_PACKED_MIN_SIZE` elements of one type. A packed array is a `vec`
+/// for `type()`, `packedType()` tells `int64_vec`, `uint64_vec`, `double_vec` or
+/// `bool_vec` apart. `vec()` of a packed array unpacks it once into elements of that
+/// type and frees the packed values unless `int64Vec()`, `uint64Vec()`, `doubleVec()`
+/// or `boolVec()` handed them out, `modifyVec()` turns it into a plain `vec`. A packed
+/// array and a `vec` with the same elements are equal by `operator==` and have the same
+/// `hash()`.
 class Variant {
 public:
     struct NullType {
@@ -57,9 +78,18 @@ public:
         bool _fake; // to suppress false warnings
     };
 
-    using Map = std::unordered_map<std::string, Variant>;
+    /// Breaking change: unlike the former `std::unordered_map`, inserting into a `Map`,
+    /// including by `operator[]`, may invalidate the references to all its entries.
+    /// Keeping `&map["a"]` across `map["b"] = x` is a use after free, look the entry up
+    /// again after the insertion instead. See `StringMap`.
+    using Map = StringMap<Variant>;
     using Vec = std::vector<Variant>;
 
+    using Int64Vec = std::vector<int64_t>;
+    using Uint64Vec = std::vector<uint64_t>;
+    using DoubleVec = std::vector<double>;
+    using BoolVec = std::vector<bool>;
+
     enum class TypeTag : uint8_t {
         null,
         boolean,
@@ -75,7 +105,11 @@ public:
         double_,
         string,
         vec,
-        map
+        map,
+        int64_vec,
+        uint64_vec,
+        double_vec,
+        bool_vec
     };
 
     ~Variant() noexcept;
@@ -106,6 +140,19 @@ public:
     Variant(Map const&);
     Variant(Map&&);
 
+    Variant(Int64Vec const&);
+    Variant(Int64Vec&&);
+    Variant(Uint64Vec const&);
+    Variant(Uint64Vec&&);
+    Variant(DoubleVec const&);
+    Variant(DoubleVec&&);
+    Variant(BoolVec const&);
+    Variant(BoolVec&&);
+    /// Packed integers given back by `vec()` as `element`s
+    ///
+    /// \pre `element` is an integer type holding every value.
+    Variant(Int64Vec values, TypeTag element);
+
     template <typename T, typename = decltype(T::toVariant(std::declval<T>()))>
     explicit Variant(T const& x)
             : Variant(T::toVariant(x)) {
@@ -253,47 +300,129 @@ public:
     /// \throw VariantBadType
     double floatingOr(double x) const;
 
-    /// Get string
+    /// Get a copy of the string
+    ///
+    /// Short strings and the ones built in an arena or by `fromJsonView()` are not
+    /// stored in a `std::string`, so there is none to refer to.
     /// \throw VariantEmpty, VariantBadType
-    std::string const& str() const;
-    explicit operator std::string const &() const {
-        return str();
+    [[deprecated("Use strView().")]] std::string str() const;
+
+    /// Get string as a view valid as long as the object is alive and not modified
+    /// \throw VariantEmpty, VariantBadType
+    std::string_view strView() const;
+    explicit operator std::string_view() const {
+        return strView();
+    }
+    explicit operator std::string() const {
+        return std::string(strView());
     }
 
     /// Get string or `x` if the object is null
     /// \throw VariantBadType
     std::string strOr(std::string const& x) const;
 
-    /// Get Vec
+    /// Get Vec, a packed array is unpacked on the first call
     /// \throw VariantEmpty, VariantBadType
     Vec const& vec() const;
     explicit operator Vec const &() const {
         return vec();
     }
+
+    /// Get Vec for modification, a Vec shared with copies is copied first
+    ///
+    /// A packed array is turned into a plain `vec`. The reference must not be used after
+    /// `*this` is copied or hashed.
+    /// \throw VariantEmpty, VariantBadType
     Vec& modifyVec();
 
     /// Get Vec or `x` if the object is null
     /// \throw VariantBadType, VariantIntegralOverflow
     Vec vecOr(Vec const& x) const;
 
+    /// Get the packed array
+    ///
+    /// The values stay along with the `Vec` of a later `vec()`. Once `vec()` freed them,
+    /// `packedType()` is `vec` and the getters throw.
+    /// \throw VariantEmpty, VariantBadType
+    Int64Vec const& int64Vec() const;
+    Uint64Vec const& uint64Vec() const;
+    DoubleVec const& doubleVec() const;
+    BoolVec const& boolVec() const;
+
+    /// Get the elements of a `vec` or a packed array converted to `T`
+    ///
+    /// `T` is an arithmetic type of `Types`, the elements are converted like by the
+    /// getter of `T`, e.g. `int32()`. A packed array is read without being unpacked.
+    /// \throw VariantEmpty, VariantBadType, VariantIntegralOverflow
+    template <typename T>
+    std::vector<T> vecAs() const;
+
     /// Get Map
     /// \throw VariantEmpty, VariantBadType
     Map const& map() const;
     explicit operator Map const &() const {
         return map();
     }
+
+    /// Get Map for modification, a Map shared with copies is copied first
+    ///
+    /// The reference must not be used after `*this` is copied or hashed.
+    /// \throw VariantEmpty, VariantBadType
     Map& modifyMap();
 
     /// Get Map or `x` if the object is null
     /// \throw VariantBadType, VariantIntegralOverflow
     Map mapOr(Map const& x) const;
 
+    /// Get the value at `pointer`, see `JsonPointer`
+    ///
+    /// A packed array on the way is unpacked like by `vec()`.
+    /// \throw VariantErr with the path of the first missing value
+    Variant const& at(JsonPointer const& pointer) const;
+
+    /// Get the value at `pointer` for modification
+    ///
+    /// The containers on the way are made unshared like by `modifyMap()` and
+    /// `modifyVec()`, the reference must not be used after `*this` is copied or hashed.
+    /// \throw VariantErr with the path of the first missing value
+    Variant& at(JsonPointer const& pointer);
+
+    /// Get the value at `pointer` or `nullptr`
+    Variant const* find(JsonPointer const& pointer) const;
+
+    /// Get the value at `pointer` for modification or `nullptr`, see `at()`
+    ///
+    /// Nothing is made unshared if there is no such value.
+    Variant* find(JsonPointer const& pointer);
+
+    /// Copy the tree into an immutable single block document, see `FrozenVariant`
+    FrozenVariant freeze() const;
+
+    /// Make the strings borrowed from a `fromJsonView()` buffer owned by the tree
+    ///
+    /// A `Vec` or `Map` shared with copies is copied first.
+    void materialize();
+
     /// Check if Variant contains null
     bool null() const noexcept;
 
+    /// Check if two `Variant`s are identical or structurally equal
+    ///
+    /// Copies sharing a `Vec`, `Map` or packed array are equal without visiting it, even
+    /// when it holds a NaN: `v == Variant(v)` is true for a container with a NaN element,
+    /// while `Variant(NAN) == Variant(NAN)` and two separately built trees with a NaN are
+    /// not equal. The containers whose cached hashes differ are rejected without visiting
+    /// them.
     bool operator==(Variant const& rhs) const noexcept;
     bool operator!=(Variant const& rhs) const noexcept;
 
+    /// Structural hash, equal for the objects equal by `operator==`
+    ///
+    /// The order of `Map` entries does not matter. The hashes of containers and packed
+    /// arrays are cached in their payloads, so hashing a tree again, or a copy of it,
+    /// costs O(1). `modifyVec()` and `modifyMap()` reset the cache.
+    std::size_t hash() const noexcept;
+
     /// Check if two `Variant`s are equal
     ///
     /// Unlike `operator==` this function performs conversion of arithmetic types.
@@ -303,21 +432,119 @@ public:
     /// @{
     static Variant from(rapidjson::Value const& json);
 
+    /// Build the tree inside `arena`, see `VariantArena`
+    static Variant from(rapidjson::Value const& json, VariantArena& arena);
+
     /// \throw std::runtime_error on `json` parse
     static Variant fromJson(std::string const& json);
 
+    /// Parse the tree into `arena`, see `VariantArena`
+    /// \throw std::runtime_error on `json` parse
+    static Variant fromJson(std::string const& json, VariantArena& arena);
+
+    /// Parse `json` in place, the strings are decoded over its buffer and copied once
+    /// into the tree
+    /// \throw std::runtime_error on `json` parse
+    static Variant fromJson(std::string&& json);
+
+    /// Parse the tree into `arena`, see `VariantArena`
+    /// \throw std::runtime_error on `json` parse
+    static Variant fromJson(std::string&& json, VariantArena& arena);
+
+    /// Parse `json` which needs no terminating NUL, so no copy into a `std::string`
+    /// \throw std::runtime_error on `json` parse
+    static Variant fromJson(std::string_view json);
+
+    /// Parse the tree into `arena`, see `VariantArena`
+    /// \throw std::runtime_error on `json` parse
+    static Variant fromJson(std::string_view json, VariantArena& arena);
+
+    /// Parse the NUL terminated `json`
+    /// \throw std::runtime_error on `json` parse
+    static Variant fromJson(char const* json);
+
+    /// Parse the tree into `arena`, see `VariantArena`
+    /// \throw std::runtime_error on `json` parse
+    static Variant fromJson(char const* json, VariantArena& arena);
+
+    /// Parse the `len` characters of `buf` in place into a tree whose strings refer to
+    /// `buf`
+    ///
+    /// The strings are decoded over `buf`, so unlike `fromJsonView()` the ones containing
+    /// escapes are borrowed too, short strings and the `Map` keys are still owned. `buf`
+    /// is garbage once parsed and must stay alive and unmodified as long as the tree or
+    /// any copy of it is used, `materialize()` ends the dependency. `buf` needs no
+    /// terminating NUL.
+    /// \throw std::runtime_error on `json` parse
+    static Variant fromJsonInsitu(char* buf, std::size_t len);
+
+    /// Parse the tree into `arena`, see `VariantArena`, the strings borrow from `buf`
+    /// \throw std::runtime_error on `json` parse
+    static Variant fromJsonInsitu(char* buf, std::size_t len, VariantArena& arena);
+
+    /// Parse the file at `path` straight from its memory mapping, see `MappedFile`
+    ///
+    /// The strings are copied into the tree and the file is unmapped on return.
+    /// \throw std::system_error if the file cannot be read
+    /// \throw std::runtime_error on parse, naming the line, the column and the offset
+    static Variant fromJsonFile(std::string const& path);
+
+    /// Parse the tree into `arena`, see `VariantArena`
+    /// \throw std::system_error if the file cannot be read
+    /// \throw std::runtime_error on parse, naming the line, the column and the offset
+    static Variant fromJsonFile(std::string const& path, VariantArena& arena);
+
+    /// Parse `json` into a tree whose strings refer to `json` instead of owning a copy
+    ///
+    /// Short strings, strings containing escapes and the `Map` keys are still owned.
+    /// `json` must stay alive and unmodified as long as the tree or any copy of it is
+    /// used, `materialize()` ends the dependency.
+    /// \throw std::runtime_error on `json` parse
+    static Variant fromJsonView(std::string_view json);
+
+    /// Parse the tree into `arena`, see `VariantArena`, the strings borrow from `json`
+    /// \throw std::runtime_error on `json` parse
+    static Variant fromJsonView(std::string_view json, VariantArena& arena);
+
     rapidjson::Document& to(rapidjson::Document& json) const;
 
     std::string toJson() const;
     std::string toPrettyJson() const;
+
+    /// Replace the contents of `out` by the text, the capacity of `out` is reused
+    void toJson(std::string& out) const;
+
+    /// Append the text to `out`
+    ///
+    /// Writing into a string of sufficient capacity allocates nothing.
+    void appendJson(std::string& out) const;
+
+    /// Write the text to `sink` in chunks of up to 4 KiB, see `JsonSink`
+    void toJson(JsonSink& sink) const;
+    void toPrettyJson(JsonSink& sink) const;
     /// @}
 
     friend std::ostream& operator<<(std::ostream& os, Variant const& var);
 
+    friend VariantStats stats(Variant const& x);
+
+    friend class VariantParser;
+
     std::type_info const& typeInfo() const noexcept;
 
+    /// The type, `vec` for a packed array
     TypeTag type() const noexcept {
-        return type_tag_;
+        return type_tag_ > TypeTag::map ? TypeTag::vec : type_tag_;
+    }
+
+    /// The type, `int64_vec`, `uint64_vec`, `double_vec` or `bool_vec` for a packed array
+    ///
+    /// A packed array whose values were freed by `vec()` is a `vec`.
+    TypeTag packedType() const noexcept;
+
+    /// Test if the value is a packed array, see `packedType()`
+    bool isPacked() const noexcept {
+        return packedType() > TypeTag::map;
     }
 
     static constexpr std::string_view typeName() noexcept {
@@ -326,7 +553,12 @@ public:
 
     /// Test if the value is a scalar
     inline bool isScalar() const noexcept {
-        return type_tag_ != TypeTag::map && type_tag_ != TypeTag::vec;
+        return type_tag_ != TypeTag::map && !isVec();
+    }
+
+    /// Test if the value is a `vec` or a packed array
+    inline bool isVec() const noexcept {
+        return type_tag_ == TypeTag::vec || type_tag_ > TypeTag::map;
     }
 
     // list of supported types
@@ -348,7 +580,20 @@ public:
 
 private:
     struct Impl;
+
+    /// Where the payload of `string`, `vec`, `map` and a packed array lives
+    enum class Storage : uint8_t {
+        heap,  ///< `value_.ptr` owns a reference to the shared payload
+        local, ///< short string stored in the object itself
+        arena, ///< `value_.ptr` points into a `VariantArena`
+        view   ///< string borrowed from the buffer passed to `fromJsonView()`
+    };
+
     TypeTag type_tag_;
+    Storage storage_{Storage::heap};
+    // [0] length of a local string, then its first bytes continued in `value_`, or
+    // [2] the size of an arena or view string
+    char local_[6];
     union ValueType {
         ValueType() = default;
         ValueType(NullType x) noexcept
@@ -406,8 +651,8 @@ private:
     } value_;
 };
 
-using VariantMap = std::unordered_map<std::string, Variant>;
-using VariantVec = std::vector<Variant>;
+using VariantMap = Variant::Map;
+using VariantVec = Variant::Vec;
 
 template <>
 inline bool Variant::asOr<bool>(bool x) const {
@@ -453,7 +698,7 @@ inline uint64_t Variant::asOr<uint64_t>(uint64_t x) const {
 template <>
 struct EnumTraits<Variant::TypeTag> {
     using Enum = Variant::TypeTag;
-    static constexpr size_t const count = 15;
+    static constexpr size_t const count = 19;
     static constexpr std::array<Enum, count> const values = {Enum::null,
                                                              Enum::boolean,
                                                              Enum::char_,
@@ -468,7 +713,11 @@ struct EnumTraits<Variant::TypeTag> {
                                                              Enum::double_,
                                                              Enum::string,
                                                              Enum::vec,
-                                                             Enum::map};
+                                                             Enum::map,
+                                                             Enum::int64_vec,
+                                                             Enum::uint64_vec,
+                                                             Enum::double_vec,
+                                                             Enum::bool_vec};
     static char const* toString(Enum e) {
         switch (e) {
         case Enum::null:
@@ -501,6 +750,14 @@ struct EnumTraits<Variant::TypeTag> {
             return "vec";
         case Enum::map:
             return "map";
+        case Enum::int64_vec:
+            return "int64_vec";
+        case Enum::uint64_vec:
+            return "uint64_vec";
+        case Enum::double_vec:
+            return "double_vec";
+        case Enum::bool_vec:
+            return "bool_vec";
         }
         throw std::logic_error(
                 "'" + std::to_string(static_cast<std::underlying_type_t<Enum>>(e)) +
@@ -510,3 +767,14 @@ struct EnumTraits<Variant::TypeTag> {
 };
 
 } // namespace yenxo
+
+namespace std {
+
+template <>
+struct hash<yenxo::Variant> {
+    size_t operator()(yenxo::Variant const& x) const noexcept {
+        return x.hash();
+    }
+};
+
+} // namespace std
@@ -0,0 +1,92 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#pragma once
+
+#include <cstddef>
+#include <memory_resource>
+#include <vector>
+
+namespace yenxo {
+
+/// Bump allocator for request scoped `Variant` trees
+/// \ingroup group-datatypes
+///
+/// Strings, maps and the payloads of arrays of a `Variant` built with an arena (see
+/// `Variant::fromJson(std::string const&, VariantArena&)`) are placed into the arena
+/// and are never freed individually. The memory is reclaimed all at once by `reset()`
+/// or by the arena destructor.
+///
+/// The arena saves the heap allocations of the long strings and of the entries and
+/// hashes of the maps, including their regrowths. It does not make a tree free to
+/// build or to tear down: the element buffers of arrays are plain `std::vector`
+/// buffers on the heap, so `Variant::Vec` stays a `std::vector<Variant>`, and the
+/// destructor of every node still runs before `reset()`.
+///
+/// The arena must outlive the `Variant`s built with it, copies of them are
+/// independent of the arena. Map keys are `InternedKey`s, they live in the global key
+/// pool.
+class VariantArena final : public std::pmr::memory_resource {
+public:
+    /// \param initial_size size of the first memory block
+    explicit VariantArena(std::size_t initial_size = 4096);
+
+    ~VariantArena() override;
+
+    VariantArena(VariantArena const&) = delete;
+    VariantArena& operator=(VariantArena const&) = delete;
+
+    /// Make all the memory available again
+    ///
+    /// \pre the `Variant`s built with the arena are destroyed
+    /// The blocks are kept for reuse, so a reset arena usually serves
+    /// the next tree of similar size without touching the global allocator.
+    void reset() noexcept;
+
+    /// Bytes handed out since the last reset
+    std::size_t used() const noexcept {
+        return used_;
+    }
+
+    /// Bytes held in memory blocks
+    std::size_t capacity() const noexcept;
+
+private:
+    struct Block {
+        std::byte* data;
+        std::size_t size;
+    };
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override;
+    void do_deallocate(void*, std::size_t, std::size_t) noexcept override;
+    bool do_is_equal(std::pmr::memory_resource const& other) const noexcept override;
+
+    std::vector<Block> blocks_;
+    std::size_t current_{0};
+    std::size_t offset_{0};
+    std::size_t used_{0};
+    std::size_t next_size_;
+};
+
+} // namespace yenxo
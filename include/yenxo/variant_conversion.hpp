@@ -27,6 +27,7 @@
 #include <yenxo/config.hpp>
 #include <yenxo/enum_traits.hpp>
 #include <yenxo/exception.hpp>
+#include <yenxo/interned_key.hpp>
 #include <yenxo/meta.hpp>
 #include <yenxo/variant.hpp>
 #include <yenxo/when.hpp>
@@ -41,6 +42,7 @@
 #include <sstream>
 #include <tuple>
 #include <type_traits>
+#include <utility>
 #include <variant>
 
 namespace yenxo {
@@ -191,6 +193,18 @@ inline constexpr auto isCollectionTypeWithEmplace = [](auto type) {
     }
 };
 
+namespace detail {
+
+/// \ingroup group-details
+/// `Variant::Map` key of the `hana::string` `S`, interned on the first call.
+template <class S>
+InternedKey const& internedKey(S) {
+    static InternedKey const ret(boost::hana::to<char const*>(S()));
+    return ret;
+}
+
+} // namespace detail
+
 /// To `Variant` conversion function object
 /// \ingroup group-function
 ///
@@ -224,6 +238,10 @@ struct ToVariantImpl<T, When<isVariant(boost::hana::type_c<T>)>> {
     static Variant apply(T const& x) {
         return x;
     }
+
+    static Variant apply(T&& x) noexcept {
+        return std::move(x);
+    }
 };
 
 // Specialization for types with `static Variant T::toVariant(T)`
@@ -238,20 +256,28 @@ struct ToVariantImpl<T, When<hasToVariant(boost::hana::type_c<T>)>> {
 template <typename T>
 struct ToVariantImpl<T, When<isConvertibleToVariantBuildIn(boost::hana::type_c<T>)>> {
     static Variant apply(T x) {
-        return Variant(x);
+        return Variant(std::move(x));
     }
 };
 
 // Specialization for map types
 template <typename T>
 struct ToVariantImpl<T, When<isMapType(boost::hana::type_c<T>)>> {
+    using K = typename T::key_type;
+
     static Variant apply(T const& map) {
         VariantMap ret;
+        ret.reserve(std::size(map));
         for (auto const& x : map) {
-            ret.emplace(ToVariantImpl<typename T::key_type>::apply(x.first),
-                        ToVariantImpl<typename T::mapped_type>::apply(x.second));
+            if constexpr (std::is_convertible_v<K const&, std::string_view>) {
+                ret.try_emplace(std::string_view(x.first),
+                                ToVariantImpl<typename T::mapped_type>::apply(x.second));
+            } else {
+                ret.try_emplace(ToVariantImpl<K>::apply(x.first).strView(),
+                                ToVariantImpl<typename T::mapped_type>::apply(x.second));
+            }
         }
-        return Variant(ret);
+        return Variant(std::move(ret));
     }
 };
 
@@ -260,9 +286,12 @@ template <typename T>
 struct ToVariantImpl<T, When<isPair(boost::hana::type_c<T>)>> {
     static Variant apply(T const& pair) {
         VariantMap tmp;
-        tmp["first"] = toVariant(pair.first);
-        tmp["second"] = toVariant(pair.second);
-        return Variant(tmp);
+        tmp.reserve(2);
+        tmp.try_emplace(detail::internedKey(BOOST_HANA_STRING("first")),
+                        toVariant(pair.first));
+        tmp.try_emplace(detail::internedKey(BOOST_HANA_STRING("second")),
+                        toVariant(pair.second));
+        return Variant(std::move(tmp));
     }
 };
 
@@ -277,16 +306,37 @@ struct ToVariantImpl<T, When<isTuple(boost::hana::type_c<T>)>> {
     }
 };
 
-// Specialization for collection types
+// Specialization for collection types, the numbers and booleans are packed
 template <typename T>
 struct ToVariantImpl<T, When<isCollectionType(boost::hana::type_c<T>)>> {
+    using V = typename T::value_type;
+
     static Variant apply(T const& vec) {
+        if constexpr (std::is_arithmetic_v<V> && !std::is_same_v<V, char>) {
+            if (std::size(vec) >= YENXO_PACKED_MIN_SIZE) {
+                return packed(vec);
+            }
+        }
         VariantVec ret;
         ret.reserve(std::size(vec));
         for (auto const& x : vec) {
             ret.push_back(toVariant(x));
         }
-        return Variant(ret);
+        return Variant(std::move(ret));
+    }
+
+    static Variant packed(T const& vec) {
+        if constexpr (std::is_same_v<V, bool>) {
+            return Variant(Variant::BoolVec(std::begin(vec), std::end(vec)));
+        } else if constexpr (std::is_floating_point_v<V>) {
+            return Variant(Variant::DoubleVec(std::begin(vec), std::end(vec)));
+        } else if constexpr (std::is_unsigned_v<V> && sizeof(V) == sizeof(uint64_t)) {
+            return Variant(Variant::Uint64Vec(std::begin(vec), std::end(vec)));
+        } else {
+            // `vec()` gives back the elements `toVariant()` makes
+            return Variant(Variant::Int64Vec(std::begin(vec), std::end(vec)),
+                           toVariant(V()).type());
+        }
     }
 };
 
@@ -351,11 +401,11 @@ template <typename T>
 struct ToVariantImpl<T, When<boost::hana::is_a<boost::hana::map_tag, T>>> {
     static Variant apply(T const& map) {
         Variant::Map ret;
-        boost::hana::for_each(map, boost::hana::fuse([&ret](auto key, auto value) {
-                                  ret[boost::hana::to<char const*>(key)] =
-                                          toVariant(value);
-                              }));
-        return Variant(ret);
+        ret.reserve(boost::hana::length(map));
+        boost::hana::for_each(boost::hana::keys(map), [&](auto key) {
+            ret.try_emplace(detail::internedKey(key), toVariant(map[key]));
+        });
+        return Variant(std::move(ret));
     }
 };
 
@@ -375,7 +425,7 @@ struct ToVariantImpl<T, When<boost::hana::is_a<boost::hana::tuple_tag, T>>> {
         ret.reserve(boost::hana::size(val));
         boost::hana::for_each(val,
                               [&ret](auto const& x) { ret.push_back(toVariant(x)); });
-        return Variant(ret);
+        return Variant(std::move(ret));
     }
 };
 
@@ -444,7 +494,11 @@ struct FromVariantImpl<T, When<hasFromVariant(boost::hana::type_c<T>)>> {
 template <typename T>
 struct FromVariantImpl<T, When<isVariantBuildIn(boost::hana::type_c<T>)>> {
     static T apply(Variant const& x) {
-        return static_cast<T>(x);
+        if constexpr (std::is_same_v<T, std::string>) {
+            return std::string(x.strView());
+        } else {
+            return static_cast<T>(x);
+        }
     }
 };
 
@@ -501,10 +555,20 @@ struct FromVariantImpl<T, When<detail::IsStdArrayImpl<T>::value>> {
 // Specialization for collection types (with push_back)
 template <typename T>
 struct FromVariantImpl<T, When<isCollectionTypeWithPushBack(boost::hana::type_c<T>)>> {
+    using V = typename T::value_type;
+
     static T apply(Variant const& var) {
+        if constexpr (std::is_same_v<T, std::vector<V>> && std::is_arithmetic_v<V>
+                      && Variant::Types::anyOf<V>()) {
+            return var.vecAs<V>();
+        }
+        auto const& vec = var.vec();
         T ret;
+        if constexpr (hasReserve(boost::hana::type_c<T>)) {
+            ret.reserve(vec.size());
+        }
         size_t i = 0;
-        for (auto const& x : var.vec()) {
+        for (auto const& x : vec) {
             detail::tryCatch(
                     [&] { ret.push_back(fromVariant<typename T::value_type>(x)); }, i++);
         }
@@ -516,9 +580,13 @@ struct FromVariantImpl<T, When<isCollectionTypeWithPushBack(boost::hana::type_c<
 template <typename T>
 struct FromVariantImpl<T, When<isCollectionTypeWithEmplace(boost::hana::type_c<T>)>> {
     static T apply(Variant const& var) {
+        auto const& vec = var.vec();
         T ret;
+        if constexpr (hasReserve(boost::hana::type_c<T>)) {
+            ret.reserve(vec.size());
+        }
         size_t i = 0;
-        for (auto const& x : var.vec()) {
+        for (auto const& x : vec) {
             detail::tryCatch([&] { ret.emplace(fromVariant<typename T::value_type>(x)); },
                              i++);
         }
@@ -529,22 +597,41 @@ struct FromVariantImpl<T, When<isCollectionTypeWithEmplace(boost::hana::type_c<T
 // Specialization for map types
 template <typename T>
 struct FromVariantImpl<T, When<isMapType(boost::hana::type_c<T>)>> {
+    using K = typename T::key_type;
+
     static T apply(Variant const& var) {
+        auto const& map = var.map();
         T ret;
-        for (auto const& x : var.map()) {
-            ret.emplace(FromVariantImpl<typename T::key_type>::apply(Variant(x.first)),
+        if constexpr (hasReserve(boost::hana::type_c<T>)) {
+            ret.reserve(map.size());
+        }
+        for (auto const& x : map) {
+            ret.emplace(key(x.first),
                         FromVariantImpl<typename T::mapped_type>::apply(x.second));
         }
         return ret;
     }
+
+    static K key(InternedKey const& x) {
+        if constexpr (std::is_same_v<K, InternedKey>) {
+            return x;
+        } else if constexpr (std::is_constructible_v<K, std::string_view>) {
+            return K(x.view());
+        } else {
+            return FromVariantImpl<K>::apply(Variant(x.view()));
+        }
+    }
 };
 
 // Specialization for pair
 template <typename T>
 struct FromVariantImpl<T, When<isPair(boost::hana::type_c<T>)>> {
     static T apply(Variant const& var) {
-        return T(yenxo::fromVariant<typename T::first_type>(var.map().at("first")),
-                 yenxo::fromVariant<typename T::second_type>(var.map().at("second")));
+        auto const& map = var.map();
+        return T(yenxo::fromVariant<typename T::first_type>(
+                         map.at(detail::internedKey(BOOST_HANA_STRING("first")))),
+                 yenxo::fromVariant<typename T::second_type>(
+                         map.at(detail::internedKey(BOOST_HANA_STRING("second")))));
     }
 };
 
@@ -554,13 +641,13 @@ struct FromVariantImpl<
         T,
         When<isReflectiveEnumWithSingleStringRepresentation(boost::hana::type_c<T>)>> {
     static T apply(Variant const& var) {
-        auto const& s = var.str();
+        auto const s = var.strView();
         for (auto e : EnumTraits<T>::values) {
             if (EnumTraits<T>::toString(e) == s) {
                 return e;
             }
         }
-        throw VariantBadType(s, boost::hana::type_c<T>);
+        throw VariantBadType(std::string(s), boost::hana::type_c<T>);
     }
 };
 
@@ -571,10 +658,10 @@ struct FromVariantImpl<
         When<isReflectiveEnumWithMultiStringRepresentation(boost::hana::type_c<T>)>> {
     template <size_t I>
     static typename EnumTraits<T>::Enum applyImpl(boost::hana::size_t<I>,
-                                                  std::string const& x) {
+                                                  std::string_view x) {
         bool found{false};
         boost::hana::for_each(boost::hana::at_c<I>(EnumTraits<T>::strings()),
-                              [&](auto s) { found |= strcmp(s, x.c_str()) == 0; });
+                              [&](auto s) { found |= x == s; });
         if (found) {
             return EnumTraits<T>::values[I];
         } else {
@@ -586,8 +673,8 @@ struct FromVariantImpl<
 
     static typename EnumTraits<T>::Enum applyImpl(
             boost::hana::size_t<EnumTraits<T>::count>,
-            std::string const& x) {
-        throw VariantBadType(x, boost::hana::type_c<T>);
+            std::string_view x) {
+        throw VariantBadType(std::string(x), boost::hana::type_c<T>);
     }
 
     static T apply(std::string const& x) {
@@ -595,8 +682,7 @@ struct FromVariantImpl<
     }
 
     static T apply(Variant const& var) {
-        auto const& s = var.str();
-        return applyImpl(boost::hana::size_c<0>, s);
+        return applyImpl(boost::hana::size_c<0>, var.strView());
     }
 };
 
@@ -649,12 +735,12 @@ struct FromVariantImpl<T, When<boolean(boost::hana::type_c<T>)>> {
 template <typename T>
 struct FromVariantImpl<T, When<boost::hana::is_a<boost::hana::map_tag, T>>> {
     static T apply(Variant const& var) {
-        auto const map = var.map();
+        auto const& map = var.map();
         T ret;
         boost::hana::for_each(
                 ret, boost::hana::fuse([&](auto key, auto& value) {
                     using namespace std::string_literals;
-                    auto const it = map.find(boost::hana::to<char const*>(key));
+                    auto const it = map.find(detail::internedKey(key));
                     if (map.end() == it) {
                         throw std::logic_error(boost::hana::to<char const*>(key)
                                                + " is required"s);
@@ -671,7 +757,7 @@ struct FromVariantImpl<T, When<boost::hana::is_a<boost::hana::map_tag, T>>> {
 template <typename T>
 struct FromVariantImpl<T, When<boost::hana::is_a<boost::hana::string_tag, T>>> {
     static T apply(Variant const& var) {
-        if (var.str() != boost::hana::to<char const*>(T())) {
+        if (var.strView() != boost::hana::to<char const*>(T())) {
             std::ostringstream oss;
             oss << var;
             throw VariantBadType(oss.str(), boost::hana::type_c<T>);
@@ -24,14 +24,15 @@
 
 #pragma once
 
-#include <string>
-#include <unordered_map>
+#include <yenxo/string_map.hpp>
+
 #include <vector>
 
 namespace yenxo {
 
 class Variant;
-using VariantMap = std::unordered_map<std::string, Variant>;
+class VariantArena;
+using VariantMap = StringMap<Variant>;
 using VariantVec = std::vector<Variant>;
 
 } // namespace yenxo
@@ -0,0 +1,82 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#pragma once
+
+#include <yenxo/variant.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <string_view>
+
+namespace yenxo {
+
+/// Resumable parser of a JSON document received in chunks
+/// \ingroup group-json
+///
+/// The chunks may split the document anywhere, even inside a token. The tree is built
+/// by the handler of `Variant::fromJson()` as the chunks arrive and only the token split
+/// by a chunk boundary is buffered, so the memory used is that of the tree rather than
+/// the tree and the text.
+///
+/// \code
+/// VariantParser parser;
+/// while (auto const n = read(fd, buf, sizeof(buf))) {
+///     parser.feed(std::string_view(buf, n));
+/// }
+/// auto const var = parser.finish();
+/// \endcode
+class VariantParser {
+public:
+    VariantParser();
+
+    /// Build the tree inside `arena`, see `VariantArena`
+    explicit VariantParser(VariantArena& arena);
+
+    ~VariantParser();
+
+    VariantParser(VariantParser&&) noexcept;
+    VariantParser& operator=(VariantParser&&) noexcept;
+
+    /// Parse the next chunk of the document
+    /// \throw std::runtime_error with the offset of a syntax error, the parser is reset
+    /// to the start of a document
+    void feed(std::string_view chunk);
+
+    /// End the document and take the tree
+    ///
+    /// The parser is ready for the next document afterwards.
+    /// \throw std::runtime_error if the document is incomplete
+    Variant finish();
+
+    /// Number of bytes fed since the start of the document
+    std::size_t offset() const noexcept;
+
+private:
+    struct State;
+
+    std::unique_ptr<State> state_;
+};
+
+} // namespace yenxo
@@ -0,0 +1,112 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#pragma once
+
+#include <yenxo/variant.hpp>
+
+#include <array>
+#include <cstddef>
+
+namespace yenxo {
+
+/// Shape and memory footprint of a `Variant` tree, see `stats()`
+/// \ingroup group-datatypes
+struct VariantStats {
+    static constexpr std::size_t type_count =
+            static_cast<std::size_t>(Variant::TypeTag::bool_vec) + 1;
+
+    /// Number of values per `Variant::TypeTag`, the elements of packed arrays excluded
+    std::array<std::size_t, type_count> nodes{};
+    /// Number of elements of the packed arrays
+    std::size_t packed_elements{0};
+    /// Number of nesting levels, 1 for a scalar
+    std::size_t max_depth{0};
+    /// Characters of the string values
+    std::size_t string_bytes{0};
+    /// Characters of the `Map` keys, they live in the interned key pool
+    std::size_t key_bytes{0};
+    /// Bytes reserved but unused by `Vec`s, `Map`s and packed arrays
+    std::size_t slack_bytes{0};
+    /// Bytes of the key hashes and hash indexes of `Map`s, part of `heap_bytes`
+    std::size_t index_bytes{0};
+    /// Estimated heap bytes owned by the tree, the shared payloads counted once
+    std::size_t heap_bytes{0};
+    /// Number of times a heap payload counted before was reached again
+    std::size_t shared_payloads{0};
+
+    std::size_t count(Variant::TypeTag tag) const noexcept {
+        return nodes[static_cast<std::size_t>(tag)];
+    }
+
+    /// Number of values of all types
+    std::size_t total() const noexcept {
+        std::size_t ret = 0;
+        for (auto const x : nodes) {
+            ret += x;
+        }
+        return ret;
+    }
+};
+
+/// Collect the statistics of the tree `x`
+/// \ingroup group-utility
+///
+/// Every value is visited, including the ones of the subtrees shared between the
+/// branches. The bytes of the payloads placed in a `VariantArena`, except the array
+/// buffers, of the strings borrowed by `Variant::fromJsonView()` and of the interned
+/// keys are not part of `heap_bytes`. The allocator overhead is not accounted.
+VariantStats stats(Variant const& x);
+
+/// Observer of the heap payload allocations of `Variant`
+/// \ingroup group-utility
+///
+/// Called with the size of each allocated payload and with the negated size of each
+/// freed one. The payload is the node holding a string, `Vec`, `Map` or packed array
+/// together with its reference count, the buffers of the containers are not reported.
+using PayloadHook = void (*)(std::ptrdiff_t bytes) noexcept;
+
+/// Install `hook` for all threads, `nullptr` removes it
+/// \ingroup group-utility
+///
+/// The hook must be thread safe.
+/// \return the previous hook
+PayloadHook setPayloadHook(PayloadHook hook) noexcept;
+
+/// Set the number of freed payloads of each size class a thread keeps for reuse
+/// \ingroup group-utility
+///
+/// The payloads beyond the limit, and the ones kept by an exiting thread, are passed to
+/// a global pool of up to 16 times the limit per size class, the rest is freed. The
+/// global pool is guarded by a mutex, taken once per batch of payloads. A thread whose
+/// own pool is empty takes up to the limit from there. 0 disables the pooling. The
+/// default is `YENXO_PAYLOAD_POOL_LIMIT`.
+///
+/// Lowering the limit frees the payloads beyond it of the global pool and of the pool of
+/// the calling thread at once. Another thread trims its own pool on its next allocation
+/// or release of a payload, an idle thread keeps its pool until it exits.
+/// \return the previous limit
+std::size_t setPayloadPoolLimit(std::size_t limit) noexcept;
+
+} // namespace yenxo
@@ -24,6 +24,7 @@
 
 #pragma once
 
+#include <yenxo/interned_key.hpp>
 #include <yenxo/meta.hpp>
 #include <yenxo/variant.hpp>
 #include <yenxo/variant_conversion.hpp>
@@ -31,6 +32,7 @@
 #include <boost/hana.hpp>
 
 #include <type_traits>
+#include <utility>
 
 namespace yenxo {
 
@@ -104,6 +106,12 @@ inline constexpr auto const hasUpdateVar = boost::hana::is_valid(
         [](auto t) -> decltype((void)std::declval<typename decltype(t)::type>().updateVar(
                            std::declval<Variant>())) {});
 
+/// \ingroup group-details
+/// Has member `mergeVar(yenxo::Variant const&)`.
+inline constexpr auto const hasMergeVar = boost::hana::is_valid(
+        [](auto t) -> decltype((void)std::declval<typename decltype(t)::type>().mergeVar(
+                           std::declval<Variant>())) {});
+
 /// %Default implementation of `VarPolicy::Defaults` policy parameter
 /// \ingroup group-traits-auto-variant-policy
 struct Default {
@@ -167,6 +175,50 @@ struct Rename {
     }
 };
 
+/// \ingroup group-details
+/// Is `Policy::rename(T, S)` a constant expression.
+template <class T, class Policy, class S, class = void>
+struct IsConstexprRename : std::false_type {};
+
+template <class T, class Policy, class S>
+struct IsConstexprRename<
+        T,
+        Policy,
+        S,
+        std::void_t<std::integral_constant<
+                bool,
+                (Policy::rename(boost::hana::type_c<T>, S()), true)>>> : std::true_type {};
+
+/// \ingroup group-details
+/// Can the key of the member `S` of `T` be interned once: the default `Rename` depends
+/// on `T::names()` only, a constexpr rename on nothing at all.
+template <class T, class Policy, class S>
+inline constexpr bool cachedKey =
+        std::is_same_v<std::remove_const_t<decltype(Policy::rename)>, Rename>
+        || IsConstexprRename<T, Policy, S>::value;
+
+/// `Variant::Map` key of the member `name` of `T`
+/// \ingroup group-details
+///
+/// The key is interned on the first call if `cachedKey`, else `Policy::rename` may depend
+/// on a runtime state and is called every time.
+template <class T, class Policy, class S>
+decltype(auto) memberKey(S name) {
+    if constexpr (cachedKey<T, Policy, S>) {
+        static InternedKey const ret(Policy::rename(boost::hana::type_c<T>, name));
+        return (ret);
+    } else {
+        return InternedKey(Policy::rename(boost::hana::type_c<T>, name));
+    }
+}
+
+/// \ingroup group-details
+/// Key of the tag property.
+inline InternedKey const& tagKey() {
+    static InternedKey const ret("__tag");
+    return ret;
+}
+
 template <typename T, typename F = decltype(toVariant2)>
 void toVariantWrap(Variant& var, T&& val, F const& to_variant = toVariant2) {
     to_variant(var, std::forward<T>(val));
@@ -209,7 +261,8 @@ struct VarPolicy {
     /// to variant conversion function object
     static constexpr auto to_variant = toVariant2;
 
-    /// rename function object
+    /// rename function object, called once per member if it is the default one or
+    /// constexpr, else on every conversion
     static constexpr detail::Rename rename{};
 
     /// An optional hook extending from_variant behavior
@@ -237,14 +290,20 @@ using VarDefPolicy [[deprecated("Use yenxo::trait::VarPolicy.")]] = VarPolicy;
 /// \pre `T` should be a Boost.Hana.Struct.
 template <class T, class Policy = VarPolicy>
 Variant toVariantImpl(T const& x) {
+    constexpr std::size_t members = boost::hana::length(boost::hana::accessors<T>());
     Variant::Map ret;
+    ret.reserve(members
+                + !std::is_same_v<std::remove_const_t<decltype(Policy::tag)>,
+                                  typename Policy::NoTag>);
 
     boost::hana::for_each(
-            x, boost::hana::fuse([&](auto name, auto value) {
-                auto const renamed = Policy::rename(boost::hana::type_c<T>, name);
-                if constexpr (isOptional(boost::hana::type_c<decltype(value)>)) {
+            boost::hana::accessors<T>(), boost::hana::fuse([&](auto name, auto get) {
+                auto const& value = get(x);
+                using V = std::remove_cv_t<std::remove_reference_t<decltype(value)>>;
+                auto const& key = detail::memberKey<T, Policy>(name);
+                if constexpr (isOptional(boost::hana::type_c<V>)) {
                     if (value.has_value()) {
-                        detail::toVariantWrap(ret[renamed], *value, Policy::to_variant);
+                        detail::toVariantWrap(ret[key], *value, Policy::to_variant);
                     }
                 } else {
                     if constexpr (Policy::Defaults::has(boost::hana::type_c<T>)) {
@@ -255,7 +314,7 @@ Variant toVariantImpl(T const& x) {
                                     std::is_convertible_v<
                                             decltype(Policy::Defaults::value(
                                                     boost::hana::type_c<T>, name)),
-                                            std::remove_reference_t<decltype(value)>>,
+                                            V>,
                                     "Default value should be convertible to field "
                                     "type");
                             if (Policy::Defaults::value(boost::hana::type_c<T>, name)
@@ -265,26 +324,25 @@ Variant toVariantImpl(T const& x) {
                         }
                     }
 
-                    if constexpr (isContainer(boost::hana::type_c<decltype(value)>)) {
+                    if constexpr (isContainer(boost::hana::type_c<V>)) {
                         if constexpr (!Policy::empty_container_not_required) {
-                            detail::toVariantWrap(
-                                    ret[renamed], value, Policy::to_variant);
+                            detail::toVariantWrap(ret[key], value, Policy::to_variant);
                         } else if (begin(value) != end(value)) {
-                            detail::toVariantWrap(
-                                    ret[renamed], value, Policy::to_variant);
+                            detail::toVariantWrap(ret[key], value, Policy::to_variant);
                         }
                     } else {
-                        detail::toVariantWrap(ret[renamed], value, Policy::to_variant);
+                        detail::toVariantWrap(ret[key], value, Policy::to_variant);
                     }
                 }
             }));
 
     if constexpr (!std::is_same_v<std::remove_const_t<decltype(Policy::tag)>,
                                   typename Policy::NoTag>) {
-        detail::toVariantWrap(ret["__tag"], Policy::tag, Policy::to_variant);
+        detail::toVariantWrap(
+                ret[detail::tagKey()], Policy::tag, Policy::to_variant);
     }
 
-    return Variant(ret);
+    return Variant(std::move(ret));
 }
 
 /// Convert `x` to `T`
@@ -307,7 +365,7 @@ T fromVariantImpl(yenxo::Variant const& x) {
     if constexpr (!std::is_same_v<std::remove_const_t<decltype(Policy::tag)>,
                                   typename Policy::NoTag>) {
         std::remove_const_t<decltype(Policy::tag)> tmp;
-        auto const it = map.find("__tag");
+        auto const it = map.find(detail::tagKey());
         if (it == map.end()) {
             throw std::logic_error("'__tag' is required"s);
         }
@@ -316,9 +374,10 @@ T fromVariantImpl(yenxo::Variant const& x) {
 
     boost::hana::for_each(
             boost::hana::accessors<T>(), boost::hana::fuse([&](auto name, auto value) {
-                auto const renamed = Policy::rename(boost::hana::type_c<T>, name);
+                auto const& key = detail::memberKey<T, Policy>(name);
+                auto const renamed = key.c_str();
                 auto& tmp = value(ret);
-                auto const it = map.find(renamed);
+                auto const it = map.find(key);
 
                 if (map.end() == it) {
                     if constexpr (Policy::Defaults::has(boost::hana::type_c<T>)) {
@@ -360,10 +419,9 @@ T fromVariantImpl(yenxo::Variant const& x) {
         const auto expected_keys = boost::hana::keys(ret);
         for (auto const& p : map) {
             if (boost::hana::none_of(expected_keys, [&p](auto name) {
-                    auto const renamed = Policy::rename(boost::hana::type_c<T>, name);
-                    return static_cast<std::string_view>(p.first) == renamed;
+                    return p.first == detail::memberKey<T, Policy>(name);
                 })) {
-                throw std::logic_error("'" + p.first + "' is unknown");
+                throw std::logic_error("'" + std::string(p.first) + "' is unknown");
             }
         }
     }
@@ -398,50 +456,84 @@ struct Var {
 template <typename Derived, typename Policy = VarPolicy>
 using VarDef [[deprecated("Use yenxo::trait::Var.")]] = Var<Derived, Policy>;
 
-/// Updates the specified fields
-/// \ingroup group-traits-auto-variant
-///
-/// Conversion can be customized via `Policy`.
-///
-/// `T` can provide
-/// * names().
-///
-/// \pre `T` should be a Boost.Hana.Struct.
-template <class T, class Policy = VarPolicy>
-void updateVarImpl(T& self, Variant const& x) {
+namespace detail {
+
+/// \ingroup group-details
+/// Update the members of `self` named in `x`, see `updateVarImpl()` and `mergeVarImpl()`
+template <class T, class Policy, bool merge>
+void updateMembers(T& self, Variant const& x) {
     auto const& map = x.map();
     for (auto const& v : map) {
         bool found{false};
         boost::hana::for_each(
                 boost::hana::accessors<T>(),
                 boost::hana::fuse([&](auto name, auto value) {
-                    auto const renamed = Policy::rename(boost::hana::type_c<T>, name);
-                    if (renamed != v.first) {
+                    auto const& key = detail::memberKey<T, Policy>(name);
+                    if (key != v.first) {
                         return;
                     }
                     auto& tmp = value(self);
-                    if constexpr (detail::hasUpdateVar(
-                                          boost::hana::type_c<std::remove_reference_t<
-                                                  decltype(tmp)>>)) {
+                    using M = std::remove_reference_t<decltype(tmp)>;
+                    if constexpr (isOptional(boost::hana::type_c<M>)) {
+                        if (merge && v.second.null()) {
+                            tmp.reset();
+                        } else {
+                            typename M::value_type under;
+                            detail::fromVariantWrap(under, v.second, key.c_str());
+                            tmp = std::move(under);
+                        }
+                    } else if constexpr (merge && hasMergeVar(boost::hana::type_c<M>)) {
+                        tmp.mergeVar(v.second);
+                    } else if constexpr (hasUpdateVar(boost::hana::type_c<M>)) {
                         tmp.updateVar(v.second);
                     } else {
-                        detail::fromVariantWrap<decltype(tmp)>(tmp, v.second, renamed);
+                        detail::fromVariantWrap<decltype(tmp)>(tmp, v.second, key.c_str());
                     }
                     found = true;
                 }));
 
         if constexpr (!Policy::allow_additional_properties) {
             if (!found) {
-                throw std::logic_error("'" + v.first + "'" + " is unknown");
+                throw std::logic_error("'" + std::string(v.first) + "'" + " is unknown");
             }
         }
     }
 }
 
-/// Adds member `void updateVar(Variant const&)`
+} // namespace detail
+
+/// Updates the specified fields
 /// \ingroup group-traits-auto-variant
 ///
-/// Updates the specified fields.
+/// Conversion can be customized via `Policy`.
+///
+/// A `std::optional` member is assigned its whole value like by `fromVariantImpl()`.
+///
+/// `T` can provide
+/// * names().
+///
+/// \pre `T` should be a Boost.Hana.Struct.
+template <class T, class Policy = VarPolicy>
+void updateVarImpl(T& self, Variant const& x) {
+    detail::updateMembers<T, Policy, false>(self, x);
+}
+
+/// Merges the RFC 7396 merge patch `x`, see `MergePatch`
+/// \ingroup group-traits-auto-variant
+///
+/// Like `updateVarImpl()`, except that a null resets a `std::optional` member and a
+/// member with `mergeVar` is merged in turn.
+///
+/// \pre `T` should be a Boost.Hana.Struct.
+template <class T, class Policy = VarPolicy>
+void mergeVarImpl(T& self, Variant const& x) {
+    detail::updateMembers<T, Policy, true>(self, x);
+}
+
+/// Adds members `void updateVar(Variant const&)` and `void mergeVar(Variant const&)`
+/// \ingroup group-traits-auto-variant
+///
+/// Updates the specified fields, see `updateVarImpl()` and `mergeVarImpl()`.
 ///
 /// Supports
 /// * names().
@@ -452,6 +544,10 @@ struct UpdateFromVar {
     void updateVar(Variant const& x) {
         updateVarImpl<Derived, Policy>(static_cast<Derived&>(*this), x);
     }
+
+    void mergeVar(Variant const& x) {
+        mergeVarImpl<Derived, Policy>(static_cast<Derived&>(*this), x);
+    }
 };
 
 /// Updates the specified fields.
@@ -544,7 +640,7 @@ struct UpdateFromOpt {
         return yenxo::trait::fromVariantImpl<T, Policy>(x);                              \
     }
 
-/// Enables from `yenxo::Variant` update for `T`
+/// Enables from `yenxo::Variant` update and merge for `T`
 /// \ingroup group-traits-auto-variant
 ///
 /// `T` can provide
@@ -554,9 +650,12 @@ struct UpdateFromOpt {
 #define YENXO_UPDATE_FROM_VARIANT(T)                                                     \
     void updateVar(yenxo::Variant const& x) {                                            \
         yenxo::trait::updateVarImpl<T>(*this, x);                                        \
+    }                                                                                    \
+    void mergeVar(yenxo::Variant const& x) {                                             \
+        yenxo::trait::mergeVarImpl<T>(*this, x);                                         \
     }
 
-/// Enables from `yenxo::Variant` update for `T`
+/// Enables from `yenxo::Variant` update and merge for `T`
 /// \ingroup group-traits-auto-variant
 ///
 /// Updating can be customized via `Policy`.
@@ -568,6 +667,9 @@ struct UpdateFromOpt {
 #define YENXO_UPDATE_FROM_VARIANT_P(T, Policy)                                           \
     void updateVar(yenxo::Variant const& x) {                                            \
         yenxo::trait::updateVarImpl<T, Policy>(*this, x);                                \
+    }                                                                                    \
+    void mergeVar(yenxo::Variant const& x) {                                             \
+        yenxo::trait::mergeVarImpl<T, Policy>(*this, x);                                 \
     }
 
 /// Enables from `Opt` update for `T`
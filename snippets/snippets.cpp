@@ -22,15 +22,38 @@
   SOFTWARE.
 */
 
+#include "../test/allocation_counter.hpp"
+
+#include <yenxo/compact_variant.hpp>
+#include <yenxo/format.hpp>
+#include <yenxo/frozen_variant.hpp>
+#include <yenxo/from_json.hpp>
+#include <yenxo/ndjson.hpp>
 #include <yenxo/variant.hpp>
+#include <yenxo/variant_arena.hpp>
+#include <yenxo/variant_conversion.hpp>
+#include <yenxo/variant_traits.hpp>
 
 #include <rapidjson/document.h>
 
 #include <benchmark/benchmark.h>
+
+#include <algorithm>
+#include <map>
+#include <sstream>
+#include <string>
 #include <variant>
+#include <vector>
 
 using namespace yenxo;
 
+/// Report the number of global allocations per iteration made since `start`
+static void countAllocations(benchmark::State& state, size_t start) {
+    state.counters["allocs"] =
+            benchmark::Counter(static_cast<double>(allocationCount() - start),
+                               benchmark::Counter::kAvgIterations);
+}
+
 struct Var {
     std::variant<int, double, long, void*> val;
 };
@@ -278,4 +301,432 @@ static void bm_var_rj_json(benchmark::State& state) {
 }
 BENCHMARK(bm_var_rj_json);
 
+static void bm_var_from_json_records(benchmark::State& state) {
+    auto const raw = R"([
+        {"id": "a1", "name": "alpha", "kind": "user", "state": "active"},
+        {"id": "b2", "name": "beta", "kind": "admin", "state": "locked"},
+        {"id": "c3", "name": "gamma", "kind": "user", "state": "active"},
+        {"id": "d4", "name": "delta", "kind": "guest", "state": "expired"}
+    ])";
+
+    auto const start = allocationCount();
+    for (auto _ : state) {
+        auto var = yenxo::Variant::fromJson(raw);
+        benchmark::DoNotOptimize(var);
+    }
+    countAllocations(state, start);
+}
+BENCHMARK(bm_var_from_json_records);
+
+static void bm_var_from_json_records_arena(benchmark::State& state) {
+    auto const raw = R"([
+        {"id": "a1", "name": "alpha", "kind": "user", "state": "active"},
+        {"id": "b2", "name": "beta", "kind": "admin", "state": "locked"},
+        {"id": "c3", "name": "gamma", "kind": "user", "state": "active"},
+        {"id": "d4", "name": "delta", "kind": "guest", "state": "expired"}
+    ])";
+
+    VariantArena arena;
+    auto const start = allocationCount();
+    for (auto _ : state) {
+        {
+            auto var = yenxo::Variant::fromJson(raw, arena);
+            benchmark::DoNotOptimize(var);
+        }
+        arena.reset();
+    }
+    countAllocations(state, start);
+}
+BENCHMARK(bm_var_from_json_records_arena);
+
+static void bm_var_from_json_view(benchmark::State& state) {
+    std::string const raw = R"([
+        {"id": "a1", "description": "the first record of the list", "state": "active"},
+        {"id": "b2", "description": "the second record of the list", "state": "locked"},
+        {"id": "c3", "description": "the third record of the list", "state": "active"},
+        {"id": "d4", "description": "the fourth record of the list", "state": "expired"}
+    ])";
+
+    auto const start = allocationCount();
+    for (auto _ : state) {
+        auto var = state.range(0) ? Variant::fromJsonView(raw) : Variant::fromJson(raw);
+        benchmark::DoNotOptimize(var);
+    }
+    countAllocations(state, start);
+}
+BENCHMARK(bm_var_from_json_view)->Arg(0)->Arg(1);
+
+static void bm_var_from_json_insitu(benchmark::State& state) {
+    std::string const raw = R"([
+        {"id": "a1", "description": "the \"first\" record of the list"},
+        {"id": "b2", "description": "the \"second\" record of the list"},
+        {"id": "c3", "description": "the \"third\" record of the list"}
+    ])";
+
+    std::string buf;
+    auto const start = allocationCount();
+    for (auto _ : state) {
+        buf.assign(raw);
+        auto var = state.range(0) ? Variant::fromJsonInsitu(buf.data(), buf.size())
+                                  : Variant::fromJson(buf);
+        benchmark::DoNotOptimize(var);
+    }
+    countAllocations(state, start);
+}
+BENCHMARK(bm_var_from_json_insitu)->Arg(0)->Arg(1);
+
+static std::string numericArray(size_t n) {
+    std::string ret = "[";
+    for (size_t i = 0; i < n; ++i) {
+        ret += (i ? "," : "") + std::to_string(i * 0.5);
+    }
+    return ret + "]";
+}
+
+static void bm_var_from_json_numbers(benchmark::State& state) {
+    auto const raw = numericArray(1000);
+    for (auto _ : state) {
+        auto var = Variant::fromJson(raw);
+        benchmark::DoNotOptimize(var);
+    }
+    // packed as `double`s
+    state.counters["bytes"] = static_cast<double>(1000 * sizeof(double));
+}
+BENCHMARK(bm_var_from_json_numbers);
+
+static void bm_var_vector_of_doubles(benchmark::State& state) {
+    auto const var = Variant::fromJson(numericArray(1000));
+    auto const unpacked = Variant(var.vec());
+    auto const& src = state.range(0) ? var : unpacked;
+    for (auto _ : state) {
+        auto vec = fromVariant<std::vector<double>>(src);
+        benchmark::DoNotOptimize(vec);
+    }
+}
+BENCHMARK(bm_var_vector_of_doubles)->Arg(0)->Arg(1);
+
+static void bm_read_ndjson(benchmark::State& state) {
+    std::string raw;
+    for (int i = 0; i < 100000; ++i) {
+        raw += R"({"id": )" + std::to_string(i)
+             + R"(, "description": "a record of the log", "tags": [1, 2, 3]})" + "\n";
+    }
+
+    NdjsonOptions options;
+    options.threads = static_cast<std::size_t>(state.range(0));
+    options.chunk_size = 1 << 16;
+    for (auto _ : state) {
+        std::size_t n = 0;
+        readNdjson(raw, [&](Variant&&) { ++n; }, options);
+        benchmark::DoNotOptimize(n);
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * raw.size()));
+}
+BENCHMARK(bm_read_ndjson)->Arg(1)->Arg(2)->Arg(4)->Arg(8)->UseRealTime();
+
+static void bm_compact_from_json_numbers(benchmark::State& state) {
+    auto const raw = numericArray(1000);
+    for (auto _ : state) {
+        auto var = CompactVariant::fromJson(raw);
+        benchmark::DoNotOptimize(var);
+    }
+    state.counters["bytes"] = static_cast<double>(1000 * sizeof(CompactVariant));
+}
+BENCHMARK(bm_compact_from_json_numbers);
+
+static void bm_var_copy_short_string(benchmark::State& state) {
+    Variant const var("enum_value");
+    auto const start = allocationCount();
+    for (auto _ : state) {
+        Variant copy(var);
+        benchmark::DoNotOptimize(copy);
+    }
+    countAllocations(state, start);
+}
+BENCHMARK(bm_var_copy_short_string);
+
+static void bm_var_copy_tree(benchmark::State& state) {
+    auto const var = Variant::fromJson(R"([
+        {"id": "a1", "name": "alpha", "kind": "user", "state": "active"},
+        {"id": "b2", "name": "beta", "kind": "admin", "state": "locked"},
+        {"id": "c3", "name": "gamma", "kind": "user", "state": "active"},
+        {"id": "d4", "name": "delta", "kind": "guest", "state": "expired"}
+    ])");
+    auto const start = allocationCount();
+    for (auto _ : state) {
+        Variant copy(var);
+        benchmark::DoNotOptimize(copy);
+    }
+    countAllocations(state, start);
+}
+BENCHMARK(bm_var_copy_tree);
+
+static void bm_var_hash_tree(benchmark::State& state) {
+    auto const var = Variant::fromJson(R"([
+        {"id": "a1", "name": "alpha", "kind": "user", "state": "active"},
+        {"id": "b2", "name": "beta", "kind": "admin", "state": "locked"},
+        {"id": "c3", "name": "gamma", "kind": "user", "state": "active"},
+        {"id": "d4", "name": "delta", "kind": "guest", "state": "expired"}
+    ])");
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(var.hash());
+    }
+}
+BENCHMARK(bm_var_hash_tree);
+
+static void bm_map_find(benchmark::State& state) {
+    std::vector<std::string> keys;
+    VariantMap map;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        keys.push_back("field_" + std::to_string(i));
+        map.emplace(keys.back(), Variant(static_cast<int32_t>(i)));
+    }
+    for (auto _ : state) {
+        for (auto const& key : keys) {
+            benchmark::DoNotOptimize(map.find(key));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bm_map_find)->Arg(4)->Arg(12)->Arg(64);
+
+static void bm_frozen_find(benchmark::State& state) {
+    std::vector<std::string> keys;
+    VariantMap map;
+    for (int64_t i = 0; i < state.range(0); ++i) {
+        keys.push_back("field_" + std::to_string(i));
+        map.emplace(keys.back(), Variant(static_cast<int32_t>(i)));
+    }
+    auto const frozen = Variant(map).freeze();
+    for (auto _ : state) {
+        for (auto const& key : keys) {
+            benchmark::DoNotOptimize(frozen.find(key));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(bm_frozen_find)->Arg(4)->Arg(12)->Arg(64);
+
+/// The former `equal()` of maps: sorts pointers to the entries of both sides by key
+static bool sortingEqual(Variant const& lhs, Variant const& rhs) {
+    if (lhs.type() != Variant::TypeTag::map || rhs.type() != Variant::TypeTag::map) {
+        return equal(lhs, rhs);
+    }
+    auto const& lhs_map = lhs.map();
+    auto const& rhs_map = rhs.map();
+    if (lhs_map.size() != rhs_map.size()) {
+        return false;
+    }
+    std::vector<VariantMap::const_pointer> lhs_entries;
+    std::vector<VariantMap::const_pointer> rhs_entries;
+    for (auto const& x : lhs_map) {
+        lhs_entries.push_back(&x);
+    }
+    for (auto const& x : rhs_map) {
+        rhs_entries.push_back(&x);
+    }
+    auto const less = [](auto lhs, auto rhs) { return lhs->first < rhs->first; };
+    std::sort(lhs_entries.begin(), lhs_entries.end(), less);
+    std::sort(rhs_entries.begin(), rhs_entries.end(), less);
+    return std::equal(lhs_entries.begin(), lhs_entries.end(), rhs_entries.begin(),
+                      [](auto lhs, auto rhs) {
+                          return lhs->first == rhs->first
+                              && sortingEqual(lhs->second, rhs->second);
+                      });
+}
+
+/// A map of `width` numbers nested `depth` times, keys in reverse order if `reversed`
+static Variant nestedMap(int64_t width, int64_t depth, bool reversed) {
+    VariantMap map;
+    for (int64_t i = 0; i < width; ++i) {
+        auto const k = reversed ? width - 1 - i : i;
+        map.emplace("field_" + std::to_string(k),
+                    depth > 1 ? nestedMap(width, depth - 1, reversed)
+                              : Variant(static_cast<int32_t>(k)));
+    }
+    return Variant(std::move(map));
+}
+
+/// Arg 0: width, Arg 1: depth, Arg 2: 0 - sorting, 1 - equal(), 2 - operator==
+static void bm_var_equal_maps(benchmark::State& state) {
+    auto const lhs = nestedMap(state.range(0), state.range(1), false);
+    auto const rhs = nestedMap(state.range(0), state.range(1), state.range(2) != 2);
+    auto const start = allocationCount();
+    for (auto _ : state) {
+        switch (state.range(2)) {
+        case 0:
+            benchmark::DoNotOptimize(sortingEqual(lhs, rhs));
+            break;
+        case 1:
+            benchmark::DoNotOptimize(equal(lhs, rhs));
+            break;
+        default:
+            benchmark::DoNotOptimize(lhs == rhs);
+        }
+    }
+    countAllocations(state, start);
+}
+BENCHMARK(bm_var_equal_maps)
+        ->ArgsProduct({{1000}, {1}, {0, 1, 2}})
+        ->ArgsProduct({{4}, {8}, {0, 1, 2}});
+
+/// The former `operator<<` of Variant: writes to the stream token by token
+static void streamTokens(std::ostream& os, Variant const& var) {
+    switch (var.type()) {
+    case Variant::TypeTag::null:
+        os << "Null";
+        break;
+    case Variant::TypeTag::int64:
+        os << var.int64();
+        break;
+    case Variant::TypeTag::double_:
+        os << var.floating();
+        break;
+    case Variant::TypeTag::string:
+        os << var.strView();
+        break;
+    case Variant::TypeTag::vec: {
+        auto const& vec = var.vec();
+        auto const l = vec.size() - 1;
+        std::size_t i = 0;
+        os << "[ ";
+        for (auto const& x : vec) {
+            streamTokens(os, x);
+            os << ((i++ == l) ? " " : ", ");
+        }
+        os << "]";
+        break;
+    }
+    case Variant::TypeTag::map:
+        os << "{ ";
+        for (auto const& [key, x] : var.map()) {
+            os << key << ": ";
+            streamTokens(os, x);
+            os << "; ";
+        }
+        os << "}";
+        break;
+    default:
+        os << var;
+    }
+}
+
+/// Arg 0: the former token by token `operator<<`, 1: `operator<<`, 2: `format` to a
+/// reused Buffer
+static void bm_var_format(benchmark::State& state) {
+    auto const var = Variant::fromJson(R"([
+        {"id": 1, "name": "alpha", "score": 0.25, "tags": ["a", "b"]},
+        {"id": 22, "name": "beta", "score": 12.5, "tags": ["c"]},
+        {"id": 333, "name": "gamma", "score": -3.75, "tags": []},
+        {"id": 4444, "name": "delta", "score": 1e-3, "tags": ["d", "e", "f"]}
+    ])");
+    Buffer buf;
+    std::size_t bytes = 0;
+    for (auto _ : state) {
+        if (state.range(0) == 2) {
+            buf.clear();
+            format(buf, var);
+            bytes += buf.size();
+            benchmark::DoNotOptimize(buf.view().data());
+        } else {
+            std::ostringstream os;
+            if (state.range(0) == 0) {
+                streamTokens(os, var);
+            } else {
+                os << var;
+            }
+            auto const str = os.str();
+            bytes += str.size();
+            benchmark::DoNotOptimize(str.data());
+        }
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+BENCHMARK(bm_var_format)->Arg(0)->Arg(1)->Arg(2);
+
+/// Arg 0: `toJson()` returning a string, 1: `toJson()` into a reused string
+static void bm_var_to_json(benchmark::State& state) {
+    auto const var = Variant::fromJson(R"([
+        {"id": 1, "name": "alpha", "score": 0.25, "tags": ["a", "b"]},
+        {"id": 22, "name": "beta", "score": 12.5, "tags": ["c"]},
+        {"id": 333, "name": "gamma", "score": -3.75, "tags": []},
+        {"id": 4444, "name": "delta", "score": 1e-3, "tags": ["d", "e", "f"]}
+    ])");
+    std::string out;
+    std::size_t bytes = 0;
+    auto const start = allocationCount();
+    for (auto _ : state) {
+        if (state.range(0) == 0) {
+            auto const str = var.toJson();
+            bytes += str.size();
+            benchmark::DoNotOptimize(str.data());
+        } else {
+            var.toJson(out);
+            bytes += out.size();
+            benchmark::DoNotOptimize(out.data());
+        }
+    }
+    countAllocations(state, start);
+    state.SetBytesProcessed(static_cast<int64_t>(bytes));
+}
+BENCHMARK(bm_var_to_json)->Arg(0)->Arg(1);
+
+struct Address : trait::Var<Address> {
+    std::string street;
+    std::string city;
+    int zip;
+};
+
+struct Person : trait::Var<Person> {
+    std::string name;
+    int age;
+    Address address;
+    std::vector<Address> previous;
+    std::map<std::string, std::string> labels;
+};
+
+BOOST_HANA_ADAPT_STRUCT(Address, street, city, zip);
+BOOST_HANA_ADAPT_STRUCT(Person, name, age, address, previous, labels);
+
+static void bm_to_variant_struct(benchmark::State& state) {
+    Person const person{{},
+                        "a person with a name longer than the inline string",
+                        42,
+                        {{}, "Main Street 1", "Springfield", 12345},
+                        {{{}, "Old Street 2", "Shelbyville", 54321},
+                         {{}, "Elm Street 3", "Capital City", 11111}},
+                        {{"team", "core"}, {"role", "maintainer"}}};
+    auto const start = allocationCount();
+    for (auto _ : state) {
+        auto var = toVariant(person);
+        benchmark::DoNotOptimize(var);
+    }
+    countAllocations(state, start);
+}
+BENCHMARK(bm_to_variant_struct);
+
+/// Arg 0: through `Variant`, 1: `fromJson` straight into the struct
+static void bm_struct_from_json(benchmark::State& state) {
+    Person const person{{},
+                        "a person with a name longer than the inline string",
+                        42,
+                        {{}, "Main Street 1", "Springfield", 12345},
+                        {{{}, "Old Street 2", "Shelbyville", 54321},
+                         {{}, "Elm Street 3", "Capital City", 11111}},
+                        {{"team", "core"}, {"role", "maintainer"}}};
+    auto const json = toVariant(person).toJson();
+    auto const start = allocationCount();
+    for (auto _ : state) {
+        if (state.range(0) == 0) {
+            auto x = fromVariant<Person>(Variant::fromJson(json));
+            benchmark::DoNotOptimize(x);
+        } else {
+            auto x = fromJson<Person>(json);
+            benchmark::DoNotOptimize(x);
+        }
+    }
+    countAllocations(state, start);
+}
+BENCHMARK(bm_struct_from_json)->Arg(0)->Arg(1);
+
 BENCHMARK_MAIN();
@@ -0,0 +1,809 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#include <yenxo/compact_variant.hpp>
+#include <yenxo/exception.hpp>
+
+#include <rapidjson/error/en.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/reader.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <atomic>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <utility>
+
+namespace yenxo {
+
+namespace {
+
+/// Heap payload shared by `CompactVariant` copies
+template <class T>
+struct Shared {
+    template <class... Args>
+    explicit Shared(Args&&... args)
+            : value(std::forward<Args>(args)...) {
+    }
+
+    std::atomic<std::size_t> refs{1};
+    T value;
+};
+
+} // namespace
+
+static_assert(sizeof(CompactVariant) == 8);
+static_assert(sizeof(void*) == 8);
+
+struct CompactVariant::Impl {
+    static constexpr uint64_t payload_mask = 0x0000'ffff'ffff'ffff;
+
+    static bool boxed(uint64_t bits) noexcept {
+        return (bits & box_mask) == box_mask;
+    }
+
+    static Box box(uint64_t bits) noexcept {
+        return static_cast<Box>((bits >> 48) & 0x7);
+    }
+
+    static uint64_t make(Box box, uint64_t payload) noexcept {
+        assert((payload & ~payload_mask) == 0);
+        return box_mask | (static_cast<uint64_t>(box) << 48) | payload;
+    }
+
+    /// Box a value of up to 32 bits
+    template <class T>
+    static uint64_t small(TypeTag type, T x) noexcept {
+        static_assert(sizeof(T) <= sizeof(uint32_t));
+        uint32_t bits = 0;
+        std::memcpy(&bits, &x, sizeof(T));
+        return make(Box::small, (static_cast<uint64_t>(type) << 32) | bits);
+    }
+
+    template <class T>
+    static T small(uint64_t bits) noexcept {
+        auto const low = static_cast<uint32_t>(bits);
+        T ret;
+        std::memcpy(&ret, &low, sizeof(T));
+        return ret;
+    }
+
+    template <class T, class... Args>
+    static uint64_t shared(Box box, Args&&... args) {
+        auto const ptr = new Shared<T>(std::forward<Args>(args)...);
+        return make(box, reinterpret_cast<uintptr_t>(ptr));
+    }
+
+    template <class T>
+    static Shared<T>* pointer(uint64_t bits) noexcept {
+        return reinterpret_cast<Shared<T>*>(static_cast<uintptr_t>(bits & payload_mask));
+    }
+
+    template <class T>
+    static T& payload(uint64_t bits) noexcept {
+        return pointer<T>(bits)->value;
+    }
+
+    /// Apply `f` to the `Shared` payload of `bits` if any
+    template <class F>
+    static void withShared(uint64_t bits, F&& f) {
+        if (!boxed(bits)) {
+            return;
+        }
+        switch (box(bits)) {
+        case Box::int64:
+            f(pointer<int64_t>(bits));
+            break;
+        case Box::uint64:
+            f(pointer<uint64_t>(bits));
+            break;
+        case Box::string:
+            f(pointer<std::string>(bits));
+            break;
+        case Box::vec:
+            f(pointer<Vec>(bits));
+            break;
+        case Box::map:
+            f(pointer<Map>(bits));
+            break;
+        default:
+            break;
+        }
+    }
+
+    static void retain(uint64_t bits) noexcept {
+        withShared(bits, [](auto ptr) {
+            ptr->refs.fetch_add(1, std::memory_order_relaxed);
+        });
+    }
+
+    static void release(uint64_t bits) noexcept {
+        withShared(bits, [](auto ptr) {
+            if (ptr->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+                delete ptr;
+            }
+        });
+    }
+
+    /// Give `x` its own `Vec` or `Map` if the current one is shared
+    template <class T>
+    static T& detach(CompactVariant& x) {
+        auto const ptr = pointer<T>(x.bits_);
+        if (ptr->refs.load(std::memory_order_acquire) != 1) {
+            x.bits_ = shared<T>(box(x.bits_), ptr->value);
+            release(make(box(x.bits_), reinterpret_cast<uintptr_t>(ptr)));
+        }
+        return payload<T>(x.bits_);
+    }
+
+    /// The value as a `Variant`, allocates only for a string or a container
+    static Variant scalar(CompactVariant const& x) {
+        switch (x.type()) {
+        case TypeTag::null:
+            return Variant();
+        case TypeTag::boolean:
+            return Variant(small<bool>(x.bits_));
+        case TypeTag::char_:
+            return Variant(small<char>(x.bits_));
+        case TypeTag::int8:
+            return Variant(small<int8_t>(x.bits_));
+        case TypeTag::uint8:
+            return Variant(small<uint8_t>(x.bits_));
+        case TypeTag::int16:
+            return Variant(small<int16_t>(x.bits_));
+        case TypeTag::uint16:
+            return Variant(small<uint16_t>(x.bits_));
+        case TypeTag::int32:
+            return Variant(small<int32_t>(x.bits_));
+        case TypeTag::uint32:
+            return Variant(small<uint32_t>(x.bits_));
+        case TypeTag::int64:
+            return Variant(int64(x.bits_));
+        case TypeTag::uint64:
+            return Variant(uint64(x.bits_));
+        case TypeTag::double_:
+            return Variant(double_(x.bits_));
+        case TypeTag::string:
+            return Variant(payload<std::string>(x.bits_));
+        case TypeTag::vec:
+        case TypeTag::int64_vec:
+        case TypeTag::uint64_vec:
+        case TypeTag::double_vec:
+        case TypeTag::bool_vec:
+            return Variant(Variant::Vec());
+        case TypeTag::map:
+            return Variant(Variant::Map());
+        }
+        assert(false);
+        return Variant();
+    }
+
+    static int64_t int64(uint64_t bits) noexcept {
+        if (box(bits) == Box::int64) {
+            return payload<int64_t>(bits);
+        }
+        // sign extend the 48 bits
+        return static_cast<int64_t>(bits << 16) >> 16;
+    }
+
+    static uint64_t uint64(uint64_t bits) noexcept {
+        if (box(bits) == Box::uint64) {
+            return payload<uint64_t>(bits);
+        }
+        return bits & payload_mask;
+    }
+
+    static double double_(uint64_t bits) noexcept {
+        double ret;
+        std::memcpy(&ret, &bits, sizeof(ret));
+        return ret;
+    }
+
+    /// The elements of a packed `Variant` array
+    template <class T>
+    static Vec array(T const& values) {
+        Vec ret;
+        ret.reserve(values.size());
+        for (auto const x : values) {
+            ret.emplace_back(static_cast<typename T::value_type>(x));
+        }
+        return ret;
+    }
+
+    /// \throw VariantEmpty, VariantBadType unless `x` is of `type`
+    static void expect(CompactVariant const& x, TypeTag type) {
+        if (x.type() == type) {
+            return;
+        }
+        auto const var = scalar(x);
+        switch (type) {
+        case TypeTag::string:
+            var.strView();
+            break;
+        case TypeTag::vec:
+            var.vec();
+            break;
+        case TypeTag::map:
+            var.map();
+            break;
+        default:
+            break;
+        }
+        assert(false);
+    }
+
+    struct FromJson;
+};
+
+CompactVariant::~CompactVariant() noexcept {
+    Impl::release(bits_);
+}
+
+CompactVariant::CompactVariant() noexcept
+        : bits_(null_bits) {
+}
+CompactVariant::CompactVariant(NullType) noexcept
+        : bits_(null_bits) {
+}
+CompactVariant::CompactVariant(bool x) noexcept
+        : bits_(Impl::small(TypeTag::boolean, x)) {
+}
+CompactVariant::CompactVariant(char x) noexcept
+        : bits_(Impl::small(TypeTag::char_, x)) {
+}
+CompactVariant::CompactVariant(int8_t x) noexcept
+        : bits_(Impl::small(TypeTag::int8, x)) {
+}
+CompactVariant::CompactVariant(uint8_t x) noexcept
+        : bits_(Impl::small(TypeTag::uint8, x)) {
+}
+CompactVariant::CompactVariant(int16_t x) noexcept
+        : bits_(Impl::small(TypeTag::int16, x)) {
+}
+CompactVariant::CompactVariant(uint16_t x) noexcept
+        : bits_(Impl::small(TypeTag::uint16, x)) {
+}
+CompactVariant::CompactVariant(int32_t x) noexcept
+        : bits_(Impl::small(TypeTag::int32, x)) {
+}
+CompactVariant::CompactVariant(uint32_t x) noexcept
+        : bits_(Impl::small(TypeTag::uint32, x)) {
+}
+CompactVariant::CompactVariant(int64_t x) {
+    constexpr int64_t limit = int64_t(1) << 47;
+    if (x >= -limit && x < limit) {
+        bits_ = Impl::make(Box::int48, static_cast<uint64_t>(x) & Impl::payload_mask);
+    } else {
+        bits_ = Impl::shared<int64_t>(Box::int64, x);
+    }
+}
+CompactVariant::CompactVariant(uint64_t x) {
+    if (x <= Impl::payload_mask) {
+        bits_ = Impl::make(Box::uint48, x);
+    } else {
+        bits_ = Impl::shared<uint64_t>(Box::uint64, x);
+    }
+}
+CompactVariant::CompactVariant(double x) noexcept {
+    if (std::isnan(x)) {
+        x = std::numeric_limits<double>::quiet_NaN();
+        x = std::copysign(x, 1.0);
+    }
+    std::memcpy(&bits_, &x, sizeof(x));
+    assert(!Impl::boxed(bits_));
+}
+
+CompactVariant::CompactVariant(char const* const& x)
+        : bits_(Impl::shared<std::string>(Box::string, x)) {
+}
+CompactVariant::CompactVariant(std::string const& x)
+        : bits_(Impl::shared<std::string>(Box::string, x)) {
+}
+CompactVariant::CompactVariant(std::string&& x)
+        : bits_(Impl::shared<std::string>(Box::string, std::move(x))) {
+}
+CompactVariant::CompactVariant(std::string_view x)
+        : bits_(Impl::shared<std::string>(Box::string, x)) {
+}
+
+CompactVariant::CompactVariant(Vec const& x)
+        : bits_(Impl::shared<Vec>(Box::vec, x)) {
+}
+CompactVariant::CompactVariant(Vec&& x)
+        : bits_(Impl::shared<Vec>(Box::vec, std::move(x))) {
+}
+
+CompactVariant::CompactVariant(Map const& x)
+        : bits_(Impl::shared<Map>(Box::map, x)) {
+}
+CompactVariant::CompactVariant(Map&& x)
+        : bits_(Impl::shared<Map>(Box::map, std::move(x))) {
+}
+
+CompactVariant::CompactVariant(Variant const& var)
+        : bits_(null_bits) {
+    switch (var.packedType()) {
+    case TypeTag::null:
+        break;
+    case TypeTag::boolean:
+        *this = CompactVariant(var.boolean());
+        break;
+    case TypeTag::char_:
+        *this = CompactVariant(var.character());
+        break;
+    case TypeTag::int8:
+        *this = CompactVariant(var.int8());
+        break;
+    case TypeTag::uint8:
+        *this = CompactVariant(var.uint8());
+        break;
+    case TypeTag::int16:
+        *this = CompactVariant(var.int16());
+        break;
+    case TypeTag::uint16:
+        *this = CompactVariant(var.uint16());
+        break;
+    case TypeTag::int32:
+        *this = CompactVariant(var.int32());
+        break;
+    case TypeTag::uint32:
+        *this = CompactVariant(var.uint32());
+        break;
+    case TypeTag::int64:
+        *this = CompactVariant(var.int64());
+        break;
+    case TypeTag::uint64:
+        *this = CompactVariant(var.uint64());
+        break;
+    case TypeTag::double_:
+        *this = CompactVariant(var.floating());
+        break;
+    case TypeTag::string:
+        *this = CompactVariant(var.strView());
+        break;
+    case TypeTag::vec:
+    // the elements of packed integers keep their own types
+    case TypeTag::int64_vec: {
+        Vec vec;
+        vec.reserve(var.vec().size());
+        for (auto const& x : var.vec()) {
+            vec.emplace_back(x);
+        }
+        *this = CompactVariant(std::move(vec));
+        break;
+    }
+    case TypeTag::uint64_vec:
+        *this = CompactVariant(Impl::array(var.vecAs<uint64_t>()));
+        break;
+    case TypeTag::double_vec:
+        *this = CompactVariant(Impl::array(var.vecAs<double>()));
+        break;
+    case TypeTag::bool_vec:
+        *this = CompactVariant(Impl::array(var.vecAs<bool>()));
+        break;
+    case TypeTag::map: {
+        Map map;
+        map.reserve(var.map().size());
+        for (auto const& [key, value] : var.map()) {
+            map.try_emplace(key, value);
+        }
+        *this = CompactVariant(std::move(map));
+        break;
+    }
+    }
+}
+
+CompactVariant::CompactVariant(CompactVariant const& rhs) noexcept
+        : bits_(rhs.bits_) {
+    Impl::retain(bits_);
+}
+
+CompactVariant& CompactVariant::operator=(CompactVariant const& rhs) noexcept {
+    Impl::retain(rhs.bits_);
+    Impl::release(bits_);
+    bits_ = rhs.bits_;
+    return *this;
+}
+
+CompactVariant::CompactVariant(CompactVariant&& rhs) noexcept
+        : bits_(rhs.bits_) {
+    rhs.bits_ = null_bits;
+}
+
+CompactVariant& CompactVariant::operator=(CompactVariant&& rhs) noexcept {
+    std::swap(bits_, rhs.bits_);
+    return *this;
+}
+
+Variant CompactVariant::expand() const {
+    switch (type()) {
+    case TypeTag::vec: {
+        auto const& vec = Impl::payload<Vec>(bits_);
+        Variant::Vec ret;
+        ret.reserve(vec.size());
+        for (auto const& x : vec) {
+            ret.push_back(x.expand());
+        }
+        return Variant(std::move(ret));
+    }
+    case TypeTag::map: {
+        auto const& map = Impl::payload<Map>(bits_);
+        Variant::Map ret;
+        ret.reserve(map.size());
+        for (auto const& [key, value] : map) {
+            ret.try_emplace(key, value.expand());
+        }
+        return Variant(std::move(ret));
+    }
+    default:
+        return Impl::scalar(*this);
+    }
+}
+
+CompactVariant::TypeTag CompactVariant::type() const noexcept {
+    if (!Impl::boxed(bits_)) {
+        return TypeTag::double_;
+    }
+    switch (Impl::box(bits_)) {
+    case Box::small:
+        return static_cast<TypeTag>((bits_ >> 32) & 0xff);
+    case Box::int48:
+    case Box::int64:
+        return TypeTag::int64;
+    case Box::uint48:
+    case Box::uint64:
+        return TypeTag::uint64;
+    case Box::string:
+        return TypeTag::string;
+    case Box::vec:
+        return TypeTag::vec;
+    case Box::map:
+        return TypeTag::map;
+    }
+    assert(false);
+    return TypeTag::null;
+}
+
+bool CompactVariant::boolean() const {
+    return Impl::scalar(*this).boolean();
+}
+char CompactVariant::character() const {
+    return Impl::scalar(*this).character();
+}
+int8_t CompactVariant::int8() const {
+    return Impl::scalar(*this).int8();
+}
+uint8_t CompactVariant::uint8() const {
+    return Impl::scalar(*this).uint8();
+}
+int16_t CompactVariant::int16() const {
+    return Impl::scalar(*this).int16();
+}
+uint16_t CompactVariant::uint16() const {
+    return Impl::scalar(*this).uint16();
+}
+int32_t CompactVariant::int32() const {
+    return Impl::scalar(*this).int32();
+}
+uint32_t CompactVariant::uint32() const {
+    return Impl::scalar(*this).uint32();
+}
+int64_t CompactVariant::int64() const {
+    return Impl::scalar(*this).int64();
+}
+uint64_t CompactVariant::uint64() const {
+    return Impl::scalar(*this).uint64();
+}
+double CompactVariant::floating() const {
+    if (!Impl::boxed(bits_)) {
+        return Impl::double_(bits_);
+    }
+    return Impl::scalar(*this).floating();
+}
+
+bool CompactVariant::booleanOr(bool x) const {
+    return Impl::scalar(*this).booleanOr(x);
+}
+char CompactVariant::characterOr(char x) const {
+    return Impl::scalar(*this).characterOr(x);
+}
+int8_t CompactVariant::int8Or(int8_t x) const {
+    return Impl::scalar(*this).int8Or(x);
+}
+uint8_t CompactVariant::uint8Or(uint8_t x) const {
+    return Impl::scalar(*this).uint8Or(x);
+}
+int16_t CompactVariant::int16Or(int16_t x) const {
+    return Impl::scalar(*this).int16Or(x);
+}
+uint16_t CompactVariant::uint16Or(uint16_t x) const {
+    return Impl::scalar(*this).uint16Or(x);
+}
+int32_t CompactVariant::int32Or(int32_t x) const {
+    return Impl::scalar(*this).int32Or(x);
+}
+uint32_t CompactVariant::uint32Or(uint32_t x) const {
+    return Impl::scalar(*this).uint32Or(x);
+}
+int64_t CompactVariant::int64Or(int64_t x) const {
+    return Impl::scalar(*this).int64Or(x);
+}
+uint64_t CompactVariant::uint64Or(uint64_t x) const {
+    return Impl::scalar(*this).uint64Or(x);
+}
+double CompactVariant::floatingOr(double x) const {
+    return Impl::scalar(*this).floatingOr(x);
+}
+
+std::string_view CompactVariant::str() const {
+    Impl::expect(*this, TypeTag::string);
+    return Impl::payload<std::string>(bits_);
+}
+
+std::string CompactVariant::strOr(std::string const& x) const {
+    return null() ? x : std::string(str());
+}
+
+CompactVariant::Vec const& CompactVariant::vec() const {
+    Impl::expect(*this, TypeTag::vec);
+    return Impl::payload<Vec>(bits_);
+}
+
+CompactVariant::Vec& CompactVariant::modifyVec() {
+    Impl::expect(*this, TypeTag::vec);
+    return Impl::detach<Vec>(*this);
+}
+
+CompactVariant::Map const& CompactVariant::map() const {
+    Impl::expect(*this, TypeTag::map);
+    return Impl::payload<Map>(bits_);
+}
+
+CompactVariant::Map& CompactVariant::modifyMap() {
+    Impl::expect(*this, TypeTag::map);
+    return Impl::detach<Map>(*this);
+}
+
+#if defined(__GNUG__) || defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal" // safe comparation
+bool CompactVariant::operator==(CompactVariant const& rhs) const noexcept {
+    if (bits_ == rhs.bits_) {
+        // NaN is canonical, so only the NaNs are off
+        return Impl::boxed(bits_) || !std::isnan(Impl::double_(bits_));
+    }
+    auto const type = this->type();
+    if (type != rhs.type()) {
+        return false;
+    }
+    switch (type) {
+    case TypeTag::int64:
+        return Impl::int64(bits_) == Impl::int64(rhs.bits_);
+    case TypeTag::uint64:
+        return Impl::uint64(bits_) == Impl::uint64(rhs.bits_);
+    case TypeTag::double_:
+        return Impl::double_(bits_) == Impl::double_(rhs.bits_);
+    case TypeTag::string:
+        return Impl::payload<std::string>(bits_) == Impl::payload<std::string>(rhs.bits_);
+    case TypeTag::vec:
+        return Impl::payload<Vec>(bits_) == Impl::payload<Vec>(rhs.bits_);
+    case TypeTag::map:
+        return Impl::payload<Map>(bits_) == Impl::payload<Map>(rhs.bits_);
+    default:
+        return false;
+    }
+}
+#pragma GCC diagnostic pop
+#else
+#error The compiler not supported
+#endif
+
+bool CompactVariant::operator!=(CompactVariant const& rhs) const noexcept {
+    return !(*this == rhs);
+}
+
+/// RapidJSON visitor
+struct CompactVariant::Impl::FromJson
+        : rapidjson::BaseReaderHandler<rapidjson::UTF8<>, FromJson> {
+    template <class T>
+    bool val(T&& x) {
+        auto& top = *ptrs.back();
+        switch (top.type()) {
+        case TypeTag::map:
+            top.modifyMap()[std::move(key)] = CompactVariant(std::forward<T>(x));
+            break;
+        case TypeTag::vec:
+            top.modifyVec().emplace_back(std::forward<T>(x));
+            break;
+        default:
+            top = CompactVariant(std::forward<T>(x));
+        }
+        return true;
+    }
+
+    /// Add an empty container and descend into it
+    template <class T>
+    bool open() {
+        auto& top = *ptrs.back();
+        switch (top.type()) {
+        case TypeTag::map:
+            ptrs.push_back(&(top.modifyMap()[std::move(key)] = CompactVariant(T())));
+            break;
+        case TypeTag::vec:
+            ptrs.push_back(&top.modifyVec().emplace_back(T()));
+            break;
+        default:
+            top = CompactVariant(T());
+            ptrs.push_back(&top);
+        }
+        return true;
+    }
+
+    bool Null() {
+        return val(NullType());
+    }
+    bool Bool(bool b) {
+        return val(b);
+    }
+    bool Int(int32_t i) {
+        return val(i);
+    }
+    bool Uint(uint32_t u) {
+        return val(u);
+    }
+    bool Int64(int64_t i64) {
+        return val(i64);
+    }
+    bool Uint64(uint64_t u64) {
+        return val(u64);
+    }
+    bool Double(double d) {
+        return val(d);
+    }
+    bool String(char const* str, rapidjson::SizeType length, bool) {
+        return val(std::string_view(str, length));
+    }
+    bool StartObject() {
+        return open<Map>();
+    }
+    bool Key(char const* str, rapidjson::SizeType length, bool) {
+        std::string_view const view(str, length);
+        auto it = keys.find(view);
+        if (it == keys.end()) {
+            it = keys.try_emplace(view).first;
+        }
+        key = it->first;
+        return true;
+    }
+    bool EndObject(rapidjson::SizeType) {
+        ptrs.pop_back();
+        return true;
+    }
+    bool StartArray() {
+        return open<Vec>();
+    }
+    bool EndArray(rapidjson::SizeType) {
+        ptrs.pop_back();
+        return true;
+    }
+
+    CompactVariant var;
+    std::vector<CompactVariant*> ptrs{&var};
+    Map::key_type key;
+    /// Keys seen by this parse, saves the pool lookup on repeated keys
+    StringMap<NullType> keys;
+};
+
+CompactVariant CompactVariant::fromJson(std::string const& json) {
+    Impl::FromJson handler;
+    rapidjson::Reader reader;
+    rapidjson::StringStream ss(json.c_str());
+    reader.Parse(ss, handler);
+    if (reader.HasParseError()) {
+        throw std::runtime_error(rapidjson::GetParseError_En(reader.GetParseErrorCode()));
+    }
+    return std::move(handler.var);
+}
+
+namespace {
+
+template <class Handler>
+void write(Handler& dst, CompactVariant const& x) {
+    using TypeTag = CompactVariant::TypeTag;
+    switch (x.type()) {
+    case TypeTag::null:
+        dst.Null();
+        break;
+    case TypeTag::boolean:
+        dst.Bool(x.boolean());
+        break;
+    case TypeTag::char_:
+    case TypeTag::int8:
+    case TypeTag::int16:
+    case TypeTag::int32:
+        dst.Int(x.int32());
+        break;
+    case TypeTag::uint8:
+    case TypeTag::uint16:
+    case TypeTag::uint32:
+        dst.Uint(x.uint32());
+        break;
+    case TypeTag::int64:
+        dst.Int64(x.int64());
+        break;
+    case TypeTag::uint64:
+        dst.Uint64(x.uint64());
+        break;
+    case TypeTag::double_:
+        dst.Double(x.floating());
+        break;
+    case TypeTag::string: {
+        auto const str = x.str();
+        dst.String(str.data(), static_cast<rapidjson::SizeType>(str.size()), true);
+        break;
+    }
+    case TypeTag::vec:
+    case TypeTag::int64_vec:
+    case TypeTag::uint64_vec:
+    case TypeTag::double_vec:
+    case TypeTag::bool_vec:
+        dst.StartArray();
+        for (auto const& y : x.vec()) {
+            write(dst, y);
+        }
+        dst.EndArray(static_cast<rapidjson::SizeType>(x.vec().size()));
+        break;
+    case TypeTag::map:
+        dst.StartObject();
+        for (auto const& [key, value] : x.map()) {
+            dst.Key(key.c_str(), static_cast<rapidjson::SizeType>(key.size()), true);
+            write(dst, value);
+        }
+        dst.EndObject(static_cast<rapidjson::SizeType>(x.map().size()));
+        break;
+    }
+}
+
+} // namespace
+
+std::string CompactVariant::toJson() const {
+    rapidjson::StringBuffer sb;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+    write(writer, *this);
+    return sb.GetString();
+}
+
+std::string CompactVariant::toPrettyJson() const {
+    rapidjson::StringBuffer sb;
+    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(sb);
+    write(writer, *this);
+    return sb.GetString();
+}
+
+} // namespace yenxo
@@ -0,0 +1,125 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <yenxo/format.hpp>
+#include <yenxo/variant.hpp>
+
+#include <ostream>
+
+namespace yenxo {
+
+namespace {
+
+template <class Vec>
+void formatArray(Buffer& buf, Vec const& vec) {
+    buf.append("[ ");
+    bool first = true;
+    for (auto const& x : vec) {
+        if (!first) {
+            buf.append(", ");
+        }
+        first = false;
+        format(buf, static_cast<typename Vec::value_type const&>(x));
+    }
+    buf.append(vec.empty() ? "]" : " ]");
+}
+
+} // namespace
+
+void FormatImpl<Variant>::apply(Buffer& buf, Variant const& var) {
+    using TypeTag = Variant::TypeTag;
+    switch (var.packedType()) {
+    case TypeTag::null:
+        buf.append("Null");
+        break;
+    case TypeTag::boolean:
+        format(buf, var.boolean());
+        break;
+    case TypeTag::char_:
+        format(buf, var.character());
+        break;
+    case TypeTag::int8:
+        format(buf, var.int8());
+        break;
+    case TypeTag::uint8:
+        format(buf, var.uint8());
+        break;
+    case TypeTag::int16:
+        format(buf, var.int16());
+        break;
+    case TypeTag::uint16:
+        format(buf, var.uint16());
+        break;
+    case TypeTag::int32:
+        format(buf, var.int32());
+        break;
+    case TypeTag::uint32:
+        format(buf, var.uint32());
+        break;
+    case TypeTag::int64:
+        format(buf, var.int64());
+        break;
+    case TypeTag::uint64:
+        format(buf, var.uint64());
+        break;
+    case TypeTag::double_:
+        format(buf, var.floating());
+        break;
+    case TypeTag::string:
+        buf.append(var.strView());
+        break;
+    case TypeTag::vec:
+    // the elements of packed integers keep their own types, e.g. `char`
+    case TypeTag::int64_vec:
+        formatArray(buf, var.vec());
+        break;
+    case TypeTag::map:
+        buf.append("{ ");
+        for (auto const& [key, x] : var.map()) {
+            buf.append(key.view());
+            buf.append(": ");
+            apply(buf, x);
+            buf.append("; ");
+        }
+        buf.push_back('}');
+        break;
+    case TypeTag::uint64_vec:
+        formatArray(buf, var.vecAs<uint64_t>());
+        break;
+    case TypeTag::double_vec:
+        formatArray(buf, var.vecAs<double>());
+        break;
+    case TypeTag::bool_vec:
+        formatArray(buf, var.vecAs<bool>());
+        break;
+    }
+}
+
+std::ostream& operator<<(std::ostream& os, Variant const& var) {
+    Buffer buf(os);
+    format(buf, var);
+    return os << buf.view();
+}
+
+} // namespace yenxo
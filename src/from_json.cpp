@@ -0,0 +1,296 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#include <yenxo/exception.hpp>
+#include <yenxo/from_json.hpp>
+#include <yenxo/interned_key.hpp>
+
+#include <rapidjson/error/en.h>
+#include <rapidjson/memorystream.h>
+#include <rapidjson/reader.h>
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace yenxo::detail {
+
+namespace {
+
+/// RapidJSON handler writing the values through the `JsonReader`s of their slots
+///
+/// A value whose reader lacks the operation of the event is built as a `Variant` tree
+/// and assigned once complete.
+class Handler : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, Handler> {
+public:
+    explicit Handler(JsonSlot root) noexcept
+            : root_(root) {
+    }
+
+    bool Null() {
+        return scalar(Variant(Variant::NullType()));
+    }
+    bool Bool(bool x) {
+        return scalar(Variant(x));
+    }
+    bool Int(int32_t x) {
+        return scalar(Variant(x));
+    }
+    bool Uint(uint32_t x) {
+        return scalar(Variant(x));
+    }
+    bool Int64(int64_t x) {
+        return scalar(Variant(x));
+    }
+    bool Uint64(uint64_t x) {
+        return scalar(Variant(x));
+    }
+    bool Double(double x) {
+        return scalar(Variant(x));
+    }
+    bool String(char const* str, rapidjson::SizeType length, bool) {
+        std::string_view const x(str, length);
+        return guard([&] {
+            if (skip_ != 0) {
+                return;
+            }
+            if (!tree_.empty()) {
+                add(Variant(x));
+                return;
+            }
+            auto const slot = next();
+            if (!slot.reader) {
+                return;
+            }
+            if (slot.reader->string) {
+                slot.reader->string(slot.obj, x);
+            } else {
+                slot.reader->assign(slot.obj, Variant(x));
+            }
+        });
+    }
+    bool StartObject() {
+        return guard([&] { start(true); });
+    }
+    bool Key(char const* str, rapidjson::SizeType length, bool) {
+        std::string_view const x(str, length);
+        return guard([&] {
+            if (skip_ != 0) {
+                return;
+            }
+            if (!tree_.empty()) {
+                key_ = InternedKey(x);
+                return;
+            }
+            auto& top = frames_.back();
+            // an unknown key is reported at the object
+            top.name = {};
+            top.pending = top.slot.reader->member(top.slot.obj, x, top.state);
+            top.name = top.pending.name;
+        });
+    }
+    bool EndObject(rapidjson::SizeType) {
+        return guard([&] { end(); });
+    }
+    bool StartArray() {
+        return guard([&] { start(false); });
+    }
+    bool EndArray(rapidjson::SizeType) {
+        return guard([&] { end(); });
+    }
+
+private:
+    struct Frame {
+        JsonSlot slot;
+        bool object;
+        JsonObjectState state;
+        /// Number of the elements of an array met so far
+        std::size_t index;
+        /// Path element of the current member of an object
+        std::string_view name;
+        /// Slot of the current member of an object
+        JsonSlot pending;
+    };
+
+    /// The slot of the value starting now
+    JsonSlot next() {
+        JsonSlot ret;
+        if (frames_.empty()) {
+            ret = root_;
+        } else if (auto& top = frames_.back(); top.object) {
+            ret = top.pending;
+        } else {
+            ++top.index;
+            ret = top.slot.reader->element(top.slot.obj);
+        }
+        while (ret.reader && ret.reader->unwrap) {
+            auto const name = ret.name;
+            ret = ret.reader->unwrap(ret.obj);
+            ret.name = name;
+        }
+        return ret;
+    }
+
+    bool scalar(Variant&& x) {
+        return guard([&] {
+            if (skip_ != 0) {
+                return;
+            }
+            if (!tree_.empty()) {
+                add(std::move(x));
+                return;
+            }
+            auto const slot = next();
+            if (slot.reader) {
+                slot.reader->assign(slot.obj, x);
+            }
+        });
+    }
+
+    void start(bool object) {
+        if (skip_ != 0) {
+            ++skip_;
+            return;
+        }
+        auto container = [object] {
+            return object ? Variant(Variant::Map()) : Variant(Variant::Vec());
+        };
+        if (!tree_.empty()) {
+            tree_.push_back(add(container()));
+            return;
+        }
+
+        auto const slot = next();
+        if (!slot.reader) {
+            skip_ = 1;
+            return;
+        }
+        auto const begin = object ? slot.reader->startObject : slot.reader->startArray;
+        if (!begin) {
+            tree_root_ = container();
+            tree_.push_back(&tree_root_);
+            tree_slot_ = slot;
+            return;
+        }
+        frames_.push_back({slot, object, {}, 0, {}, {}});
+        begin(slot.obj);
+    }
+
+    void end() {
+        if (skip_ != 0) {
+            --skip_;
+            return;
+        }
+        if (!tree_.empty()) {
+            tree_.pop_back();
+            if (tree_.empty()) {
+                tree_slot_.reader->assign(tree_slot_.obj, tree_root_);
+            }
+            return;
+        }
+
+        // the object reports the missing members with the path of its parent
+        auto const frame = frames_.back();
+        frames_.pop_back();
+        if (frame.object) {
+            frame.slot.reader->endObject(frame.slot.obj, frame.state);
+        }
+    }
+
+    /// Add `x` to the `Variant` tree being built
+    Variant* add(Variant&& x) {
+        auto& top = *tree_.back();
+        if (top.type() == Variant::TypeTag::map) {
+            return &(top.modifyMap()[std::move(key_)] = std::move(x));
+        }
+        auto& vec = top.modifyVec();
+        vec.push_back(std::move(x));
+        return &vec.back();
+    }
+
+    /// Run `f`, the errors get the path of the current value like from `fromVariant`
+    template <class F>
+    bool guard(F&& f) {
+        try {
+            f();
+        } catch (VariantErr& e) {
+            prependPath(e);
+            throw;
+        } catch (std::exception const& e) {
+            if (!hasPath()) {
+                throw;
+            }
+            VariantErr err(e.what());
+            prependPath(err);
+            throw err;
+        }
+        return true;
+    }
+
+    bool hasPath() const noexcept {
+        for (auto const& x : frames_) {
+            if (x.object ? !x.name.empty() : x.index != 0) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    void prependPath(VariantErr& e) const {
+        for (auto i = frames_.size(); i-- > 0;) {
+            auto const& x = frames_[i];
+            if (x.object && !x.name.empty()) {
+                e.prependPath(std::string(x.name));
+            } else if (!x.object && x.index != 0) {
+                e.prependPath(std::to_string(x.index - 1));
+            }
+        }
+    }
+
+    JsonSlot root_;
+    std::vector<Frame> frames_;
+    /// Depth of the skipped value of an unknown member
+    std::size_t skip_{0};
+
+    /// The value converted through `Variant`, its containers and its slot
+    Variant tree_root_;
+    std::vector<Variant*> tree_;
+    JsonSlot tree_slot_{};
+    InternedKey key_;
+};
+
+} // namespace
+
+void parseJsonInto(std::string_view json, JsonSlot root) {
+    Handler handler(root);
+    rapidjson::Reader reader;
+    rapidjson::MemoryStream ms(json.data(), json.size());
+    reader.Parse(ms, handler);
+    if (reader.HasParseError()) {
+        throw std::runtime_error(rapidjson::GetParseError_En(reader.GetParseErrorCode()));
+    }
+}
+
+} // namespace yenxo::detail
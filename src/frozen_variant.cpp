@@ -0,0 +1,669 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#include <yenxo/exception.hpp>
+#include <yenxo/frozen_variant.hpp>
+
+#include <rapidjson/error/en.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/reader.h>
+#include <rapidjson/stringbuffer.h>
+#include <rapidjson/writer.h>
+
+#include <algorithm>
+#include <cassert>
+#include <cstring>
+#include <limits>
+#include <new>
+#include <stdexcept>
+#include <vector>
+
+namespace yenxo {
+
+namespace {
+
+using TypeTag = Variant::TypeTag;
+
+bool isScalar(TypeTag x) noexcept {
+    // the scalar tags precede `string`
+    return x < TypeTag::string;
+}
+
+} // namespace
+
+FrozenRef::FrozenRef() noexcept
+        : tape_(nullptr) {
+    static constexpr Node null{TypeTag::null, 0, {}};
+    node_ = &null;
+}
+
+Variant FrozenRef::scalar() const {
+    switch (node_->type) {
+    case TypeTag::null:
+        return Variant();
+    case TypeTag::boolean:
+        return Variant(node_->value.bool_);
+    case TypeTag::char_:
+        return Variant(node_->value.char_);
+    case TypeTag::int8:
+        return Variant(node_->value.int8);
+    case TypeTag::uint8:
+        return Variant(node_->value.uint8);
+    case TypeTag::int16:
+        return Variant(node_->value.int16);
+    case TypeTag::uint16:
+        return Variant(node_->value.uint16);
+    case TypeTag::int32:
+        return Variant(node_->value.int32);
+    case TypeTag::uint32:
+        return Variant(node_->value.uint32);
+    case TypeTag::int64:
+        return Variant(node_->value.int64);
+    case TypeTag::uint64:
+        return Variant(node_->value.uint64);
+    case TypeTag::double_:
+        return Variant(node_->value.double_);
+    case TypeTag::string:
+        return Variant(string(*node_));
+    case TypeTag::vec:
+    case TypeTag::int64_vec:
+    case TypeTag::uint64_vec:
+    case TypeTag::double_vec:
+    case TypeTag::bool_vec:
+        // the tape stores the packed arrays as `vec`
+        return Variant(Variant::Vec());
+    case TypeTag::map:
+        return Variant(Variant::Map());
+    }
+    assert(false);
+    return Variant();
+}
+
+void FrozenRef::expect(TypeTag type) const {
+    if (node_->type == type) {
+        return;
+    }
+    switch (type) {
+    case TypeTag::string:
+        scalar().strView();
+        break;
+    case TypeTag::vec:
+        scalar().vec();
+        break;
+    case TypeTag::map:
+        scalar().map();
+        break;
+    default:
+        break;
+    }
+    assert(false);
+}
+
+bool FrozenRef::boolean() const {
+    return scalar().boolean();
+}
+char FrozenRef::character() const {
+    return scalar().character();
+}
+int8_t FrozenRef::int8() const {
+    return scalar().int8();
+}
+uint8_t FrozenRef::uint8() const {
+    return scalar().uint8();
+}
+int16_t FrozenRef::int16() const {
+    return scalar().int16();
+}
+uint16_t FrozenRef::uint16() const {
+    return scalar().uint16();
+}
+int32_t FrozenRef::int32() const {
+    return scalar().int32();
+}
+uint32_t FrozenRef::uint32() const {
+    return scalar().uint32();
+}
+int64_t FrozenRef::int64() const {
+    return scalar().int64();
+}
+uint64_t FrozenRef::uint64() const {
+    return scalar().uint64();
+}
+double FrozenRef::floating() const {
+    return scalar().floating();
+}
+
+std::string_view FrozenRef::str() const {
+    expect(TypeTag::string);
+    return string(*node_);
+}
+
+FrozenRef::Range<FrozenRef> FrozenRef::vec() const {
+    expect(TypeTag::vec);
+    auto const first = children();
+    return Range<FrozenRef>(Iterator<FrozenRef>(tape_, first),
+                            Iterator<FrozenRef>(tape_, first + node_->size),
+                            node_->size);
+}
+
+FrozenRef::Range<FrozenRef::Member> FrozenRef::map() const {
+    expect(TypeTag::map);
+    auto const first = children();
+    return Range<Member>(Iterator<Member>(tape_, first),
+                         Iterator<Member>(tape_, first + 2 * std::size_t(node_->size)),
+                         node_->size);
+}
+
+FrozenRef FrozenRef::at(std::size_t i) const {
+    expect(TypeTag::vec);
+    if (i >= node_->size) {
+        throw std::out_of_range("FrozenRef::at");
+    }
+    return FrozenRef(tape_, children() + i);
+}
+
+FrozenRef FrozenRef::at(std::string_view key) const {
+    if (auto const ret = find(key)) {
+        return *ret;
+    }
+    throw std::out_of_range("FrozenRef::at");
+}
+
+std::optional<FrozenRef> FrozenRef::find(std::string_view key) const {
+    expect(TypeTag::map);
+    auto const first = children();
+    std::size_t lo = 0;
+    std::size_t hi = node_->size;
+    while (lo < hi) {
+        auto const mid = lo + (hi - lo) / 2;
+        auto const cmp = string(first[2 * mid]).compare(key);
+        if (cmp == 0) {
+            return FrozenRef(tape_, first + 2 * mid + 1);
+        }
+        if (cmp < 0) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return std::nullopt;
+}
+
+Variant FrozenRef::thaw() const {
+    switch (node_->type) {
+    case TypeTag::vec: {
+        Variant::Vec ret;
+        ret.reserve(node_->size);
+        for (auto const x : vec()) {
+            ret.push_back(x.thaw());
+        }
+        return Variant(std::move(ret));
+    }
+    case TypeTag::map: {
+        Variant::Map ret;
+        ret.reserve(node_->size);
+        for (auto const& [key, value] : map()) {
+            ret.try_emplace(key, value.thaw());
+        }
+        return Variant(std::move(ret));
+    }
+    default:
+        return scalar();
+    }
+}
+
+namespace {
+
+template <class Handler>
+void write(Handler& dst, FrozenRef x) {
+    switch (x.type()) {
+    case TypeTag::null:
+        dst.Null();
+        break;
+    case TypeTag::boolean:
+        dst.Bool(x.boolean());
+        break;
+    case TypeTag::char_:
+    case TypeTag::int8:
+    case TypeTag::int16:
+    case TypeTag::int32:
+        dst.Int(x.int32());
+        break;
+    case TypeTag::uint8:
+    case TypeTag::uint16:
+    case TypeTag::uint32:
+        dst.Uint(x.uint32());
+        break;
+    case TypeTag::int64:
+        dst.Int64(x.int64());
+        break;
+    case TypeTag::uint64:
+        dst.Uint64(x.uint64());
+        break;
+    case TypeTag::double_:
+        dst.Double(x.floating());
+        break;
+    case TypeTag::string: {
+        auto const str = x.str();
+        dst.String(str.data(), static_cast<rapidjson::SizeType>(str.size()), true);
+        break;
+    }
+    case TypeTag::vec:
+    case TypeTag::int64_vec:
+    case TypeTag::uint64_vec:
+    case TypeTag::double_vec:
+    case TypeTag::bool_vec:
+        dst.StartArray();
+        for (auto const y : x.vec()) {
+            write(dst, y);
+        }
+        dst.EndArray(static_cast<rapidjson::SizeType>(x.size()));
+        break;
+    case TypeTag::map:
+        dst.StartObject();
+        for (auto const& [key, value] : x.map()) {
+            dst.Key(key.data(), static_cast<rapidjson::SizeType>(key.size()), true);
+            write(dst, value);
+        }
+        dst.EndObject(static_cast<rapidjson::SizeType>(x.size()));
+        break;
+    }
+}
+
+} // namespace
+
+std::string FrozenRef::toJson() const {
+    rapidjson::StringBuffer sb;
+    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
+    write(writer, *this);
+    return sb.GetString();
+}
+
+std::string FrozenRef::toPrettyJson() const {
+    rapidjson::StringBuffer sb;
+    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(sb);
+    write(writer, *this);
+    return sb.GetString();
+}
+
+bool equal(FrozenRef lhs, FrozenRef rhs) {
+    if (isScalar(lhs.type()) && isScalar(rhs.type())) {
+        return equal(lhs.scalar(), rhs.scalar());
+    }
+    if (lhs.type() != rhs.type() || lhs.size() != rhs.size()) {
+        return false;
+    }
+    switch (lhs.type()) {
+    case TypeTag::string:
+        return lhs.str() == rhs.str();
+    case TypeTag::vec: {
+        auto const lhs_vec = lhs.vec();
+        auto const rhs_vec = rhs.vec();
+        return std::equal(
+                lhs_vec.begin(), lhs_vec.end(), rhs_vec.begin(), [](auto x, auto y) {
+                    return equal(x, y);
+                });
+    }
+    case TypeTag::map: {
+        // both ordered by key
+        auto const lhs_map = lhs.map();
+        auto const rhs_map = rhs.map();
+        return std::equal(lhs_map.begin(),
+                          lhs_map.end(),
+                          rhs_map.begin(),
+                          [](auto const& x, auto const& y) {
+                              return x.first == y.first && equal(x.second, y.second);
+                          });
+    }
+    default:
+        return false;
+    }
+}
+
+bool equal(FrozenRef lhs, Variant const& rhs) {
+    if (isScalar(lhs.type()) && isScalar(rhs.type())) {
+        return equal(lhs.scalar(), rhs);
+    }
+    if (lhs.type() != (rhs.isVec() ? TypeTag::vec : rhs.type())) {
+        return false;
+    }
+    switch (lhs.type()) {
+    case TypeTag::string:
+        return lhs.str() == rhs.strView();
+    case TypeTag::vec: {
+        auto const& rhs_vec = rhs.vec();
+        auto const lhs_vec = lhs.vec();
+        return lhs.size() == rhs_vec.size()
+            && std::equal(lhs_vec.begin(),
+                          lhs_vec.end(),
+                          rhs_vec.begin(),
+                          [](auto x, auto const& y) {
+                              return equal(x, y);
+                          });
+    }
+    case TypeTag::map: {
+        auto const& rhs_map = rhs.map();
+        return lhs.size() == rhs_map.size()
+            && std::all_of(rhs_map.begin(), rhs_map.end(), [&](auto const& x) {
+                   auto const y = lhs.find(x.first.view());
+                   return y && equal(*y, x.second);
+               });
+    }
+    default:
+        return false;
+    }
+}
+
+bool equal(Variant const& lhs, FrozenRef rhs) {
+    return equal(rhs, lhs);
+}
+
+/// Lays the nodes out while receiving RapidJSON SAX events or walking a `Variant`
+///
+/// The children of an open container are collected on a level of their own and moved
+/// to the tape at once when the container is closed, so the containers follow their
+/// children and the root node is kept in front.
+struct FrozenVariant::Builder
+        : rapidjson::BaseReaderHandler<rapidjson::UTF8<>, FrozenVariant::Builder> {
+    template <class T>
+    void scalar(TypeTag type, T Node::Value::*member, T x) {
+        Node node{type, 0, {}};
+        node.value.*member = x;
+        add(node);
+    }
+
+    bool Null() {
+        add(Node{TypeTag::null, 0, {}});
+        return true;
+    }
+    bool Bool(bool x) {
+        scalar(TypeTag::boolean, &Node::Value::bool_, x);
+        return true;
+    }
+    bool Int(int32_t x) {
+        scalar(TypeTag::int32, &Node::Value::int32, x);
+        return true;
+    }
+    bool Uint(uint32_t x) {
+        scalar(TypeTag::uint32, &Node::Value::uint32, x);
+        return true;
+    }
+    bool Int64(int64_t x) {
+        scalar(TypeTag::int64, &Node::Value::int64, x);
+        return true;
+    }
+    bool Uint64(uint64_t x) {
+        scalar(TypeTag::uint64, &Node::Value::uint64, x);
+        return true;
+    }
+    bool Double(double x) {
+        scalar(TypeTag::double_, &Node::Value::double_, x);
+        return true;
+    }
+    bool String(char const* str, rapidjson::SizeType length, bool) {
+        add(string(std::string_view(str, length)));
+        return true;
+    }
+    bool Key(char const* str, rapidjson::SizeType length, bool) {
+        std::string_view const view(str, length);
+        auto it = keys.find(view);
+        if (it == keys.end()) {
+            it = keys.try_emplace(view, string(view)).first;
+        }
+        add(it->second);
+        return true;
+    }
+    bool StartObject() {
+        open();
+        return true;
+    }
+    bool EndObject(rapidjson::SizeType) {
+        close(TypeTag::map);
+        return true;
+    }
+    bool StartArray() {
+        open();
+        return true;
+    }
+    bool EndArray(rapidjson::SizeType) {
+        close(TypeTag::vec);
+        return true;
+    }
+
+    void add(Variant const& x) {
+        switch (x.packedType()) {
+        case TypeTag::null:
+            Null();
+            break;
+        case TypeTag::boolean:
+            Bool(x.boolean());
+            break;
+        case TypeTag::char_:
+            scalar(TypeTag::char_, &Node::Value::char_, x.character());
+            break;
+        case TypeTag::int8:
+            scalar(TypeTag::int8, &Node::Value::int8, x.int8());
+            break;
+        case TypeTag::uint8:
+            scalar(TypeTag::uint8, &Node::Value::uint8, x.uint8());
+            break;
+        case TypeTag::int16:
+            scalar(TypeTag::int16, &Node::Value::int16, x.int16());
+            break;
+        case TypeTag::uint16:
+            scalar(TypeTag::uint16, &Node::Value::uint16, x.uint16());
+            break;
+        case TypeTag::int32:
+            Int(x.int32());
+            break;
+        case TypeTag::uint32:
+            Uint(x.uint32());
+            break;
+        case TypeTag::int64:
+            Int64(x.int64());
+            break;
+        case TypeTag::uint64:
+            Uint64(x.uint64());
+            break;
+        case TypeTag::double_:
+            Double(x.floating());
+            break;
+        case TypeTag::string:
+            add(string(x.strView()));
+            break;
+        case TypeTag::vec:
+        // the elements of packed integers keep their own types
+        case TypeTag::int64_vec:
+            open();
+            for (auto const& y : x.vec()) {
+                add(y);
+            }
+            close(TypeTag::vec);
+            break;
+        case TypeTag::uint64_vec:
+            array(x.vecAs<uint64_t>(), &Builder::Uint64);
+            break;
+        case TypeTag::double_vec:
+            array(x.vecAs<double>(), &Builder::Double);
+            break;
+        case TypeTag::bool_vec:
+            array(x.vecAs<bool>(), &Builder::Bool);
+            break;
+        case TypeTag::map:
+            open();
+            for (auto const& [key, value] : x.map()) {
+                Key(key.data(), static_cast<rapidjson::SizeType>(key.size()), true);
+                add(value);
+            }
+            close(TypeTag::map);
+            break;
+        }
+    }
+
+    FrozenVariant finish() && {
+        assert(depth == 0);
+        if (nodes.size() > std::numeric_limits<uint32_t>::max()) {
+            throw std::length_error("FrozenVariant: too many nodes");
+        }
+        auto const node_bytes = nodes.size() * sizeof(Node);
+        auto const block = ::operator new(sizeof(Tape) + node_bytes + chars.size());
+        auto const tape = new (block) Tape{{1},
+                                           static_cast<uint32_t>(nodes.size()),
+                                           static_cast<uint32_t>(chars.size())};
+        std::memcpy(const_cast<Node*>(tape->nodes()), nodes.data(), node_bytes);
+        std::memcpy(const_cast<char*>(tape->chars()), chars.data(), chars.size());
+        return FrozenVariant(tape);
+    }
+
+private:
+    /// Add a packed array as a `vec`
+    template <class T, class U>
+    void array(T const& values, bool (Builder::*event)(U)) {
+        open();
+        for (auto const x : values) {
+            (this->*event)(x);
+        }
+        close(TypeTag::vec);
+    }
+
+    Node string(std::string_view x) {
+        if (chars.size() + x.size() > std::numeric_limits<uint32_t>::max()) {
+            throw std::length_error("FrozenVariant: too many characters");
+        }
+        Node ret{TypeTag::string, static_cast<uint32_t>(x.size()), {}};
+        ret.value.offset = chars.size();
+        chars.append(x);
+        return ret;
+    }
+
+    void add(Node const& x) {
+        if (depth == 0) {
+            nodes[0] = x;
+        } else {
+            levels[depth - 1].push_back(x);
+        }
+    }
+
+    void open() {
+        if (levels.size() == depth) {
+            levels.emplace_back();
+        }
+        levels[depth++].clear();
+    }
+
+    void close(TypeTag type) {
+        auto& children = levels[--depth];
+        Node ret{type, static_cast<uint32_t>(children.size()), {}};
+        ret.value.offset = nodes.size();
+        if (type == TypeTag::vec) {
+            nodes.insert(nodes.end(), children.begin(), children.end());
+        } else {
+            // stable, so the last of the equal keys wins as with `Map::operator[]`
+            order.resize(children.size() / 2);
+            for (std::size_t i = 0; i < order.size(); ++i) {
+                order[i] = i;
+            }
+            auto const key = [&](std::size_t i) {
+                auto const& x = children[2 * i];
+                return std::string_view(chars.data() + x.value.offset, x.size);
+            };
+            std::stable_sort(order.begin(), order.end(), [&](auto x, auto y) {
+                return key(x) < key(y);
+            });
+            ret.size = 0;
+            for (std::size_t i = 0; i < order.size(); ++i) {
+                if (i + 1 < order.size() && key(order[i]) == key(order[i + 1])) {
+                    continue;
+                }
+                nodes.push_back(children[2 * order[i]]);
+                nodes.push_back(children[2 * order[i] + 1]);
+                ++ret.size;
+            }
+        }
+        add(ret);
+    }
+
+    /// The root first
+    std::vector<Node> nodes{1};
+    std::string chars;
+    /// Key nodes by the key, a key is stored once
+    StringMap<Node> keys;
+    /// Children of the open containers
+    std::vector<std::vector<Node>> levels;
+    std::size_t depth{0};
+    /// Member order of the Map being closed
+    std::vector<std::size_t> order;
+};
+
+FrozenVariant::FrozenVariant(Variant const& var) {
+    Builder builder;
+    builder.add(var);
+    *this = std::move(builder).finish();
+}
+
+FrozenVariant::~FrozenVariant() noexcept {
+    if (tape_ && tape_->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        tape_->~Tape();
+        ::operator delete(const_cast<Tape*>(tape_));
+    }
+}
+
+FrozenVariant::FrozenVariant(FrozenVariant const& rhs) noexcept
+        : FrozenRef(rhs) {
+    if (tape_) {
+        tape_->refs.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+FrozenVariant::FrozenVariant(FrozenVariant&& rhs) noexcept
+        : FrozenRef(rhs) {
+    static_cast<FrozenRef&>(rhs) = FrozenRef();
+}
+
+FrozenVariant& FrozenVariant::operator=(FrozenVariant rhs) noexcept {
+    std::swap(tape_, rhs.tape_);
+    std::swap(node_, rhs.node_);
+    return *this;
+}
+
+FrozenVariant FrozenVariant::fromJson(std::string const& json) {
+    Builder builder;
+    rapidjson::Reader reader;
+    rapidjson::StringStream ss(json.c_str());
+    reader.Parse(ss, builder);
+    if (reader.HasParseError()) {
+        throw std::runtime_error(rapidjson::GetParseError_En(reader.GetParseErrorCode()));
+    }
+    return std::move(builder).finish();
+}
+
+std::size_t FrozenVariant::bytes() const noexcept {
+    if (!tape_) {
+        return 0;
+    }
+    return sizeof(Tape) + tape_->node_count * sizeof(Node) + tape_->char_count;
+}
+
+} // namespace yenxo
@@ -0,0 +1,135 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <yenxo/interned_key.hpp>
+
+#include <cassert>
+#include <cstring>
+#include <mutex>
+#include <new>
+#include <ostream>
+#include <unordered_map>
+
+namespace yenxo {
+
+namespace {
+
+/// Pooled strings by their contents, a view refers to the characters of its entry
+///
+/// The strings are spread over shards by their hash, so threads interning different
+/// keys rarely wait for each other.
+class Pool {
+public:
+    struct alignas(64) Shard {
+        std::mutex mutex;
+        std::unordered_map<std::string_view, void*> entries;
+    };
+
+    Shard& shard(uint32_t hash) noexcept {
+        // the low bits pick the buckets of `StringMap`
+        return shards_[hash >> (32 - shard_bits)];
+    }
+
+    std::size_t size() {
+        std::size_t ret = 0;
+        for (auto& x : shards_) {
+            std::lock_guard const lock(x.mutex);
+            ret += x.entries.size();
+        }
+        return ret;
+    }
+
+private:
+    static constexpr unsigned shard_bits = 4;
+
+    Shard shards_[1u << shard_bits];
+};
+
+Pool& pool() {
+    // never destroyed, keys may outlive static objects
+    static auto const ret = new Pool;
+    return *ret;
+}
+
+} // namespace
+
+InternedKey::InternedKey(std::string_view str) {
+    if (str.empty()) {
+        return;
+    }
+
+    auto const h = hash(str);
+    auto& p = pool().shard(h);
+    std::lock_guard const lock(p.mutex);
+
+    auto const it = p.entries.find(str);
+    if (it != p.entries.end()) {
+        auto const entry = static_cast<Entry*>(it->second);
+        // an entry whose count dropped to zero is being released, it is never revived
+        auto refs = entry->refs.load(std::memory_order_relaxed);
+        while (refs != 0
+               && !entry->refs.compare_exchange_weak(
+                       refs, refs + 1, std::memory_order_relaxed)) {
+        }
+        if (refs != 0) {
+            entry_ = entry;
+            return;
+        }
+        p.entries.erase(it);
+    }
+
+    auto const entry = static_cast<Entry*>(::operator new(sizeof(Entry) + str.size() + 1));
+    new (entry) Entry{{1}, h, static_cast<uint32_t>(str.size())};
+    auto const data = reinterpret_cast<char*>(entry + 1);
+    std::memcpy(data, str.data(), str.size());
+    data[str.size()] = '\0';
+
+    p.entries.emplace(std::string_view(data, str.size()), entry);
+    entry_ = entry;
+}
+
+void InternedKey::release(Entry* entry) noexcept {
+    assert(entry->refs.load() == 0);
+    {
+        auto& p = pool().shard(entry->hash);
+        std::lock_guard const lock(p.mutex);
+        auto const it = p.entries.find(std::string_view(entry->data(), entry->size));
+        // the string may have been pooled anew by now
+        if (it != p.entries.end() && it->second == entry) {
+            p.entries.erase(it);
+        }
+    }
+    entry->~Entry();
+    ::operator delete(entry);
+}
+
+std::size_t InternedKey::poolSize() {
+    return pool().size();
+}
+
+std::ostream& operator<<(std::ostream& os, InternedKey const& key) {
+    return os << key.view();
+}
+
+} // namespace yenxo
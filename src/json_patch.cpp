@@ -0,0 +1,327 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <yenxo/exception.hpp>
+#include <yenxo/json_patch.hpp>
+
+#include <algorithm>
+#include <string>
+
+namespace yenxo {
+
+namespace {
+
+using Op = JsonPatch::Op;
+using TypeTag = Variant::TypeTag;
+
+constexpr Op ops[] = {Op::add, Op::remove, Op::replace, Op::move, Op::copy, Op::test};
+
+/// Equal trees, the cached hashes reject the different ones in O(1)
+bool same(Variant const& lhs, Variant const& rhs) {
+    return lhs.hash() == rhs.hash() && lhs == rhs;
+}
+
+[[noreturn]] void fail(std::string const& msg, JsonPointer const& path) {
+    VariantErr err(msg);
+    for (auto i = path.size(); i-- > 0;) {
+        err.prependPath(std::string(path[i].key.view()));
+    }
+    throw err;
+}
+
+void diffImpl(Variant const& from,
+              Variant const& to,
+              JsonPointer& path,
+              JsonPatch& patch) {
+    if (same(from, to)) {
+        return;
+    }
+
+    if (from.type() == TypeTag::map && to.type() == TypeTag::map) {
+        auto const& lhs = from.map();
+        auto const& rhs = to.map();
+        for (auto const& [key, x] : lhs) {
+            path.push_back(key);
+            auto const it = rhs.find(key);
+            if (it == rhs.end()) {
+                patch.operations.push_back({Op::remove, path, {}, {}});
+            } else {
+                diffImpl(x, it->second, path, patch);
+            }
+            path.pop_back();
+        }
+        for (auto const& [key, x] : rhs) {
+            if (lhs.find(key) == lhs.end()) {
+                path.push_back(key);
+                patch.operations.push_back({Op::add, path, {}, x});
+                path.pop_back();
+            }
+        }
+    } else if (from.isVec() && to.isVec()) {
+        auto const& lhs = from.vec();
+        auto const& rhs = to.vec();
+        auto const common = std::min(lhs.size(), rhs.size());
+        for (std::size_t i = 0; i < rhs.size(); ++i) {
+            path.push_back(i);
+            if (i < common) {
+                diffImpl(lhs[i], rhs[i], path, patch);
+            } else {
+                patch.operations.push_back({Op::add, path, {}, rhs[i]});
+            }
+            path.pop_back();
+        }
+        for (auto i = lhs.size(); i-- > common;) {
+            path.push_back(i);
+            patch.operations.push_back({Op::remove, path, {}, {}});
+            path.pop_back();
+        }
+    } else {
+        patch.operations.push_back({Op::replace, path, {}, to});
+    }
+}
+
+Variant mergeDiffImpl(Variant const& from, Variant const& to) {
+    if (from.type() != TypeTag::map || to.type() != TypeTag::map) {
+        return to;
+    }
+    auto const& lhs = from.map();
+    auto const& rhs = to.map();
+    Variant::Map ret;
+    for (auto const& [key, x] : lhs) {
+        auto const it = rhs.find(key);
+        if (it == rhs.end()) {
+            ret.try_emplace(key);
+        } else if (!same(x, it->second)) {
+            ret.try_emplace(key, mergeDiffImpl(x, it->second));
+        }
+    }
+    for (auto const& [key, x] : rhs) {
+        if (lhs.find(key) == lhs.end()) {
+            ret.try_emplace(key, x);
+        }
+    }
+    return Variant(std::move(ret));
+}
+
+void addValue(Variant& target, JsonPointer const& path, Variant&& value) {
+    if (path.empty()) {
+        target = std::move(value);
+        return;
+    }
+    auto& parent = target.at(path.parent());
+    auto const& token = path.back();
+    if (parent.type() == TypeTag::map) {
+        parent.modifyMap().insert_or_assign(token.key, std::move(value));
+    } else if (parent.isVec()) {
+        auto& vec = parent.modifyVec();
+        if (token.key == "-") {
+            vec.push_back(std::move(value));
+        } else if (token.index <= vec.size()) {
+            vec.insert(vec.begin() + static_cast<std::ptrdiff_t>(token.index),
+                       std::move(value));
+        } else {
+            fail("'" + path.toString() + "' is not a valid array index", path);
+        }
+    } else {
+        fail("'" + path.toString() + "' has no container to add to", path);
+    }
+}
+
+void removeValue(Variant& target, JsonPointer const& path) {
+    if (path.empty()) {
+        fail("the whole document cannot be removed", path);
+    }
+    auto& parent = target.at(path.parent());
+    auto const& token = path.back();
+    if (parent.type() == TypeTag::map) {
+        if (parent.modifyMap().erase(token.key) == 1) {
+            return;
+        }
+    } else if (parent.isVec() && token.index < parent.vec().size()) {
+        auto& vec = parent.modifyVec();
+        vec.erase(vec.begin() + static_cast<std::ptrdiff_t>(token.index));
+        return;
+    }
+    fail("'" + path.toString() + "' is not found", path);
+}
+
+void applyOperation(Variant& target, JsonPatch::Operation& x) {
+    switch (x.op) {
+    case Op::add:
+        addValue(target, x.path, std::move(x.value));
+        break;
+    case Op::remove:
+        removeValue(target, x.path);
+        break;
+    case Op::replace:
+        target.at(x.path) = std::move(x.value);
+        break;
+    case Op::move: {
+        if (x.from == x.path) {
+            break;
+        }
+        if (x.from.properPrefixOf(x.path)) {
+            fail("'" + x.from.toString() + "' cannot be moved into itself", x.path);
+        }
+        auto value = std::move(target.at(x.from));
+        removeValue(target, x.from);
+        addValue(target, x.path, std::move(value));
+        break;
+    }
+    case Op::copy:
+        addValue(target, x.path, Variant(std::as_const(target).at(x.from)));
+        break;
+    case Op::test:
+        if (!equal(std::as_const(target).at(x.path), x.value)) {
+            fail("test of '" + x.path.toString() + "' failed", x.path);
+        }
+        break;
+    }
+}
+
+void merge(Variant& target, Variant&& patch) {
+    if (patch.type() != TypeTag::map) {
+        target = std::move(patch);
+        return;
+    }
+    if (target.type() != TypeTag::map) {
+        target = Variant(Variant::Map());
+    }
+    auto& map = target.modifyMap();
+    for (auto& [key, x] : patch.modifyMap()) {
+        if (x.null()) {
+            map.erase(key);
+        } else {
+            merge(map[key], std::move(x));
+        }
+    }
+}
+
+Variant const& required(Variant::Map const& map, char const* key) {
+    auto const it = map.find(key);
+    if (it == map.end()) {
+        throw VariantErr("'" + std::string(key) + "' is required");
+    }
+    return it->second;
+}
+
+} // namespace
+
+std::string_view JsonPatch::toString(Op op) noexcept {
+    switch (op) {
+    case Op::add:
+        return "add";
+    case Op::remove:
+        return "remove";
+    case Op::replace:
+        return "replace";
+    case Op::move:
+        return "move";
+    case Op::copy:
+        return "copy";
+    case Op::test:
+        return "test";
+    }
+    return {};
+}
+
+JsonPatch JsonPatch::fromVariant(Variant const& x) {
+    auto const& vec = x.vec();
+    JsonPatch ret;
+    ret.operations.reserve(vec.size());
+    for (std::size_t i = 0; i < vec.size(); ++i) {
+        try {
+            auto const& map = vec[i].map();
+            auto const name = required(map, "op").strView();
+            auto const op = std::find_if(std::begin(ops), std::end(ops), [&](auto x) {
+                return toString(x) == name;
+            });
+            if (op == std::end(ops)) {
+                throw VariantErr("'" + std::string(name)
+                                 + "' is not a JSON Patch operation");
+            }
+            Operation y{*op, JsonPointer(required(map, "path").strView()), {}, {}};
+            if (*op == Op::move || *op == Op::copy) {
+                y.from = JsonPointer(required(map, "from").strView());
+            } else if (*op != Op::remove) {
+                y.value = required(map, "value");
+            }
+            ret.operations.push_back(std::move(y));
+        } catch (VariantErr& e) {
+            e.prependPath(std::to_string(i));
+            throw;
+        } catch (std::exception const& e) {
+            VariantErr err(e.what());
+            err.prependPath(std::to_string(i));
+            throw err;
+        }
+    }
+    return ret;
+}
+
+Variant JsonPatch::toVariant(JsonPatch const& x) {
+    Variant::Vec ret;
+    ret.reserve(x.operations.size());
+    for (auto const& y : x.operations) {
+        Variant::Map map;
+        map.reserve(3);
+        map.try_emplace("op", toString(y.op));
+        map.try_emplace("path", y.path.toString());
+        if (y.op == Op::move || y.op == Op::copy) {
+            map.try_emplace("from", y.from.toString());
+        } else if (y.op != Op::remove) {
+            map.try_emplace("value", y.value);
+        }
+        ret.push_back(Variant(std::move(map)));
+    }
+    return Variant(std::move(ret));
+}
+
+JsonPatch diff(Variant const& from, Variant const& to) {
+    JsonPatch ret;
+    JsonPointer path;
+    diffImpl(from, to, path, ret);
+    return ret;
+}
+
+MergePatch mergeDiff(Variant const& from, Variant const& to) {
+    if (same(from, to)) {
+        return {Variant(Variant::Map())};
+    }
+    return {mergeDiffImpl(from, to)};
+}
+
+void apply(Variant& target, JsonPatch patch) {
+    auto ret = target;
+    for (auto& x : patch.operations) {
+        applyOperation(ret, x);
+    }
+    target = std::move(ret);
+}
+
+void apply(Variant& target, MergePatch patch) {
+    merge(target, std::move(patch.value));
+}
+
+} // namespace yenxo
@@ -0,0 +1,218 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <yenxo/exception.hpp>
+#include <yenxo/json_pointer.hpp>
+#include <yenxo/variant.hpp>
+
+#include <algorithm>
+#include <array>
+#include <charconv>
+#include <limits>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace yenxo {
+
+namespace {
+
+using Token = JsonPointer::Token;
+
+/// The child of `x` referred by `token` or `nullptr`
+Variant const* child(Variant const& x, Token const& token) {
+    switch (x.type()) {
+    case Variant::TypeTag::map: {
+        auto const& map = x.map();
+        auto const it = map.find(token.key);
+        return it == map.end() ? nullptr : &it->second;
+    }
+    case Variant::TypeTag::vec: {
+        if (token.index == Token::npos) {
+            return nullptr;
+        }
+        auto const& vec = x.vec();
+        return token.index < vec.size() ? &vec[token.index] : nullptr;
+    }
+    default:
+        return nullptr;
+    }
+}
+
+/// The child of `x` referred by `token` for modification
+/// \pre The child exists.
+Variant& modifyChild(Variant& x, Token const& token) {
+    if (x.type() == Variant::TypeTag::map) {
+        return x.modifyMap().find(token.key)->second;
+    }
+    return x.modifyVec()[token.index];
+}
+
+[[noreturn]] void throwNotFound(Variant const& root, JsonPointer const& pointer) {
+    std::size_t missing = 0;
+    for (auto x = &root; (x = child(*x, pointer[missing])); ++missing) {
+    }
+    VariantErr err("'" + pointer.toString() + "' is not found");
+    for (auto i = missing + 1; i-- > 0;) {
+        err.prependPath(std::string(pointer[i].key.view()));
+    }
+    throw err;
+}
+
+void escape(std::string& out, std::string_view token) {
+    for (auto const c : token) {
+        if (c == '~') {
+            out += "~0";
+        } else if (c == '/') {
+            out += "~1";
+        } else {
+            out += c;
+        }
+    }
+}
+
+} // namespace
+
+JsonPointer::JsonPointer(std::string_view str) {
+    if (str.empty()) {
+        return;
+    }
+    if (str.front() != '/') {
+        throw std::invalid_argument("JSON Pointer '" + std::string(str)
+                                    + "' does not start with '/'");
+    }
+
+    tokens_.reserve(static_cast<std::size_t>(std::count(str.begin(), str.end(), '/')));
+    std::string token;
+    for (std::size_t i = 1;; ++i) {
+        auto const end = std::min(str.find('/', i), str.size());
+        token.clear();
+        for (; i < end; ++i) {
+            if (str[i] != '~') {
+                token += str[i];
+            } else if (i + 1 < end && (str[i + 1] == '0' || str[i + 1] == '1')) {
+                token += str[++i] == '0' ? '~' : '/';
+            } else {
+                throw std::invalid_argument("JSON Pointer '" + std::string(str)
+                                            + "' has an invalid escape");
+            }
+        }
+        push_back(token);
+        if (end == str.size()) {
+            break;
+        }
+    }
+}
+
+JsonPointer& JsonPointer::push_back(InternedKey key) {
+    auto const token = key.view();
+    Token x{std::move(key)};
+    // RFC 6901: array-index = %x30 / ( %x31-39 *(%x30-39) )
+    if (!token.empty() && (token.size() == 1 || token.front() != '0')) {
+        auto const last = token.data() + token.size();
+        std::size_t index;
+        auto const r = std::from_chars(token.data(), last, index);
+        if (r.ec == std::errc() && r.ptr == last && index != Token::npos) {
+            x.index = index;
+        }
+    }
+    tokens_.push_back(std::move(x));
+    return *this;
+}
+
+JsonPointer& JsonPointer::push_back(std::size_t index) {
+    static auto const keys = [] {
+        std::array<InternedKey, 256> ret;
+        for (std::size_t i = 0; i < ret.size(); ++i) {
+            ret[i] = InternedKey(std::to_string(i));
+        }
+        return ret;
+    }();
+    if (index < keys.size()) {
+        tokens_.push_back({keys[index], index});
+        return *this;
+    }
+    char buf[std::numeric_limits<std::size_t>::digits10 + 1];
+    auto const last = std::to_chars(std::begin(buf), std::end(buf), index).ptr;
+    auto const size = static_cast<std::size_t>(last - buf);
+    tokens_.push_back({InternedKey(std::string_view(buf, size)), index});
+    return *this;
+}
+
+std::string JsonPointer::toString() const {
+    std::string ret;
+    for (auto const& x : tokens_) {
+        ret += '/';
+        escape(ret, x.key.view());
+    }
+    return ret;
+}
+
+bool JsonPointer::properPrefixOf(JsonPointer const& rhs) const noexcept {
+    return size() < rhs.size()
+        && std::equal(begin(), end(), rhs.begin(),
+                      [](auto const& x, auto const& y) { return x.key == y.key; });
+}
+
+bool operator==(JsonPointer const& lhs, JsonPointer const& rhs) noexcept {
+    return std::equal(lhs.begin(), lhs.end(), rhs.begin(), rhs.end(),
+                      [](auto const& x, auto const& y) { return x.key == y.key; });
+}
+
+Variant const& Variant::at(JsonPointer const& pointer) const {
+    if (auto const ret = find(pointer)) {
+        return *ret;
+    }
+    throwNotFound(*this, pointer);
+}
+
+Variant& Variant::at(JsonPointer const& pointer) {
+    if (auto const ret = find(pointer)) {
+        return *ret;
+    }
+    throwNotFound(*this, pointer);
+}
+
+Variant const* Variant::find(JsonPointer const& pointer) const {
+    auto ret = this;
+    for (auto const& token : pointer) {
+        if (!(ret = child(*ret, token))) {
+            return nullptr;
+        }
+    }
+    return ret;
+}
+
+Variant* Variant::find(JsonPointer const& pointer) {
+    if (!std::as_const(*this).find(pointer)) {
+        return nullptr;
+    }
+    auto ret = this;
+    for (auto const& token : pointer) {
+        ret = &modifyChild(*ret, token);
+    }
+    return ret;
+}
+
+} // namespace yenxo
@@ -0,0 +1,54 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <yenxo/json_sink.hpp>
+
+#include <cerrno>
+#include <ostream>
+#include <system_error>
+
+#include <unistd.h>
+
+namespace yenxo {
+
+void OstreamSink::write(std::string_view chunk) {
+    if (!os_.write(chunk.data(), static_cast<std::streamsize>(chunk.size()))) {
+        throw std::ios_base::failure("JSON output stream failed");
+    }
+}
+
+void FdSink::write(std::string_view chunk) {
+    while (!chunk.empty()) {
+        auto const n = ::write(fd_, chunk.data(), chunk.size());
+        if (n < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            throw std::system_error(errno, std::generic_category(), "JSON output write");
+        }
+        chunk.remove_prefix(static_cast<std::size_t>(n));
+    }
+}
+
+} // namespace yenxo
@@ -0,0 +1,110 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#include <yenxo/mapped_file.hpp>
+
+#include <cerrno>
+#include <system_error>
+#include <utility>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace yenxo {
+
+namespace {
+
+[[noreturn]] void fail(std::string const& what, std::string const& path) {
+    throw std::system_error(errno, std::generic_category(), what + " '" + path + "'");
+}
+
+} // namespace
+
+MappedFile::MappedFile(std::string path)
+        : path_(std::move(path)) {
+    int fd;
+    while ((fd = ::open(path_.c_str(), O_RDONLY | O_CLOEXEC)) < 0) {
+        if (errno != EINTR) {
+            fail("open", path_);
+        }
+    }
+
+    struct stat st;
+    if (::fstat(fd, &st) != 0) {
+        auto const error = errno;
+        ::close(fd);
+        errno = error;
+        fail("stat", path_);
+    }
+
+    // `mmap()` rejects an empty range, an empty file is an empty view
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ != 0) {
+        auto const p = ::mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p == MAP_FAILED) {
+            auto const error = errno;
+            ::close(fd);
+            errno = error;
+            fail("mmap", path_);
+        }
+        // only a hint, the mapping works without it
+        ::madvise(p, size_, MADV_SEQUENTIAL);
+        data_ = static_cast<char const*>(p);
+    }
+    // the mapping holds its own reference to the file
+    ::close(fd);
+}
+
+MappedFile::MappedFile(MappedFile&& rhs) noexcept
+        : path_(std::move(rhs.path_))
+        , data_(std::exchange(rhs.data_, nullptr))
+        , size_(std::exchange(rhs.size_, 0)) {
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& rhs) noexcept {
+    if (this != &rhs) {
+        unmap();
+        path_ = std::move(rhs.path_);
+        data_ = std::exchange(rhs.data_, nullptr);
+        size_ = std::exchange(rhs.size_, 0);
+    }
+    return *this;
+}
+
+MappedFile::~MappedFile() {
+    unmap();
+}
+
+void MappedFile::unmap() noexcept {
+    if (data_) {
+        ::munmap(const_cast<char*>(data_), size_);
+        data_ = nullptr;
+        size_ = 0;
+    }
+}
+
+} // namespace yenxo
@@ -0,0 +1,243 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#include <yenxo/ndjson.hpp>
+
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <istream>
+#include <mutex>
+#include <thread>
+
+namespace yenxo::detail {
+
+namespace {
+
+std::size_t threadCount(NdjsonOptions const& options) noexcept {
+    if (options.threads != 0) {
+        return options.threads;
+    }
+    return std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+/// Workers running the slots of a job, stopped and joined on destruction
+class Pool {
+public:
+    Pool(NdjsonJob& job, std::size_t threads, std::size_t slots)
+            : job_(job)
+            , finished_(slots, false)
+            , errors_(slots) {
+        workers_.reserve(threads);
+        try {
+            for (std::size_t i = 0; i < threads; ++i) {
+                workers_.emplace_back([this] { work(); });
+            }
+        } catch (...) {
+            stop();
+            throw;
+        }
+    }
+
+    ~Pool() {
+        stop();
+    }
+
+    void submit(std::size_t slot) {
+        {
+            std::lock_guard lock(mutex_);
+            finished_[slot] = false;
+            queue_.push_back(slot);
+        }
+        work_cv_.notify_one();
+    }
+
+    /// Wait for `slot` to be finished
+    void wait(std::size_t slot) {
+        std::unique_lock lock(mutex_);
+        done_cv_.wait(lock, [&] { return finished_[slot]; });
+        done_.erase(std::find(done_.begin(), done_.end(), slot));
+    }
+
+    /// Wait for any slot to be finished
+    std::size_t waitAny() {
+        std::unique_lock lock(mutex_);
+        done_cv_.wait(lock, [&] { return !done_.empty(); });
+        auto const ret = done_.front();
+        done_.pop_front();
+        return ret;
+    }
+
+    /// Rethrow the exception of the finished `slot`
+    void check(std::size_t slot) const {
+        if (errors_[slot]) {
+            std::rethrow_exception(errors_[slot]);
+        }
+    }
+
+private:
+    void work() {
+        for (;;) {
+            std::size_t slot;
+            {
+                std::unique_lock lock(mutex_);
+                work_cv_.wait(lock, [&] { return stopped_ || !queue_.empty(); });
+                if (stopped_) {
+                    return;
+                }
+                slot = queue_.front();
+                queue_.pop_front();
+            }
+
+            std::exception_ptr error;
+            try {
+                job_.run(slot);
+            } catch (...) {
+                error = std::current_exception();
+            }
+
+            {
+                std::lock_guard lock(mutex_);
+                errors_[slot] = std::move(error);
+                finished_[slot] = true;
+                done_.push_back(slot);
+            }
+            done_cv_.notify_one();
+        }
+    }
+
+    void stop() noexcept {
+        {
+            std::lock_guard lock(mutex_);
+            stopped_ = true;
+        }
+        work_cv_.notify_all();
+        for (auto& x : workers_) {
+            x.join();
+        }
+        workers_.clear();
+    }
+
+    NdjsonJob& job_;
+    std::mutex mutex_;
+    std::condition_variable work_cv_;
+    std::condition_variable done_cv_;
+    std::deque<std::size_t> queue_;
+    /// The finished slots in the order of completion
+    std::deque<std::size_t> done_;
+    std::vector<bool> finished_;
+    std::vector<std::exception_ptr> errors_;
+    bool stopped_{false};
+    std::vector<std::thread> workers_;
+};
+
+} // namespace
+
+bool NdjsonSplitter::next(NdjsonChunk& chunk) {
+    if (!is_) {
+        if (text_.empty()) {
+            return false;
+        }
+        auto size = std::min(chunk_size_, text_.size());
+        size = std::min(text_.find('\n', size - 1), text_.size() - 1) + 1;
+        chunk.text = text_.substr(0, size);
+        text_.remove_prefix(size);
+    } else {
+        auto& buf = chunk.buffer;
+        buf.swap(carry_);
+        carry_.clear();
+        for (;;) {
+            auto const old = buf.size();
+            buf.resize(old + chunk_size_);
+            is_->read(buf.data() + old, static_cast<std::streamsize>(chunk_size_));
+            buf.resize(old + static_cast<std::size_t>(is_->gcount()));
+            if (is_->bad()) {
+                throw std::ios_base::failure("NDJSON input stream failed");
+            }
+            if (!*is_) {
+                break;
+            }
+            // a line longer than a chunk is read on until its end
+            if (auto const end = buf.rfind('\n'); end != std::string::npos) {
+                carry_.assign(buf, end + 1);
+                buf.resize(end + 1);
+                break;
+            }
+        }
+        if (buf.empty()) {
+            return false;
+        }
+        chunk.text = buf;
+    }
+    chunk.line = line_;
+    auto const& text = chunk.text;
+    line_ += static_cast<std::size_t>(std::count(text.begin(), text.end(), '\n'));
+    return true;
+}
+
+std::size_t ndjsonSlots(NdjsonOptions const& options) noexcept {
+    return 2 * threadCount(options);
+}
+
+void runNdjson(NdjsonJob& job, NdjsonOptions const& options) {
+    auto const slots = ndjsonSlots(options);
+    std::vector<std::size_t> free;
+    free.reserve(slots);
+    for (auto i = slots; i-- > 0;) {
+        free.push_back(i);
+    }
+    // the submitted slots in the order of the input
+    std::deque<std::size_t> pending;
+
+    Pool pool(job, threadCount(options), slots);
+    for (auto more = true;;) {
+        while (more && !free.empty()) {
+            if (!(more = job.next(free.back()))) {
+                break;
+            }
+            pending.push_back(free.back());
+            pool.submit(free.back());
+            free.pop_back();
+        }
+        if (pending.empty()) {
+            return;
+        }
+
+        std::size_t slot;
+        if (options.order == NdjsonOrder::input) {
+            slot = pending.front();
+            pending.pop_front();
+            pool.wait(slot);
+        } else {
+            slot = pool.waitAny();
+            pending.erase(std::find(pending.begin(), pending.end(), slot));
+        }
+        pool.check(slot);
+        job.deliver(slot);
+        free.push_back(slot);
+    }
+}
+
+} // namespace yenxo::detail
@@ -22,830 +22,1834 @@
   SOFTWARE.
 */
 
+#include <yenxo/config.hpp>
 #include <yenxo/exception.hpp>
+#include <yenxo/frozen_variant.hpp>
+#include <yenxo/json_sink.hpp>
+#include <yenxo/mapped_file.hpp>
 #include <yenxo/meta.hpp>
 #include <yenxo/type_name.hpp>
 #include <yenxo/variant.hpp>
+#include <yenxo/variant_arena.hpp>
+#include <yenxo/variant_parser.hpp>
+#include <yenxo/variant_stats.hpp>
 
 #include <rapidjson/document.h>
 #include <rapidjson/error/en.h>
+#include <rapidjson/memorystream.h>
 #include <rapidjson/prettywriter.h>
-#include <rapidjson/stringbuffer.h>
 #include <rapidjson/writer.h>
 
 #include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <climits>
 #include <cmath>
+#include <cstddef>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <mutex>
 #include <ostream>
 #include <typeinfo>
+#include <unordered_set>
+#include <utility>
 
 namespace yenxo {
 
-Variant::~Variant() noexcept {
-    switch (type_tag_) {
-    case TypeTag::string:
-        delete reinterpret_cast<std::string*>(value_.ptr);
-        break;
-    case TypeTag::vec:
-        delete reinterpret_cast<Vec*>(value_.ptr);
-        break;
-    case TypeTag::map:
-        delete reinterpret_cast<Map*>(value_.ptr);
-        break;
-    default:
-        break;
+namespace {
+
+std::atomic<PayloadHook> payload_hook{nullptr};
+
+void notifyPayload(std::ptrdiff_t bytes) noexcept {
+    if (auto const hook = payload_hook.load(std::memory_order_relaxed)) {
+        hook(bytes);
     }
 }
 
-Variant::Variant() noexcept
-        : type_tag_(TypeTag::null)
-        , value_(NullType{}) {
-}
-Variant::Variant(NullType x) noexcept
-        : type_tag_(TypeTag::null)
-        , value_(x) {
-}
-Variant::Variant(bool x) noexcept
-        : type_tag_(TypeTag::boolean)
-        , value_(x) {
-}
-Variant::Variant(char x) noexcept
-        : type_tag_(TypeTag::char_)
-        , value_(x) {
-}
-Variant::Variant(int8_t x) noexcept
-        : type_tag_(TypeTag::int8)
-        , value_(x) {
-}
-Variant::Variant(uint8_t x) noexcept
-        : type_tag_(TypeTag::uint8)
-        , value_(x) {
-}
-Variant::Variant(int16_t x) noexcept
-        : type_tag_(TypeTag::int16)
-        , value_(x) {
-}
-Variant::Variant(uint16_t x) noexcept
-        : type_tag_(TypeTag::uint16)
-        , value_(x) {
-}
-Variant::Variant(int32_t x) noexcept
-        : type_tag_(TypeTag::int32)
-        , value_(x) {
-}
-Variant::Variant(uint32_t x) noexcept
-        : type_tag_(TypeTag::uint32)
-        , value_(x) {
-}
-Variant::Variant(int64_t x) noexcept
-        : type_tag_(TypeTag::int64)
-        , value_(x) {
-}
-Variant::Variant(uint64_t x) noexcept
-        : type_tag_(TypeTag::uint64)
-        , value_(x) {
-}
-Variant::Variant(double x) noexcept
-        : type_tag_(TypeTag::double_)
-        , value_(x) {
-}
+/// Freed payload linked into a pool
+struct FreeNode {
+    FreeNode* next;
+};
 
-Variant::Variant(char const* const& x)
-        : type_tag_(TypeTag::string)
-        , value_(new std::string(x)) {
-}
+constexpr std::size_t pool_granularity = 16;
+/// Payloads up to `pool_classes * pool_granularity` bytes are pooled
+constexpr std::size_t pool_classes = 8;
+/// The global pool of a size class keeps up to this many times the thread limit
+constexpr std::size_t global_pool_factor = 16;
+
+std::atomic<std::size_t> pool_limit{YENXO_PAYLOAD_POOL_LIMIT};
+/// Changed by `setPayloadPoolLimit()`, a thread seeing a new value trims its own pool
+std::atomic<std::size_t> pool_epoch{0};
+
+/// Bytes allocated for a payload of size class `c`
+constexpr std::size_t classBytes(std::size_t c) noexcept {
+    return (c + 1) * pool_granularity;
+}
+
+/// Free the payloads of size class `c` linked from `head`
+void freeList(FreeNode* head, std::size_t c) noexcept {
+    while (head) {
+        auto const next = head->next;
+        ::operator delete(head, classBytes(c));
+        head = next;
+    }
+}
+
+/// Payloads given back by the threads, guarded by `mutex`, `count` is read without
+/// the lock to skip an empty pool
+///
+/// The lock is taken once per batch of up to the thread limit payloads, not per payload.
+struct GlobalPool {
+    std::mutex mutex;
+    FreeNode* head = nullptr;
+    std::atomic<std::size_t> count{0};
+
+    /// Free the payloads beyond `capacity`
+    void trim(std::size_t c, std::size_t capacity) noexcept {
+        FreeNode* extra = nullptr;
+        {
+            std::lock_guard lock(mutex);
+            auto n = count.load(std::memory_order_relaxed);
+            for (; n > capacity; --n) {
+                auto const x = head;
+                head = x->next;
+                x->next = extra;
+                extra = x;
+            }
+            count.store(n, std::memory_order_relaxed);
+        }
+        freeList(extra, c);
+    }
+};
 
-Variant::Variant(std::string const& x)
-        : type_tag_(TypeTag::string)
-        , value_(new std::string(x)) {
-}
-Variant::Variant(std::string&& x)
-        : type_tag_(TypeTag::string)
-        , value_(new std::string(std::move(x))) {
-}
-Variant::Variant(std::string_view x)
-        : type_tag_(TypeTag::string)
-        , value_(new std::string(x)) {
-}
+GlobalPool global_pool[pool_classes];
 
-Variant::Variant(Vec const& x)
-        : type_tag_(TypeTag::vec)
-        , value_(new Vec(x)) {
-}
-Variant::Variant(Vec&& x)
-        : type_tag_(TypeTag::vec)
-        , value_(new Vec(std::move(x))) {
-}
+/// Set once the pool of the thread is destroyed, the payloads are not pooled after that
+thread_local bool thread_pool_destroyed = false;
 
-Variant::Variant(Map const& x)
-        : type_tag_(TypeTag::map)
-        , value_(new Map(x)) {
-}
-Variant::Variant(Map&& x)
-        : type_tag_(TypeTag::map)
-        , value_(new Map(std::move(x))) {
-}
+struct ThreadPool {
+    ~ThreadPool() {
+        for (std::size_t c = 0; c < pool_classes; ++c) {
+            flush(c);
+        }
+        thread_pool_destroyed = true;
+    }
 
-struct Variant::Impl {
-    static inline ValueType copy(TypeTag tag, ValueType x) {
-        ValueType ret;
-        switch (tag) {
-        case TypeTag::string:
-            ret = new std::string(*reinterpret_cast<std::string*>(x.ptr));
-            break;
-        case TypeTag::vec:
-            ret = new Vec(*reinterpret_cast<Vec*>(x.ptr));
-            break;
-        case TypeTag::map:
-            ret = new Map(*reinterpret_cast<Map*>(x.ptr));
-            break;
-        default:
-            ret = x;
-            break;
+    /// Move the payloads of size class `c` to the global pool, the ones beyond its
+    /// capacity are freed
+    void flush(std::size_t c) noexcept {
+        auto list = std::exchange(heads[c], nullptr);
+        counts[c] = 0;
+        if (!list) {
+            return;
+        }
+        auto const capacity = pool_limit.load(std::memory_order_relaxed)
+                            * global_pool_factor;
+        auto& global = global_pool[c];
+        {
+            std::lock_guard lock(global.mutex);
+            auto n = global.count.load(std::memory_order_relaxed);
+            for (; list && n < capacity; ++n) {
+                auto const x = list;
+                list = x->next;
+                x->next = global.head;
+                global.head = x;
+            }
+            global.count.store(n, std::memory_order_relaxed);
+        }
+        freeList(list, c);
+    }
+
+    /// Take up to `limit` payloads of size class `c` from the global pool
+    void refill(std::size_t c, std::size_t limit) noexcept {
+        auto& global = global_pool[c];
+        if (global.count.load(std::memory_order_relaxed) == 0) {
+            return;
+        }
+        std::lock_guard lock(global.mutex);
+        auto n = global.count.load(std::memory_order_relaxed);
+        for (; n > 0 && counts[c] < limit; --n, ++counts[c]) {
+            auto const x = global.head;
+            global.head = x->next;
+            x->next = heads[c];
+            heads[c] = x;
+        }
+        global.count.store(n, std::memory_order_relaxed);
+    }
+
+    /// Free the payloads beyond `limit` of each size class
+    void trim(std::size_t limit) noexcept {
+        for (std::size_t c = 0; c < pool_classes; ++c) {
+            for (; counts[c] > limit; --counts[c]) {
+                auto const x = heads[c];
+                heads[c] = x->next;
+                ::operator delete(x, classBytes(c));
+            }
+        }
+    }
+
+    /// The current limit, the pool is trimmed to it first if it changed since
+    std::size_t limit() noexcept {
+        auto const current = pool_epoch.load(std::memory_order_acquire);
+        auto const ret = pool_limit.load(std::memory_order_relaxed);
+        if (epoch != current) {
+            epoch = current;
+            trim(ret);
         }
         return ret;
     }
 
-    struct ToJson;
+    FreeNode* heads[pool_classes]{};
+    std::size_t counts[pool_classes]{};
+    /// `pool_epoch` of the last `limit()`
+    std::size_t epoch = 0;
 };
 
-Variant::Variant(Variant const& rhs)
-        : type_tag_(rhs.type_tag_)
-        , value_(Impl::copy(type_tag_, rhs.value_)) {
-}
-
-Variant& Variant::operator=(Variant const& rhs) {
-    Variant tmp(rhs);
-    operator=(std::move(tmp));
-    return *this;
-}
+thread_local ThreadPool thread_pool;
 
-Variant::Variant(Variant&& rhs) noexcept
-        : type_tag_(rhs.type_tag_)
-        , value_(rhs.value_) {
-    rhs.type_tag_ = TypeTag::null;
-    rhs.value_.null_ = {};
+std::size_t sizeClass(std::size_t size) noexcept {
+    return (size - 1) / pool_granularity;
 }
 
-Variant& Variant::operator=(Variant&& rhs) noexcept {
-    this->~Variant();
-    new (this) Variant(std::move(rhs));
-    return *this;
+void* allocatePayload(std::size_t size) {
+    auto const c = sizeClass(size);
+    if (c >= pool_classes) {
+        return ::operator new(size);
+    }
+    if (!thread_pool_destroyed) {
+        auto& pool = thread_pool;
+        if (auto const limit = pool.limit(); limit != 0) {
+            if (!pool.heads[c]) {
+                pool.refill(c, limit);
+            }
+            if (auto const x = pool.heads[c]) {
+                pool.heads[c] = x->next;
+                --pool.counts[c];
+                return x;
+            }
+        }
+    }
+    // any payload of the class may reuse the memory
+    return ::operator new(classBytes(c));
 }
 
-namespace {
-
-template <typename T, typename = void>
-struct GetHelper final : GetHelper<T, When<true>> {};
-
-template <typename T, bool condition>
-struct GetHelper<T, When<condition>> {
-    static T const& apply(T const& x) noexcept {
-        return x;
+void deallocatePayload(void* ptr, std::size_t size) noexcept {
+    auto const c = sizeClass(size);
+    if (c >= pool_classes) {
+        ::operator delete(ptr, size);
+        return;
     }
-    [[noreturn]] static T const& apply(Variant::NullType) {
-        throw VariantEmpty(boost::hana::type_c<T>);
+    if (thread_pool_destroyed) {
+        ::operator delete(ptr, classBytes(c));
+        return;
     }
-    template <typename U>
-    [[noreturn]] static T const& apply(U const&) {
-        throw VariantBadType(boost::hana::type_c<T>, boost::hana::type_c<U>);
+    auto& pool = thread_pool;
+    auto const limit = pool.limit();
+    if (limit == 0) {
+        ::operator delete(ptr, classBytes(c));
+        return;
     }
-};
-
-template <>
-struct GetHelper<Variant::NullType> {
-    static Variant::NullType apply(Variant::NullType) noexcept {
-        return {};
+    auto const x = static_cast<FreeNode*>(ptr);
+    x->next = pool.heads[c];
+    pool.heads[c] = x;
+    if (++pool.counts[c] > limit) {
+        pool.flush(c);
     }
-    template <typename U>
-    [[noreturn]] static Variant::NullType apply(U const&) {
-        throw VariantBadType(boost::hana::type_c<Variant::NullType>,
-                             boost::hana::type_c<U>);
+}
+
+/// Payload of a `string`, `vec` or `map`, heap payloads are shared by `Variant` copies
+template <class T>
+struct Shared {
+    template <class... Args>
+    explicit Shared(Args&&... args)
+            : value(std::forward<Args>(args)...) {
     }
-};
 
-template <typename A, typename B>
-constexpr auto same_sign_v = std::is_signed_v<A> == std::is_signed_v<B>;
+    static void* operator new(std::size_t size) {
+        auto const ret = allocatePayload(size);
+        notifyPayload(static_cast<std::ptrdiff_t>(size));
+        return ret;
+    }
 
-struct ThrowVariantIntegralOverflow {
-    template <class Type, class Value>
-    [[noreturn]] static typename Type::type overflow(Type t, Value v) {
-        throw VariantIntegralOverflow(std::string(typeName(t)), std::to_string(v));
+    /// Placement into a `VariantArena`, not reported to the `PayloadHook`
+    static void* operator new(std::size_t, void* ptr) noexcept {
+        return ptr;
     }
-    template <class Type1, class Type2>
-    [[noreturn]] static typename Type1::type badType(Type1 t1, Type2 t2) {
-        throw VariantBadType(t1, t2);
+
+    static void operator delete(void* ptr, std::size_t size) noexcept {
+        notifyPayload(-static_cast<std::ptrdiff_t>(size));
+        deallocatePayload(ptr, size);
     }
-};
 
-// Casts `U` to `T` if a specific value of `U` is representable in `T` else throws
-// `VariantIntegralOverflow`.
-template <typename T,
-          typename U,
-          typename ThrowPolicy = ThrowVariantIntegralOverflow,
-          typename = void>
-struct ArithmeticCheckedCast final
-        : ArithmeticCheckedCast<T, U, ThrowPolicy, When<true>> {
-    static_assert(std::is_arithmetic_v<T> && (std::is_arithmetic_v<U>));
+    std::atomic<std::size_t> refs{1};
+    /// `Variant::hash()` of a container, 0 until computed
+    std::atomic<std::size_t> hash{0};
+    T value;
 };
 
-template <typename T, typename U, typename P>
-struct ArithmeticCheckedCast<T, U, P, When<
-        !std::is_same_v<T, double> &&
-        !std::is_same_v<T, bool> &&
-        !std::is_same_v<U, double> &&
-        !std::is_same_v<U, bool> &&
-        same_sign_v<T, U> && sizeof(T) >= sizeof(U)>> {
-    static T apply(U x) noexcept {
-        return x;
+/// Payload of a packed array, `unpacked` holds the elements once `vec()` was called
+///
+/// `element` is the type of the elements given back by `vec()`. Copies of a tree share
+/// the payload, so `values` is read between `acquire()` and `release()`. `vec()` frees
+/// `values` once `unpacked` is set and no one reads them, a getter handing out a
+/// reference to them acquires them for good.
+template <class T>
+struct Packed {
+    Packed(T values, Variant::TypeTag element) noexcept
+            : values(std::move(values))
+            , element(element) {
     }
-};
 
-template <typename T, typename U, typename P>
-struct ArithmeticCheckedCast<T, U, P, When<
-        !std::is_same_v<T, double> &&
-        !std::is_same_v<T, bool> &&
-        !std::is_same_v<U, double> &&
-        !std::is_same_v<U, bool> &&
-        same_sign_v<T, U> && sizeof(T) < sizeof(U)>> {
-    static T apply(U x) {
-        if (x < std::numeric_limits<T>::min() || x > std::numeric_limits<T>::max()) {
-            return P::overflow(boost::hana::type_c<T>, x);
-        } else {
-            return static_cast<T>(x);
-        }
+    /// \pre `rhs.values` is acquired.
+    Packed(Packed const& rhs)
+            : values(rhs.values)
+            , element(rhs.element) {
     }
-};
 
-template <typename T, typename U, typename P>
-struct ArithmeticCheckedCast<T, U, P, When<
-        !std::is_same_v<T, double> &&
-        !std::is_same_v<T, bool> &&
-        !std::is_same_v<U, double> &&
-        !std::is_same_v<U, bool> &&
-        std::is_signed_v<T> && std::is_unsigned_v<U> && (sizeof(T) > sizeof(U))>> {
-    static T apply(U x) noexcept {
-        return x;
+    ~Packed() {
+        delete unpacked.load(std::memory_order_relaxed);
     }
-};
 
-template <typename T, typename U, typename P>
-struct ArithmeticCheckedCast<T, U, P, When<
-        !std::is_same_v<T, double> &&
-        !std::is_same_v<T, bool> &&
-        !std::is_same_v<U, double> &&
-        !std::is_same_v<U, bool> &&
-        std::is_signed_v<T> && std::is_unsigned_v<U> && (sizeof(T) <= sizeof(U))>> {
-    static T apply(U x) {
-#if defined(__GNUG__) || defined(__clang__)
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wsign-compare"
-        if (x > std::numeric_limits<T>::max()) {
-#pragma GCC diagnostic pop
-#else
-#error The compiler not supported
-#endif
-            return P::overflow(boost::hana::type_c<T>, x);
+    /// Start reading `values`, false once they are freed
+    bool acquire() const noexcept {
+        if (readers.fetch_add(1, std::memory_order_acq_rel) < freed) {
+            return true;
         }
-        return static_cast<T>(x);
+        readers.fetch_sub(1, std::memory_order_relaxed);
+        return false;
     }
-};
 
-template <typename T, typename U, typename P>
-struct ArithmeticCheckedCast<T, U, P, When<
-        !std::is_same_v<T, double> &&
-        !std::is_same_v<T, bool> &&
-        !std::is_same_v<U, double> &&
-        !std::is_same_v<U, bool> &&
-        std::is_unsigned_v<T> && std::is_signed_v<U> && sizeof(T) >= sizeof(U)>> {
-    static T apply(U x) {
-        if (x < 0) {
-            return P::overflow(boost::hana::type_c<T>, x);
-        } else {
-            return static_cast<T>(x);
+    /// Stop reading `values`, the last reader frees them if `unpacked` is set
+    void release() noexcept {
+        if (readers.fetch_sub(1, std::memory_order_acq_rel) == 1
+            && unpacked.load(std::memory_order_acquire) != nullptr) {
+            drop();
+        }
+    }
+
+    /// Free `values` unless read
+    /// \pre `unpacked` is set.
+    void drop() noexcept {
+        std::size_t expected = 0;
+        if (readers.compare_exchange_strong(expected,
+                                            freed,
+                                            std::memory_order_acq_rel,
+                                            std::memory_order_relaxed)) {
+            T().swap(values);
         }
     }
+
+    bool isFreed() const noexcept {
+        return readers.load(std::memory_order_acquire) >= freed;
+    }
+
+    /// `readers` from `drop()` on, the later `acquire()` calls leave it above
+    static constexpr std::size_t freed = std::numeric_limits<std::size_t>::max() / 2;
+
+    T values;
+    Variant::TypeTag element;
+    mutable std::atomic<Variant::Vec*> unpacked{nullptr};
+    mutable std::atomic<std::size_t> readers{0};
 };
 
-template <typename T, typename U, typename P>
-struct ArithmeticCheckedCast<T, U, P, When<
-        !std::is_same_v<T, double> &&
-        !std::is_same_v<T, bool> &&
-        !std::is_same_v<U, double> &&
-        !std::is_same_v<U, bool> &&
-        std::is_unsigned_v<T> && std::is_signed_v<U> && sizeof(T) < sizeof(U)>> {
-    static T apply(U x) {
-#if defined(__GNUG__) || defined(__clang__)
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wsign-compare"
-        if (x < 0 || x > std::numeric_limits<T>::max()) {
-#pragma GCC diagnostic pop
-#else
-#error The compiler not supported
-#endif
-            return P::overflow(boost::hana::type_c<T>, x);
-        }
-        return static_cast<T>(x);
+/// Call `f` with the values of `packed` or, once `vec()` freed them, with its elements
+template <class T, class F>
+decltype(auto) readValues(Packed<T>& packed, F&& f) {
+    if (!packed.acquire()) {
+        return f(std::as_const(*packed.unpacked.load(std::memory_order_acquire)));
     }
-};
+    struct Release {
+        ~Release() {
+            packed.release();
+        }
+        Packed<T>& packed;
+    } release{packed};
+    return f(std::as_const(packed.values));
+}
 
-template <typename T, typename U, typename P>
-struct ArithmeticCheckedCast<T, U, P, When<
-        std::is_same_v<T, double> &&
-        !std::is_same_v<U, bool>>> {
-    static T apply(U x) noexcept {
-        return x;
-    }
-};
+template <class T>
+T& payload(void* ptr) noexcept {
+    return static_cast<Shared<T>*>(ptr)->value;
+}
 
-template <typename T, typename U, typename P>
-struct ArithmeticCheckedCast<T, U, P, When<
-        !std::is_same_v<T, double> &&
-        !std::is_same_v<T, bool> &&
-        std::is_same_v<U, double>>> {
-    static T apply(U x) {
-        double iptr;
-        if (std::modf(x, &iptr) == 0.0) {
-            return ArithmeticCheckedCast<T, int64_t, P>::apply(static_cast<int64_t>(x));
-        } else {
-            return P::overflow(boost::hana::type_c<T>, x);
-        }
-    }
-};
+template <class T>
+std::atomic<std::size_t>& hashCache(void* ptr) noexcept {
+    return static_cast<Shared<T>*>(ptr)->hash;
+}
 
-template <typename T, typename U, typename P>
-struct ArithmeticCheckedCast<T, U, P, When<
-        std::is_same_v<T, bool> ^ std::is_same_v<U, bool>>> {
-    static T apply(U) {
-        return P::badType(boost::hana::type_c<T>, boost::hana::type_c<U>);
-    }
-};
+/// Finalizer of MurmurHash3
+std::size_t mix(uint64_t x) noexcept {
+    x ^= x >> 33;
+    x *= 0xff51afd7ed558ccdULL;
+    x ^= x >> 33;
+    x *= 0xc4ceb9fe1a85ec53ULL;
+    x ^= x >> 33;
+    return static_cast<std::size_t>(x);
+}
 
-template <typename T, typename U, typename P>
-struct ArithmeticCheckedCast<T, U, P, When<
-        std::is_same_v<T, bool> &&
-        std::is_same_v<U, bool>>> {
-    static T apply(U x) noexcept {
-        return x;
-    }
-};
+std::size_t combine(std::size_t seed, std::size_t x) noexcept {
+    return mix(seed ^ (x + 0x9e3779b97f4a7c15ULL + (seed << 6) + (seed >> 2)));
+}
 
-template <typename Dst>
-struct ArithmeticCheckedCastT {
-    template <typename Src>
-    Dst operator()(Src x) const
-            noexcept(noexcept(ArithmeticCheckedCast<Dst, Src>::apply(x))) {
-        return ArithmeticCheckedCast<Dst, Src>::apply(x);
+template <class T>
+void retain(void* ptr) noexcept {
+    static_cast<Shared<T>*>(ptr)->refs.fetch_add(1, std::memory_order_relaxed);
+}
+
+template <class T>
+void release(void* ptr) noexcept {
+    auto const shared = static_cast<Shared<T>*>(ptr);
+    if (shared->refs.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+        delete shared;
     }
-};
+}
 
-template <typename T>
-constexpr ArithmeticCheckedCastT<T> arithmeticCheckedCast;
+} // namespace
 
-template <typename T>
-struct GetHelper<T, When<std::is_arithmetic_v<T>>> {
-    [[noreturn]] static T apply(Variant::NullType) {
-        throw VariantEmpty(boost::hana::type_c<T>);
+struct Variant::Impl {
+    /// Longest string stored without a heap allocation
+    static constexpr std::size_t local_capacity =
+            sizeof(Variant) - offsetof(Variant, local_) - 1;
+
+    static char* localData(Variant& x) noexcept {
+        return reinterpret_cast<char*>(&x) + offsetof(Variant, local_) + 1;
     }
-    static T apply(bool x) noexcept(noexcept(arithmeticCheckedCast<T>(x))) {
-        return arithmeticCheckedCast<T>(x);
+
+    static char const* localData(Variant const& x) noexcept {
+        return reinterpret_cast<char const*>(&x) + offsetof(Variant, local_) + 1;
     }
-    static T apply(char x) noexcept(noexcept(arithmeticCheckedCast<T>(x))) {
-        return arithmeticCheckedCast<T>(x);
+
+    static void initString(Variant& x, std::string_view str) {
+        x.type_tag_ = TypeTag::string;
+        if (str.size() <= local_capacity) {
+            x.storage_ = Storage::local;
+            x.local_[0] = static_cast<char>(str.size());
+            std::memcpy(localData(x), str.data(), str.size());
+        } else {
+            x.storage_ = Storage::heap;
+            x.value_.ptr = new Shared<std::string>(str);
+        }
     }
-    static T apply(int8_t x) noexcept(noexcept(arithmeticCheckedCast<T>(x))) {
-        return arithmeticCheckedCast<T>(x);
+
+    static void initString(Variant& x, std::string&& str) {
+        if (str.size() <= local_capacity) {
+            initString(x, std::string_view(str));
+        } else {
+            x.type_tag_ = TypeTag::string;
+            x.storage_ = Storage::heap;
+            x.value_.ptr = new Shared<std::string>(std::move(str));
+        }
     }
-    static T apply(uint8_t x) noexcept(noexcept(arithmeticCheckedCast<T>(x))) {
-        return arithmeticCheckedCast<T>(x);
+
+    static void initString(Variant& x, std::string_view str, VariantArena& arena) {
+        if (str.size() <= local_capacity) {
+            initString(x, str);
+        } else {
+            x.type_tag_ = TypeTag::string;
+            x.storage_ = Storage::arena;
+            auto const data = static_cast<char*>(arena.allocate(str.size(), 1));
+            std::memcpy(data, str.data(), str.size());
+            initPointer(x, data, str.size());
+        }
     }
-    static T apply(int16_t x) noexcept(noexcept(arithmeticCheckedCast<T>(x))) {
-        return arithmeticCheckedCast<T>(x);
+
+    /// Make `x` a string referring to `str`, see `fromJsonView()`
+    static void initView(Variant& x, std::string_view str) {
+        if (str.size() <= local_capacity) {
+            initString(x, str);
+        } else {
+            x.type_tag_ = TypeTag::string;
+            x.storage_ = Storage::view;
+            initPointer(x, str.data(), str.size());
+        }
     }
-    static T apply(uint16_t x) noexcept(noexcept(arithmeticCheckedCast<T>(x))) {
-        return arithmeticCheckedCast<T>(x);
+
+    /// Store the location of an arena or view string
+    static void initPointer(Variant& x, char const* data, std::size_t size) noexcept {
+        x.value_.ptr = const_cast<char*>(data);
+        auto const size32 = static_cast<uint32_t>(size);
+        std::memcpy(&x.local_[2], &size32, sizeof(size32));
     }
-    static T apply(int32_t x) noexcept(noexcept(arithmeticCheckedCast<T>(x))) {
-        return arithmeticCheckedCast<T>(x);
+
+    static std::string_view string(Variant const& x) noexcept {
+        assert(x.type_tag_ == TypeTag::string);
+        switch (x.storage_) {
+        case Storage::local:
+            return std::string_view(localData(x), static_cast<uint8_t>(x.local_[0]));
+        case Storage::arena:
+        case Storage::view: {
+            uint32_t size;
+            std::memcpy(&size, &x.local_[2], sizeof(size));
+            return std::string_view(static_cast<char const*>(x.value_.ptr), size);
+        }
+        case Storage::heap:
+            break;
+        }
+        return payload<std::string>(x.value_.ptr);
     }
-    static T apply(uint32_t x) noexcept(noexcept(arithmeticCheckedCast<T>(x))) {
-        return arithmeticCheckedCast<T>(x);
+
+    /// Create an empty `Vec` or `Map` in `arena`
+    ///
+    /// The entries of a `Map` follow it into the arena, the buffer of a `Vec` is on the
+    /// heap since `Vec` is a plain `std::vector`.
+    template <class T>
+    static Variant container(VariantArena& arena) {
+        Variant ret;
+        ret.type_tag_ = std::is_same_v<T, Vec> ? TypeTag::vec : TypeTag::map;
+        ret.storage_ = Storage::arena;
+        auto const ptr = arena.allocate(sizeof(Shared<T>), alignof(Shared<T>));
+        if constexpr (std::is_same_v<T, Map>) {
+            ret.value_.ptr = new (ptr) Shared<Map>(Map::allocator_type(&arena));
+        } else {
+            ret.value_.ptr = new (ptr) Shared<Vec>();
+        }
+        return ret;
     }
-    static T apply(int64_t x) noexcept(noexcept(arithmeticCheckedCast<T>(x))) {
-        return arithmeticCheckedCast<T>(x);
+
+    /// The tag of the packed array stored as `T`
+    template <class T>
+    static constexpr TypeTag packedTag() noexcept {
+        if constexpr (std::is_same_v<T, Int64Vec>) {
+            return TypeTag::int64_vec;
+        } else if constexpr (std::is_same_v<T, Uint64Vec>) {
+            return TypeTag::uint64_vec;
+        } else if constexpr (std::is_same_v<T, DoubleVec>) {
+            return TypeTag::double_vec;
+        } else {
+            static_assert(std::is_same_v<T, BoolVec>);
+            return TypeTag::bool_vec;
+        }
     }
-    static T apply(uint64_t x) noexcept(noexcept(arithmeticCheckedCast<T>(x))) {
-        return arithmeticCheckedCast<T>(x);
+
+    /// The type of the elements of a packed `T` unless given
+    template <class T>
+    static constexpr TypeTag elementTag() noexcept {
+        if constexpr (std::is_same_v<T, Int64Vec>) {
+            return TypeTag::int64;
+        } else if constexpr (std::is_same_v<T, Uint64Vec>) {
+            return TypeTag::uint64;
+        } else if constexpr (std::is_same_v<T, DoubleVec>) {
+            return TypeTag::double_;
+        } else {
+            static_assert(std::is_same_v<T, BoolVec>);
+            return TypeTag::boolean;
+        }
     }
-    static T apply(double x) noexcept(noexcept(arithmeticCheckedCast<T>(x))) {
-        return arithmeticCheckedCast<T>(x);
+
+    template <class T>
+    static Variant packed(T&& values,
+                          TypeTag element = elementTag<std::decay_t<T>>()) {
+        Variant ret;
+        ret.type_tag_ = packedTag<std::decay_t<T>>();
+        ret.value_.ptr =
+                new Shared<Packed<std::decay_t<T>>>(std::forward<T>(values), element);
+        return ret;
     }
-    [[noreturn]] static T apply(std::string const&) {
-        throw VariantBadType(boost::hana::type_c<T>, boost::hana::type_c<std::string>);
+
+    /// Create a packed array of `n` values filled by `f(i)`, its payload in `arena`
+    template <class T, class F>
+    static Variant packed(std::size_t n, F&& f, VariantArena* arena, TypeTag element) {
+        T values;
+        values.reserve(n);
+        for (std::size_t i = 0; i < n; ++i) {
+            values.push_back(f(i));
+        }
+        if (!arena) {
+            return packed(std::move(values), element);
+        }
+        using Payload = Shared<Packed<T>>;
+        Variant ret;
+        ret.type_tag_ = packedTag<T>();
+        ret.storage_ = Storage::arena;
+        ret.value_.ptr = new (arena->allocate(sizeof(Payload), alignof(Payload)))
+                Payload(std::move(values), element);
+        return ret;
     }
-    [[noreturn]] static T apply(Variant::Vec const&) {
-        throw VariantBadType(boost::hana::type_c<T>, boost::hana::type_c<Variant::Vec>);
+
+    template <class T>
+    static Packed<T>& packedPayload(Variant const& x) noexcept {
+        assert(x.type_tag_ == packedTag<T>());
+        return payload<Packed<T>>(x.value_.ptr);
+    }
+
+    /// Call `f` with the payload of the packed array `x`
+    template <class F>
+    static decltype(auto) visitPacked(Variant const& x, F&& f) {
+        switch (x.type_tag_) {
+        case TypeTag::int64_vec:
+            return f(packedPayload<Int64Vec>(x));
+        case TypeTag::uint64_vec:
+            return f(packedPayload<Uint64Vec>(x));
+        case TypeTag::double_vec:
+            return f(packedPayload<DoubleVec>(x));
+        default:
+            return f(packedPayload<BoolVec>(x));
+        }
     }
-    [[noreturn]] static T apply(Variant::Map const&) {
-        throw VariantBadType(boost::hana::type_c<T>, boost::hana::type_c<Variant::Map>);
+
+    /// Call `f` with the values of the packed array `x` or with its elements, see
+    /// `readValues()`
+    template <class F>
+    static decltype(auto) readPacked(Variant const& x, F&& f) {
+        return visitPacked(x, [&f](auto& packed) -> decltype(auto) {
+            return readValues(packed, f);
+        });
     }
-};
 
-template <typename T>
-struct GetHelper<T, When<std::is_reference_v<T>>> {
-    static T apply(T x) noexcept {
-        return x;
+    /// The type of the elements of the packed array `x`
+    static TypeTag elementTag(Variant const& x) noexcept {
+        return visitPacked(x, [](auto const& packed) { return packed.element; });
     }
-    [[noreturn]] static T apply(Variant::NullType) {
-        throw VariantEmpty(boost::hana::type_c<std::remove_reference_t<T>>);
+
+    /// The element of type `type` holding the packed value `x`
+    template <class T>
+    static Variant unpack(T x, TypeTag type) noexcept {
+        if constexpr (std::is_same_v<T, int64_t>) {
+            switch (type) {
+            case TypeTag::char_:
+                return Variant(static_cast<char>(x));
+            case TypeTag::int8:
+                return Variant(static_cast<int8_t>(x));
+            case TypeTag::uint8:
+                return Variant(static_cast<uint8_t>(x));
+            case TypeTag::int16:
+                return Variant(static_cast<int16_t>(x));
+            case TypeTag::uint16:
+                return Variant(static_cast<uint16_t>(x));
+            case TypeTag::int32:
+                return Variant(static_cast<int32_t>(x));
+            case TypeTag::uint32:
+                return Variant(static_cast<uint32_t>(x));
+            default:
+                break;
+            }
+        }
+        return Variant(x);
     }
-    template <typename U>
-    [[noreturn]] static T apply(U const&) {
-        throw VariantBadType(boost::hana::type_c<std::remove_reference_t<T>>,
-                             boost::hana::type_c<U>);
+
+    static bool isPacked(TypeTag x) noexcept {
+        return x > TypeTag::map;
     }
-};
 
-#if defined(__GNUG__) || defined(__clang__)
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wreturn-type" // safe comparation
-template <class T, class U>
-decltype(auto) getHelper(Variant::TypeTag tag, U value_) {
-    using TypeTag = Variant::TypeTag;
-    switch (tag) {
-    case TypeTag::null:
-        return GetHelper<T>::apply(value_.null_);
-    case TypeTag::boolean:
-        return GetHelper<T>::apply(value_.bool_);
-    case TypeTag::char_:
-        return GetHelper<T>::apply(value_.char_);
-    case TypeTag::int8:
-        return GetHelper<T>::apply(value_.int8);
-    case TypeTag::uint8:
-        return GetHelper<T>::apply(value_.uint8);
-    case TypeTag::int16:
-        return GetHelper<T>::apply(value_.int16);
-    case TypeTag::uint16:
-        return GetHelper<T>::apply(value_.uint16);
-    case TypeTag::int32:
-        return GetHelper<T>::apply(value_.int32);
-    case TypeTag::uint32:
-        return GetHelper<T>::apply(value_.uint32);
-    case TypeTag::int64:
-        return GetHelper<T>::apply(value_.int64);
-    case TypeTag::uint64:
-        return GetHelper<T>::apply(value_.uint64);
-    case TypeTag::double_:
-        return GetHelper<T>::apply(value_.double_);
-    case TypeTag::string:
-        return GetHelper<T>::apply(*reinterpret_cast<std::string*>(value_.ptr));
-    case TypeTag::vec:
-        return GetHelper<T>::apply(*reinterpret_cast<Variant::Vec*>(value_.ptr));
-    case TypeTag::map:
-        return GetHelper<T>::apply(*reinterpret_cast<Variant::Map*>(value_.ptr));
+    /// The elements of the packed array `x` as a `Vec`, created on the first call
+    ///
+    /// Copies of `x` share the payload, the first `Vec` stored wins a concurrent call
+    /// and frees the packed values.
+    static Vec const& unpacked(Variant const& x) {
+        return visitPacked(x, [](auto& packed) -> Vec const& {
+            if (auto const vec = packed.unpacked.load(std::memory_order_acquire)) {
+                return *vec;
+            }
+            auto vec = readValues(packed, [type = packed.element](auto const& values) {
+                using T = typename std::decay_t<decltype(values)>::value_type;
+                auto ret = std::make_unique<Vec>();
+                ret->reserve(values.size());
+                for (auto const& y : values) {
+                    if constexpr (std::is_same_v<T, Variant>) {
+                        ret->push_back(y);
+                    } else {
+                        ret->push_back(unpack(static_cast<T>(y), type));
+                    }
+                }
+                return ret;
+            });
+            Vec* expected = nullptr;
+            if (packed.unpacked.compare_exchange_strong(expected,
+                                                        vec.get(),
+                                                        std::memory_order_acq_rel,
+                                                        std::memory_order_acquire)) {
+                packed.drop();
+                return *vec.release();
+            }
+            return *expected;
+        });
     }
-}
-#pragma GCC diagnostic pop
-#else
-#error The compiler not supported
-#endif
 
-} // namespace
+    /// The values of the packed array `x` for a getter, acquired for good
+    /// \throw VariantBadType if `vec()` freed them.
+    template <class T>
+    static T const& pinned(Variant const& x);
+
+    /// Replace the `Vec` of `x` by a packed array if the elements are all booleans or
+    /// all numbers of one type
+    ///
+    /// Integers narrower than `uint64_t` are packed as `int64_t`, `vec()` gives them back
+    /// with their own type.
+    static void pack(Variant& x, VariantArena* arena);
+
+    /// Number of elements of a `vec` or a packed array
+    static std::size_t size(Variant const& x) noexcept {
+        if (x.type_tag_ == TypeTag::vec) {
+            return payload<Vec>(x.value_.ptr).size();
+        }
+        return readPacked(x, [](auto const& values) { return values.size(); });
+    }
 
-#define GET_HELPER(T, tag, value, x)                                                     \
-    if ((tag) == TypeTag::null) {                                                        \
-        return x;                                                                        \
-    } else {                                                                             \
-        return getHelper<T>(tag, value);                                                 \
-    }                                                                                    \
-    (void)x
+    /// Element `i` of a `vec` or a packed array
+    static Variant element(Variant const& x, std::size_t i) {
+        if (x.type_tag_ == TypeTag::vec) {
+            return payload<Vec>(x.value_.ptr)[i];
+        }
+        return readPacked(x, [i, type = elementTag(x)](auto const& values) {
+            return at(values, i, type);
+        });
+    }
 
-Variant::operator Variant::NullType() const {
-    return getHelper<NullType>(type_tag_, value_);
-}
+    /// Element `i` of the values of a packed array of elements of type `type` or of its
+    /// `Vec`
+    template <class T>
+    static Variant at(T const& values, std::size_t i, TypeTag type) noexcept {
+        if constexpr (std::is_same_v<T, Vec>) {
+            return values[i];
+        } else {
+            return unpack(static_cast<typename T::value_type>(values[i]), type);
+        }
+    }
 
-char Variant::character() const {
-    return getHelper<char>(type_tag_, value_);
-}
+    /// `operator==` of two arrays, at least one of them packed
+    static bool sameElements(Variant const& lhs, Variant const& rhs) noexcept;
 
-char Variant::characterOr(char x) const {
-    GET_HELPER(char, type_tag_, value_, x);
-}
+    /// `equal()` of two arrays, at least one of them packed
+    static bool equalVec(Variant const& lhs, Variant const& rhs);
 
-int8_t Variant::int8() const {
-    return getHelper<int8_t>(type_tag_, value_);
-}
+    static std::size_t hash(Variant const& x) noexcept;
 
-int8_t Variant::int8Or(int8_t x) const {
-    GET_HELPER(int8_t, type_tag_, value_, x);
-}
+    /// The hash of the payload `T` of `x`, computed by `f` unless cached
+    template <class T, class F>
+    static std::size_t hashOnce(Variant const& x, F&& f) noexcept {
+        auto& cache = hashCache<T>(x.value_.ptr);
+        auto ret = cache.load(std::memory_order_relaxed);
+        if (ret == 0) {
+            ret = f(payload<T>(x.value_.ptr));
+            // 0 marks a hash not computed yet
+            ret += ret == 0;
+            cache.store(ret, std::memory_order_relaxed);
+        }
+        return ret;
+    }
 
-uint8_t Variant::uint8() const {
-    return getHelper<uint8_t>(type_tag_, value_);
-}
+    /// The hash of a container or packed array if computed, 0 otherwise
+    static std::size_t cachedHash(Variant const& x) noexcept {
+        switch (x.type_tag_) {
+        case TypeTag::vec:
+            return hashCache<Vec>(x.value_.ptr).load(std::memory_order_relaxed);
+        case TypeTag::map:
+            return hashCache<Map>(x.value_.ptr).load(std::memory_order_relaxed);
+        case TypeTag::int64_vec:
+        case TypeTag::uint64_vec:
+        case TypeTag::double_vec:
+        case TypeTag::bool_vec:
+            return visitPacked(x, [&x](auto const& packed) {
+                using T = std::decay_t<decltype(packed)>;
+                return hashCache<T>(x.value_.ptr).load(std::memory_order_relaxed);
+            });
+        default:
+            return 0;
+        }
+    }
 
-uint8_t Variant::uint8Or(uint8_t x) const {
-    GET_HELPER(uint8_t, type_tag_, value_, x);
-}
+    /// False if `lhs` and `rhs` have different cached hashes
+    static bool mayEqual(Variant const& lhs, Variant const& rhs) noexcept {
+        auto const lhs_hash = cachedHash(lhs);
+        auto const rhs_hash = cachedHash(rhs);
+        return lhs_hash == 0 || rhs_hash == 0 || lhs_hash == rhs_hash;
+    }
 
-int16_t Variant::int16() const {
-    return getHelper<int16_t>(type_tag_, value_);
-}
+    /// Copy `src` into uninitialized `dst`, the copy never refers to an arena
+    ///
+    /// Heap payloads are shared, arena payloads are copied to the heap.
+    static void copy(Variant& dst, Variant const& src) {
+        switch (src.type_tag_) {
+        case TypeTag::string:
+            if (src.storage_ == Storage::arena) {
+                initString(dst, string(src));
+                return;
+            }
+            if (src.storage_ == Storage::heap) {
+                retain<std::string>(src.value_.ptr);
+            }
+            break;
+        case TypeTag::vec:
+            if (src.storage_ == Storage::arena) {
+                copyContainer<Vec>(dst, src);
+                return;
+            }
+            retain<Vec>(src.value_.ptr);
+            break;
+        case TypeTag::map:
+            if (src.storage_ == Storage::arena) {
+                copyContainer<Map>(dst, src);
+                return;
+            }
+            retain<Map>(src.value_.ptr);
+            break;
+        case TypeTag::int64_vec:
+        case TypeTag::uint64_vec:
+        case TypeTag::double_vec:
+        case TypeTag::bool_vec:
+            visitPacked(src, [&dst, &src](auto& packed) {
+                using T = std::decay_t<decltype(packed)>;
+                if (src.storage_ != Storage::arena) {
+                    retain<T>(src.value_.ptr);
+                    std::memcpy(static_cast<void*>(&dst), &src, sizeof(Variant));
+                } else if (packed.acquire()) {
+                    copyContainer<T>(dst, src);
+                    packed.release();
+                } else {
+                    new (&dst) Variant(Vec(*packed.unpacked.load(std::memory_order_acquire)));
+                }
+            });
+            return;
+        default:
+            break;
+        }
+        std::memcpy(static_cast<void*>(&dst), &src, sizeof(Variant));
+    }
 
-int16_t Variant::int16Or(int16_t x) const {
-    GET_HELPER(int16_t, type_tag_, value_, x);
-}
+    /// Copy the container of `src` into uninitialized `dst` as a heap payload
+    template <class T>
+    static void copyContainer(Variant& dst, Variant const& src) {
+        dst.type_tag_ = src.type_tag_;
+        dst.storage_ = Storage::heap;
+        dst.value_.ptr = new Shared<T>(payload<T>(src.value_.ptr));
+        hashCache<T>(dst.value_.ptr)
+                .store(hashCache<T>(src.value_.ptr).load(std::memory_order_relaxed),
+                       std::memory_order_relaxed);
+    }
+
+    /// Replace the view strings of the tree `x` by heap or local ones
+    static void materialize(Variant& x) {
+        switch (x.type_tag_) {
+        case TypeTag::string:
+            if (x.storage_ == Storage::view) {
+                initString(x, string(x));
+            }
+            break;
+        case TypeTag::vec:
+            for (auto& y : x.modifyVec()) {
+                materialize(y);
+            }
+            break;
+        case TypeTag::map:
+            for (auto& y : x.modifyMap()) {
+                materialize(y.second);
+            }
+            break;
+        default:
+            break;
+        }
+    }
 
-uint16_t Variant::uint16() const {
-    return getHelper<uint16_t>(type_tag_, value_);
-}
+    /// Add `x` at nesting level `depth` and its descendants to `ret`
+    ///
+    /// `seen` holds the heap payloads already counted.
+    static void stats(Variant const& x,
+                      std::size_t depth,
+                      VariantStats& ret,
+                      std::unordered_set<void const*>& seen);
 
-uint16_t Variant::uint16Or(uint16_t x) const {
-    GET_HELPER(uint16_t, type_tag_, value_, x);
-}
+    /// Give `x` its own heap `Vec` or `Map` if the current one is shared
+    ///
+    /// The elements of the new container share their payloads with the old ones, so
+    /// only the container itself is copied. The cached hash is reset.
+    template <class T>
+    static void detach(Variant& x) {
+        if (x.storage_ != Storage::heap) {
+            hashCache<T>(x.value_.ptr).store(0, std::memory_order_relaxed);
+            return;
+        }
+        auto const shared = static_cast<Shared<T>*>(x.value_.ptr);
+        if (shared->refs.load(std::memory_order_acquire) == 1) {
+            shared->hash.store(0, std::memory_order_relaxed);
+            return;
+        }
+        x.value_.ptr = new Shared<T>(shared->value);
+        release<T>(shared);
+    }
 
-bool Variant::boolean() const {
-    return getHelper<bool>(type_tag_, value_);
-}
+    template <typename Encoding>
+    struct FromJson;
 
-bool Variant::booleanOr(bool x) const {
-    GET_HELPER(bool, type_tag_, value_, x);
-}
+    struct ToJson;
 
-int32_t Variant::int32() const {
-    return getHelper<int32_t>(type_tag_, value_);
-}
+    /// Write `var` to the RapidJSON output stream `out` by the writer `Writer`
+    template <template <class> class Writer, class Output>
+    static void writeJson(Variant const& var, Output& out);
+};
 
-int32_t Variant::int32Or(int32_t x) const {
-    GET_HELPER(int32_t, type_tag_, value_, x);
-}
+static_assert(sizeof(Variant) == 16);
+static_assert(std::is_standard_layout_v<Variant>);
 
-uint32_t Variant::uint32() const {
-    return getHelper<uint32_t>(type_tag_, value_);
+Variant::~Variant() noexcept {
+    switch (type_tag_) {
+    case TypeTag::string:
+        if (storage_ == Storage::heap) {
+            release<std::string>(value_.ptr);
+        }
+        break;
+    case TypeTag::vec:
+        if (storage_ == Storage::heap) {
+            release<Vec>(value_.ptr);
+        } else {
+            static_cast<Shared<Vec>*>(value_.ptr)->~Shared();
+        }
+        break;
+    case TypeTag::map:
+        if (storage_ == Storage::heap) {
+            release<Map>(value_.ptr);
+        } else {
+            static_cast<Shared<Map>*>(value_.ptr)->~Shared();
+        }
+        break;
+    case TypeTag::int64_vec:
+    case TypeTag::uint64_vec:
+    case TypeTag::double_vec:
+    case TypeTag::bool_vec:
+        Impl::visitPacked(*this, [this](auto const& packed) {
+            using T = std::decay_t<decltype(packed)>;
+            if (storage_ == Storage::heap) {
+                release<T>(value_.ptr);
+            } else {
+                static_cast<Shared<T>*>(value_.ptr)->~Shared();
+            }
+        });
+        break;
+    default:
+        break;
+    }
 }
 
-uint32_t Variant::uint32Or(uint32_t x) const {
-    GET_HELPER(uint32_t, type_tag_, value_, x);
+Variant::Variant() noexcept
+        : type_tag_(TypeTag::null)
+        , value_(NullType{}) {
 }
-
-int64_t Variant::int64() const {
-    return getHelper<int64_t>(type_tag_, value_);
+Variant::Variant(NullType x) noexcept
+        : type_tag_(TypeTag::null)
+        , value_(x) {
 }
-
-int64_t Variant::int64Or(int64_t x) const {
-    GET_HELPER(int64_t, type_tag_, value_, x);
+Variant::Variant(bool x) noexcept
+        : type_tag_(TypeTag::boolean)
+        , value_(x) {
 }
-
-uint64_t Variant::uint64() const {
-    return getHelper<uint64_t>(type_tag_, value_);
+Variant::Variant(char x) noexcept
+        : type_tag_(TypeTag::char_)
+        , value_(x) {
 }
-
-uint64_t Variant::uint64Or(uint64_t x) const {
-    GET_HELPER(uint64_t, type_tag_, value_, x);
+Variant::Variant(int8_t x) noexcept
+        : type_tag_(TypeTag::int8)
+        , value_(x) {
 }
-
-double Variant::floating() const {
-    return getHelper<double>(type_tag_, value_);
+Variant::Variant(uint8_t x) noexcept
+        : type_tag_(TypeTag::uint8)
+        , value_(x) {
 }
-
-double Variant::floatingOr(double x) const {
-    GET_HELPER(double, type_tag_, value_, x);
+Variant::Variant(int16_t x) noexcept
+        : type_tag_(TypeTag::int16)
+        , value_(x) {
+}
+Variant::Variant(uint16_t x) noexcept
+        : type_tag_(TypeTag::uint16)
+        , value_(x) {
+}
+Variant::Variant(int32_t x) noexcept
+        : type_tag_(TypeTag::int32)
+        , value_(x) {
+}
+Variant::Variant(uint32_t x) noexcept
+        : type_tag_(TypeTag::uint32)
+        , value_(x) {
+}
+Variant::Variant(int64_t x) noexcept
+        : type_tag_(TypeTag::int64)
+        , value_(x) {
+}
+Variant::Variant(uint64_t x) noexcept
+        : type_tag_(TypeTag::uint64)
+        , value_(x) {
+}
+Variant::Variant(double x) noexcept
+        : type_tag_(TypeTag::double_)
+        , value_(x) {
 }
 
-std::string const& Variant::str() const {
-    return getHelper<std::string>(type_tag_, value_);
+Variant::Variant(char const* const& x) {
+    Impl::initString(*this, std::string_view(x));
 }
 
-std::string Variant::strOr(std::string const& x) const {
-    GET_HELPER(std::string, type_tag_, value_, x);
+Variant::Variant(std::string const& x) {
+    Impl::initString(*this, std::string_view(x));
+}
+Variant::Variant(std::string&& x) {
+    Impl::initString(*this, std::move(x));
+}
+Variant::Variant(std::string_view x) {
+    Impl::initString(*this, x);
 }
 
-Variant::Vec const& Variant::vec() const {
-    return getHelper<Vec>(type_tag_, value_);
+Variant::Variant(Vec const& x)
+        : type_tag_(TypeTag::vec)
+        , value_(new Shared<Vec>(x)) {
+}
+Variant::Variant(Vec&& x)
+        : type_tag_(TypeTag::vec)
+        , value_(new Shared<Vec>(std::move(x))) {
 }
 
-Variant::Vec Variant::vecOr(Vec const& x) const {
-    GET_HELPER(Vec, type_tag_, value_, x);
+Variant::Variant(Map const& x)
+        : type_tag_(TypeTag::map)
+        , value_(new Shared<Map>(x)) {
+}
+Variant::Variant(Map&& x)
+        : type_tag_(TypeTag::map)
+        , value_(new Shared<Map>(std::move(x))) {
 }
 
-Variant::Vec& Variant::modifyVec() {
-    return getHelper<Vec&>(type_tag_, value_);
+Variant::Variant(Int64Vec const& x)
+        : Variant(Impl::packed(Int64Vec(x))) {
+}
+Variant::Variant(Int64Vec&& x)
+        : Variant(Impl::packed(std::move(x))) {
+}
+Variant::Variant(Uint64Vec const& x)
+        : Variant(Impl::packed(Uint64Vec(x))) {
+}
+Variant::Variant(Uint64Vec&& x)
+        : Variant(Impl::packed(std::move(x))) {
+}
+Variant::Variant(DoubleVec const& x)
+        : Variant(Impl::packed(DoubleVec(x))) {
+}
+Variant::Variant(DoubleVec&& x)
+        : Variant(Impl::packed(std::move(x))) {
+}
+Variant::Variant(BoolVec const& x)
+        : Variant(Impl::packed(BoolVec(x))) {
+}
+Variant::Variant(BoolVec&& x)
+        : Variant(Impl::packed(std::move(x))) {
+}
+Variant::Variant(Int64Vec values, TypeTag element)
+        : Variant(Impl::packed(std::move(values), element)) {
+    assert(element >= TypeTag::char_ && element <= TypeTag::int64);
 }
 
-Variant::Map const& Variant::map() const {
-    return getHelper<Map>(type_tag_, value_);
+Variant::Variant(Variant const& rhs) {
+    Impl::copy(*this, rhs);
 }
 
-Variant::Map Variant::mapOr(Map const& x) const {
-    GET_HELPER(Map, type_tag_, value_, x);
+Variant& Variant::operator=(Variant const& rhs) {
+    Variant tmp(rhs);
+    operator=(std::move(tmp));
+    return *this;
 }
 
-Variant::Map& Variant::modifyMap() {
-    return getHelper<Map&>(type_tag_, value_);
+Variant::Variant(Variant&& rhs) noexcept {
+    std::memcpy(static_cast<void*>(this), &rhs, sizeof(Variant));
+    rhs.type_tag_ = TypeTag::null;
+    rhs.value_.null_ = {};
 }
 
-#if defined(__GNUG__) || defined(__clang__)
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wfloat-equal" // safe comparation
-bool Variant::operator==(Variant const& rhs) const noexcept {
-    if (type_tag_ != rhs.type_tag_) {
-        return false;
-    } else {
-        switch (type_tag_) {
-        case TypeTag::null:
-            return true;
-        case TypeTag::boolean:
-            return value_.bool_ == rhs.value_.bool_;
-        case TypeTag::char_:
-            return value_.char_ == rhs.value_.char_;
-        case TypeTag::int8:
-            return value_.int8 == rhs.value_.int8;
-        case TypeTag::uint8:
-            return value_.uint8 == rhs.value_.uint8;
-        case TypeTag::int16:
-            return value_.int16 == rhs.value_.int16;
-        case TypeTag::uint16:
-            return value_.uint16 == rhs.value_.uint16;
-        case TypeTag::int32:
-            return value_.int32 == rhs.value_.int32;
-        case TypeTag::uint32:
-            return value_.uint32 == rhs.value_.uint32;
-        case TypeTag::int64:
-            return value_.int64 == rhs.value_.int64;
-        case TypeTag::uint64:
-            return value_.uint64 == rhs.value_.uint64;
-        case TypeTag::double_:
-            return value_.double_ == rhs.value_.double_;
-        case TypeTag::string:
-            return *reinterpret_cast<std::string*>(value_.ptr)
-                == *reinterpret_cast<std::string*>(rhs.value_.ptr);
-        case TypeTag::vec:
-            return *reinterpret_cast<Variant::Vec*>(value_.ptr)
-                == *reinterpret_cast<Variant::Vec*>(rhs.value_.ptr);
-        case TypeTag::map:
-            return *reinterpret_cast<Variant::Map*>(value_.ptr)
-                == *reinterpret_cast<Variant::Map*>(rhs.value_.ptr);
-        }
-        return false;
-    }
+Variant& Variant::operator=(Variant&& rhs) noexcept {
+    this->~Variant();
+    new (this) Variant(std::move(rhs));
+    return *this;
 }
-#pragma GCC diagnostic pop
-#else
-#error The compiler not supported
-#endif
 
 namespace {
 
-struct ArithmeticCheckedEqT {
-    template <typename Lhs, typename Rhs>
-    bool operator()(Lhs lhs, Rhs rhs) const noexcept;
-};
-
-constexpr ArithmeticCheckedEqT arithmeticCheckedEq;
+template <typename T, typename = void>
+struct GetHelper final : GetHelper<T, When<true>> {};
 
-template <typename T, typename U, typename = void>
-struct ArithmeticCheckedEq final : ArithmeticCheckedEq<T, U, When<true>> {
-    static_assert(std::is_arithmetic_v<T> && std::is_arithmetic_v<U>);
+template <typename T, bool condition>
+struct GetHelper<T, When<condition>> {
+    static T const& apply(T const& x) noexcept {
+        return x;
+    }
+    [[noreturn]] static T const& apply(Variant::NullType) {
+        throw VariantEmpty(boost::hana::type_c<T>);
+    }
+    [[noreturn]] static T const& apply(std::string_view) {
+        throw VariantBadType(boost::hana::type_c<T>, boost::hana::type_c<std::string>);
+    }
+    template <typename U>
+    [[noreturn]] static T const& apply(U const&) {
+        throw VariantBadType(boost::hana::type_c<T>, boost::hana::type_c<U>);
+    }
 };
 
-template <typename T, typename U>
-struct ArithmeticCheckedEq<T, U, When<
+template <>
+struct GetHelper<Variant::NullType> {
+    static Variant::NullType apply(Variant::NullType) noexcept {
+        return {};
+    }
+    [[noreturn]] static Variant::NullType apply(std::string_view) {
+        throw VariantBadType(boost::hana::type_c<Variant::NullType>,
+                             boost::hana::type_c<std::string>);
+    }
+    template <typename U>
+    [[noreturn]] static Variant::NullType apply(U const&) {
+        throw VariantBadType(boost::hana::type_c<Variant::NullType>,
+                             boost::hana::type_c<U>);
+    }
+};
+
+template <typename A, typename B>
+constexpr auto same_sign_v = std::is_signed_v<A> == std::is_signed_v<B>;
+
+struct ThrowVariantIntegralOverflow {
+    template <class Type, class Value>
+    [[noreturn]] static typename Type::type overflow(Type t, Value v) {
+        throw VariantIntegralOverflow(std::string(typeName(t)), std::to_string(v));
+    }
+    template <class Type1, class Type2>
+    [[noreturn]] static typename Type1::type badType(Type1 t1, Type2 t2) {
+        throw VariantBadType(t1, t2);
+    }
+};
+
+// Casts `U` to `T` if a specific value of `U` is representable in `T` else throws
+// `VariantIntegralOverflow`.
+template <typename T,
+          typename U,
+          typename ThrowPolicy = ThrowVariantIntegralOverflow,
+          typename = void>
+struct ArithmeticCheckedCast final
+        : ArithmeticCheckedCast<T, U, ThrowPolicy, When<true>> {
+    static_assert(std::is_arithmetic_v<T> && (std::is_arithmetic_v<U>));
+};
+
+template <typename T, typename U, typename P>
+struct ArithmeticCheckedCast<T, U, P, When<
         !std::is_same_v<T, double> &&
         !std::is_same_v<T, bool> &&
         !std::is_same_v<U, double> &&
         !std::is_same_v<U, bool> &&
         same_sign_v<T, U> && sizeof(T) >= sizeof(U)>> {
-    static bool apply(T lhs, U rhs) noexcept {
-        return lhs == rhs;
+    static T apply(U x) noexcept {
+        return x;
     }
 };
 
-template <typename T, typename U>
-struct ArithmeticCheckedEq<T, U, When<
+template <typename T, typename U, typename P>
+struct ArithmeticCheckedCast<T, U, P, When<
         !std::is_same_v<T, double> &&
         !std::is_same_v<T, bool> &&
         !std::is_same_v<U, double> &&
         !std::is_same_v<U, bool> &&
         same_sign_v<T, U> && sizeof(T) < sizeof(U)>> {
-    static bool apply(T lhs, U rhs) {
-        return lhs == rhs;
+    static T apply(U x) {
+        if (x < std::numeric_limits<T>::min() || x > std::numeric_limits<T>::max()) {
+            return P::overflow(boost::hana::type_c<T>, x);
+        } else {
+            return static_cast<T>(x);
+        }
     }
 };
 
-template <typename T, typename U>
-struct ArithmeticCheckedEq<T, U, When<
+template <typename T, typename U, typename P>
+struct ArithmeticCheckedCast<T, U, P, When<
         !std::is_same_v<T, double> &&
         !std::is_same_v<T, bool> &&
         !std::is_same_v<U, double> &&
         !std::is_same_v<U, bool> &&
         std::is_signed_v<T> && std::is_unsigned_v<U> && (sizeof(T) > sizeof(U))>> {
-    static bool apply(T lhs, U rhs) noexcept {
-        return lhs == rhs;
+    static T apply(U x) noexcept {
+        return x;
     }
 };
 
-template <typename T, typename U>
-struct ArithmeticCheckedEq<T, U, When<
+template <typename T, typename U, typename P>
+struct ArithmeticCheckedCast<T, U, P, When<
         !std::is_same_v<T, double> &&
         !std::is_same_v<T, bool> &&
         !std::is_same_v<U, double> &&
         !std::is_same_v<U, bool> &&
         std::is_signed_v<T> && std::is_unsigned_v<U> && (sizeof(T) <= sizeof(U))>> {
-    static bool apply(T lhs, U rhs) {
-        if (lhs < 0) {
-            return false;
-        } else {
-            return static_cast<U>(lhs) == rhs;
+    static T apply(U x) {
+#if defined(__GNUG__) || defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wsign-compare"
+        if (x > std::numeric_limits<T>::max()) {
+#pragma GCC diagnostic pop
+#else
+#error The compiler not supported
+#endif
+            return P::overflow(boost::hana::type_c<T>, x);
         }
+        return static_cast<T>(x);
     }
 };
 
-template <typename T, typename U>
-struct ArithmeticCheckedEq<T, U, When<
+template <typename T, typename U, typename P>
+struct ArithmeticCheckedCast<T, U, P, When<
         !std::is_same_v<T, double> &&
         !std::is_same_v<T, bool> &&
         !std::is_same_v<U, double> &&
         !std::is_same_v<U, bool> &&
         std::is_unsigned_v<T> && std::is_signed_v<U> && sizeof(T) >= sizeof(U)>> {
-    static bool apply(T lhs, U rhs) {
-        return arithmeticCheckedEq(rhs, lhs);
+    static T apply(U x) {
+        if (x < 0) {
+            return P::overflow(boost::hana::type_c<T>, x);
+        } else {
+            return static_cast<T>(x);
+        }
     }
 };
 
-template <typename T, typename U>
-struct ArithmeticCheckedEq<T, U, When<
+template <typename T, typename U, typename P>
+struct ArithmeticCheckedCast<T, U, P, When<
         !std::is_same_v<T, double> &&
         !std::is_same_v<T, bool> &&
         !std::is_same_v<U, double> &&
         !std::is_same_v<U, bool> &&
         std::is_unsigned_v<T> && std::is_signed_v<U> && sizeof(T) < sizeof(U)>> {
-    static bool apply(T lhs, U rhs) {
-        return lhs == rhs;
+    static T apply(U x) {
+#if defined(__GNUG__) || defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wsign-compare"
+        if (x < 0 || x > std::numeric_limits<T>::max()) {
+#pragma GCC diagnostic pop
+#else
+#error The compiler not supported
+#endif
+            return P::overflow(boost::hana::type_c<T>, x);
+        }
+        return static_cast<T>(x);
     }
 };
 
-#if defined(__GNUG__) || defined(__clang__)
-#pragma GCC diagnostic push
-#pragma GCC diagnostic ignored "-Wfloat-equal"
-template <typename T, typename U>
-struct ArithmeticCheckedEq<T, U, When<
+template <typename T, typename U, typename P>
+struct ArithmeticCheckedCast<T, U, P, When<
         std::is_same_v<T, double> &&
         !std::is_same_v<U, bool>>> {
-    static bool apply(T lhs, U rhs) {
-        return lhs == rhs;
+    static T apply(U x) noexcept {
+        return x;
     }
 };
 
-template <typename T, typename U>
-struct ArithmeticCheckedEq<T, U, When<
+template <typename T, typename U, typename P>
+struct ArithmeticCheckedCast<T, U, P, When<
         !std::is_same_v<T, double> &&
         !std::is_same_v<T, bool> &&
         std::is_same_v<U, double>>> {
-    static bool apply(T lhs, U rhs) {
-        return lhs == rhs;
+    static T apply(U x) {
+        double iptr;
+        if (std::modf(x, &iptr) == 0.0) {
+            return ArithmeticCheckedCast<T, int64_t, P>::apply(static_cast<int64_t>(x));
+        } else {
+            return P::overflow(boost::hana::type_c<T>, x);
+        }
     }
 };
-#pragma GCC diagnostic pop
-#else
-#error The compiler not supported
-#endif
 
-template <typename T, typename U>
-struct ArithmeticCheckedEq<T, U, When<
+template <typename T, typename U, typename P>
+struct ArithmeticCheckedCast<T, U, P, When<
         std::is_same_v<T, bool> ^ std::is_same_v<U, bool>>> {
-    static bool apply(T, U) {
-        return false;
+    static T apply(U) {
+        return P::badType(boost::hana::type_c<T>, boost::hana::type_c<U>);
     }
 };
 
-template <typename T, typename U>
-struct ArithmeticCheckedEq<T, U, When<
+template <typename T, typename U, typename P>
+struct ArithmeticCheckedCast<T, U, P, When<
         std::is_same_v<T, bool> &&
         std::is_same_v<U, bool>>> {
-    static bool apply(T lhs, U rhs) {
-        return lhs == rhs;
+    static T apply(U x) noexcept {
+        return x;
     }
 };
 
-template <typename Lhs, typename Rhs>
-bool ArithmeticCheckedEqT::operator()(Lhs lhs, Rhs rhs) const noexcept {
-    return ArithmeticCheckedEq<Lhs, Rhs>::apply(lhs, rhs);
-}
+template <typename Dst>
+struct ArithmeticCheckedCastT {
+    template <typename Src>
+    Dst operator()(Src x) const
+            noexcept(noexcept(ArithmeticCheckedCast<Dst, Src>::apply(x))) {
+        return ArithmeticCheckedCast<Dst, Src>::apply(x);
+    }
+};
+
+template <typename T>
+constexpr ArithmeticCheckedCastT<T> arithmeticCheckedCast;
+
+template <typename T>
+struct GetHelper<T, When<std::is_arithmetic_v<T>>> {
+    [[noreturn]] static T apply(Variant::NullType) {
+        throw VariantEmpty(boost::hana::type_c<T>);
+    }
+    static T apply(bool x) noexcept(noexcept(arithmeticCheckedCast<T>(x))) {
+        return arithmeticCheckedCast<T>(x);
+    }
+    static T apply(char x) noexcept(noexcept(arithmeticCheckedCast<T>(x))) {
+        return arithmeticCheckedCast<T>(x);
+    }
+    static T apply(int8_t x) noexcept(noexcept(arithmeticCheckedCast<T>(x))) {
+        return arithmeticCheckedCast<T>(x);
+    }
+    static T apply(uint8_t x) noexcept(noexcept(arithmeticCheckedCast<T>(x))) {
+        return arithmeticCheckedCast<T>(x);
+    }
+    static T apply(int16_t x) noexcept(noexcept(arithmeticCheckedCast<T>(x))) {
+        return arithmeticCheckedCast<T>(x);
+    }
+    static T apply(uint16_t x) noexcept(noexcept(arithmeticCheckedCast<T>(x))) {
+        return arithmeticCheckedCast<T>(x);
+    }
+    static T apply(int32_t x) noexcept(noexcept(arithmeticCheckedCast<T>(x))) {
+        return arithmeticCheckedCast<T>(x);
+    }
+    static T apply(uint32_t x) noexcept(noexcept(arithmeticCheckedCast<T>(x))) {
+        return arithmeticCheckedCast<T>(x);
+    }
+    static T apply(int64_t x) noexcept(noexcept(arithmeticCheckedCast<T>(x))) {
+        return arithmeticCheckedCast<T>(x);
+    }
+    static T apply(uint64_t x) noexcept(noexcept(arithmeticCheckedCast<T>(x))) {
+        return arithmeticCheckedCast<T>(x);
+    }
+    static T apply(double x) noexcept(noexcept(arithmeticCheckedCast<T>(x))) {
+        return arithmeticCheckedCast<T>(x);
+    }
+    [[noreturn]] static T apply(std::string_view) {
+        throw VariantBadType(boost::hana::type_c<T>, boost::hana::type_c<std::string>);
+    }
+    [[noreturn]] static T apply(Variant::Vec const&) {
+        throw VariantBadType(boost::hana::type_c<T>, boost::hana::type_c<Variant::Vec>);
+    }
+    [[noreturn]] static T apply(Variant::Map const&) {
+        throw VariantBadType(boost::hana::type_c<T>, boost::hana::type_c<Variant::Map>);
+    }
+    template <typename U>
+    [[noreturn]] static T apply(std::vector<U> const&) {
+        throw VariantBadType(boost::hana::type_c<T>, boost::hana::type_c<std::vector<U>>);
+    }
+};
 
+template <typename T>
+struct GetHelper<T, When<std::is_reference_v<T>>> {
+    static T apply(T x) noexcept {
+        return x;
+    }
+    [[noreturn]] static T apply(Variant::NullType) {
+        throw VariantEmpty(boost::hana::type_c<std::remove_reference_t<T>>);
+    }
+    [[noreturn]] static T apply(std::string_view) {
+        throw VariantBadType(boost::hana::type_c<std::remove_reference_t<T>>,
+                             boost::hana::type_c<std::string>);
+    }
+    template <typename U>
+    [[noreturn]] static T apply(U const&) {
+        throw VariantBadType(boost::hana::type_c<std::remove_reference_t<T>>,
+                             boost::hana::type_c<U>);
+    }
+};
+
+#if defined(__GNUG__) || defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wreturn-type" // safe comparation
 template <class T, class U>
-bool equalArithmetic(T lhs, Variant::TypeTag tag, U const& rhs) {
+decltype(auto) getHelper(Variant::TypeTag tag, U value_) {
     using TypeTag = Variant::TypeTag;
-    static_assert(std::is_arithmetic_v<T>);
     switch (tag) {
     case TypeTag::null:
-        return false;
+        return GetHelper<T>::apply(value_.null_);
     case TypeTag::boolean:
-        return arithmeticCheckedEq(lhs, rhs.bool_);
+        return GetHelper<T>::apply(value_.bool_);
     case TypeTag::char_:
-        return arithmeticCheckedEq(lhs, rhs.char_);
+        return GetHelper<T>::apply(value_.char_);
     case TypeTag::int8:
-        return arithmeticCheckedEq(lhs, rhs.int8);
+        return GetHelper<T>::apply(value_.int8);
     case TypeTag::uint8:
-        return arithmeticCheckedEq(lhs, rhs.uint8);
+        return GetHelper<T>::apply(value_.uint8);
+    case TypeTag::int16:
+        return GetHelper<T>::apply(value_.int16);
+    case TypeTag::uint16:
+        return GetHelper<T>::apply(value_.uint16);
+    case TypeTag::int32:
+        return GetHelper<T>::apply(value_.int32);
+    case TypeTag::uint32:
+        return GetHelper<T>::apply(value_.uint32);
+    case TypeTag::int64:
+        return GetHelper<T>::apply(value_.int64);
+    case TypeTag::uint64:
+        return GetHelper<T>::apply(value_.uint64);
+    case TypeTag::double_:
+        return GetHelper<T>::apply(value_.double_);
+    case TypeTag::string:
+        // only reached on a type mismatch, the string itself is accessed via `str()`
+        return GetHelper<T>::apply(std::string_view());
+    case TypeTag::vec:
+        return GetHelper<T>::apply(payload<Variant::Vec>(value_.ptr));
+    case TypeTag::map:
+        return GetHelper<T>::apply(payload<Variant::Map>(value_.ptr));
+    case TypeTag::int64_vec:
+        return GetHelper<T>::apply(
+                payload<Packed<Variant::Int64Vec>>(value_.ptr).values);
+    case TypeTag::uint64_vec:
+        return GetHelper<T>::apply(
+                payload<Packed<Variant::Uint64Vec>>(value_.ptr).values);
+    case TypeTag::double_vec:
+        return GetHelper<T>::apply(
+                payload<Packed<Variant::DoubleVec>>(value_.ptr).values);
+    case TypeTag::bool_vec:
+        return GetHelper<T>::apply(
+                payload<Packed<Variant::BoolVec>>(value_.ptr).values);
+    }
+}
+#pragma GCC diagnostic pop
+#else
+#error The compiler not supported
+#endif
+
+} // namespace
+
+#define GET_HELPER(T, tag, value, x)                                                     \
+    if ((tag) == TypeTag::null) {                                                        \
+        return x;                                                                        \
+    } else {                                                                             \
+        return getHelper<T>(tag, value);                                                 \
+    }                                                                                    \
+    (void)x
+
+Variant::operator Variant::NullType() const {
+    return getHelper<NullType>(type_tag_, value_);
+}
+
+char Variant::character() const {
+    return getHelper<char>(type_tag_, value_);
+}
+
+char Variant::characterOr(char x) const {
+    GET_HELPER(char, type_tag_, value_, x);
+}
+
+int8_t Variant::int8() const {
+    return getHelper<int8_t>(type_tag_, value_);
+}
+
+int8_t Variant::int8Or(int8_t x) const {
+    GET_HELPER(int8_t, type_tag_, value_, x);
+}
+
+uint8_t Variant::uint8() const {
+    return getHelper<uint8_t>(type_tag_, value_);
+}
+
+uint8_t Variant::uint8Or(uint8_t x) const {
+    GET_HELPER(uint8_t, type_tag_, value_, x);
+}
+
+int16_t Variant::int16() const {
+    return getHelper<int16_t>(type_tag_, value_);
+}
+
+int16_t Variant::int16Or(int16_t x) const {
+    GET_HELPER(int16_t, type_tag_, value_, x);
+}
+
+uint16_t Variant::uint16() const {
+    return getHelper<uint16_t>(type_tag_, value_);
+}
+
+uint16_t Variant::uint16Or(uint16_t x) const {
+    GET_HELPER(uint16_t, type_tag_, value_, x);
+}
+
+bool Variant::boolean() const {
+    return getHelper<bool>(type_tag_, value_);
+}
+
+bool Variant::booleanOr(bool x) const {
+    GET_HELPER(bool, type_tag_, value_, x);
+}
+
+int32_t Variant::int32() const {
+    return getHelper<int32_t>(type_tag_, value_);
+}
+
+int32_t Variant::int32Or(int32_t x) const {
+    GET_HELPER(int32_t, type_tag_, value_, x);
+}
+
+uint32_t Variant::uint32() const {
+    return getHelper<uint32_t>(type_tag_, value_);
+}
+
+uint32_t Variant::uint32Or(uint32_t x) const {
+    GET_HELPER(uint32_t, type_tag_, value_, x);
+}
+
+int64_t Variant::int64() const {
+    return getHelper<int64_t>(type_tag_, value_);
+}
+
+int64_t Variant::int64Or(int64_t x) const {
+    GET_HELPER(int64_t, type_tag_, value_, x);
+}
+
+uint64_t Variant::uint64() const {
+    return getHelper<uint64_t>(type_tag_, value_);
+}
+
+uint64_t Variant::uint64Or(uint64_t x) const {
+    GET_HELPER(uint64_t, type_tag_, value_, x);
+}
+
+double Variant::floating() const {
+    return getHelper<double>(type_tag_, value_);
+}
+
+double Variant::floatingOr(double x) const {
+    GET_HELPER(double, type_tag_, value_, x);
+}
+
+std::string Variant::str() const {
+    return std::string(strView());
+}
+
+std::string_view Variant::strView() const {
+    if (type_tag_ == TypeTag::string) {
+        return Impl::string(*this);
+    }
+    return getHelper<std::string>(type_tag_, value_);
+}
+
+std::string Variant::strOr(std::string const& x) const {
+    if (type_tag_ == TypeTag::null) {
+        return x;
+    }
+    return std::string(strView());
+}
+
+Variant::Vec const& Variant::vec() const {
+    if (Impl::isPacked(type_tag_)) {
+        return Impl::unpacked(*this);
+    }
+    return getHelper<Vec>(type_tag_, value_);
+}
+
+Variant::Vec Variant::vecOr(Vec const& x) const {
+    if (type_tag_ == TypeTag::null) {
+        return x;
+    }
+    return vec();
+}
+
+Variant::Vec& Variant::modifyVec() {
+    if (Impl::isPacked(type_tag_)) {
+        *this = Variant(Vec(vec()));
+    } else if (type_tag_ == TypeTag::vec) {
+        Impl::detach<Vec>(*this);
+    }
+    return getHelper<Vec&>(type_tag_, value_);
+}
+
+template <class T>
+T const& Variant::Impl::pinned(Variant const& x) {
+    if (x.type_tag_ != packedTag<T>()) {
+        return getHelper<T>(x.type_tag_, x.value_);
+    }
+    auto& packed = packedPayload<T>(x);
+    if (!packed.acquire()) {
+        throw VariantBadType(boost::hana::type_c<T>, boost::hana::type_c<Vec>);
+    }
+    return packed.values;
+}
+
+Variant::Int64Vec const& Variant::int64Vec() const {
+    return Impl::pinned<Int64Vec>(*this);
+}
+
+Variant::Uint64Vec const& Variant::uint64Vec() const {
+    return Impl::pinned<Uint64Vec>(*this);
+}
+
+Variant::DoubleVec const& Variant::doubleVec() const {
+    return Impl::pinned<DoubleVec>(*this);
+}
+
+Variant::BoolVec const& Variant::boolVec() const {
+    return Impl::pinned<BoolVec>(*this);
+}
+
+template <typename T>
+std::vector<T> Variant::vecAs() const {
+    static_assert(std::is_arithmetic_v<T> && Types::anyOf<T>());
+    std::vector<T> ret;
+    std::size_t i = 0;
+    try {
+        auto const fill = [&](auto const& values) {
+            using U = typename std::decay_t<decltype(values)>::value_type;
+            if constexpr (std::is_same_v<T, U>) {
+                ret.assign(values.begin(), values.end());
+            } else {
+                ret.reserve(values.size());
+                for (; i < values.size(); ++i) {
+                    if constexpr (std::is_same_v<U, Variant>) {
+                        ret.push_back(getHelper<T>(values[i].type_tag_, values[i].value_));
+                    } else {
+                        ret.push_back(GetHelper<T>::apply(static_cast<U>(values[i])));
+                    }
+                }
+            }
+        };
+        if (Impl::isPacked(type_tag_)) {
+            Impl::readPacked(*this, fill);
+        } else {
+            fill(vec());
+        }
+    } catch (VariantErr& e) {
+        e.prependPath(std::to_string(i));
+        throw;
+    }
+    return ret;
+}
+
+template std::vector<bool> Variant::vecAs<bool>() const;
+template std::vector<char> Variant::vecAs<char>() const;
+template std::vector<int8_t> Variant::vecAs<int8_t>() const;
+template std::vector<uint8_t> Variant::vecAs<uint8_t>() const;
+template std::vector<int16_t> Variant::vecAs<int16_t>() const;
+template std::vector<uint16_t> Variant::vecAs<uint16_t>() const;
+template std::vector<int32_t> Variant::vecAs<int32_t>() const;
+template std::vector<uint32_t> Variant::vecAs<uint32_t>() const;
+template std::vector<int64_t> Variant::vecAs<int64_t>() const;
+template std::vector<uint64_t> Variant::vecAs<uint64_t>() const;
+template std::vector<double> Variant::vecAs<double>() const;
+
+Variant::Map const& Variant::map() const {
+    return getHelper<Map>(type_tag_, value_);
+}
+
+Variant::Map Variant::mapOr(Map const& x) const {
+    GET_HELPER(Map, type_tag_, value_, x);
+}
+
+Variant::Map& Variant::modifyMap() {
+    if (type_tag_ == TypeTag::map) {
+        Impl::detach<Map>(*this);
+    }
+    return getHelper<Map&>(type_tag_, value_);
+}
+
+FrozenVariant Variant::freeze() const {
+    return FrozenVariant(*this);
+}
+
+void Variant::materialize() {
+    Impl::materialize(*this);
+}
+
+#if defined(__GNUG__) || defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal" // safe comparation
+bool Variant::operator==(Variant const& rhs) const noexcept {
+    if (type_tag_ != rhs.type_tag_) {
+        return isVec() && rhs.isVec() && Impl::sameElements(*this, rhs);
+    } else {
+        switch (type_tag_) {
+        case TypeTag::null:
+            return true;
+        case TypeTag::boolean:
+            return value_.bool_ == rhs.value_.bool_;
+        case TypeTag::char_:
+            return value_.char_ == rhs.value_.char_;
+        case TypeTag::int8:
+            return value_.int8 == rhs.value_.int8;
+        case TypeTag::uint8:
+            return value_.uint8 == rhs.value_.uint8;
+        case TypeTag::int16:
+            return value_.int16 == rhs.value_.int16;
+        case TypeTag::uint16:
+            return value_.uint16 == rhs.value_.uint16;
+        case TypeTag::int32:
+            return value_.int32 == rhs.value_.int32;
+        case TypeTag::uint32:
+            return value_.uint32 == rhs.value_.uint32;
+        case TypeTag::int64:
+            return value_.int64 == rhs.value_.int64;
+        case TypeTag::uint64:
+            return value_.uint64 == rhs.value_.uint64;
+        case TypeTag::double_:
+            return value_.double_ == rhs.value_.double_;
+        case TypeTag::string:
+            return Impl::string(*this) == Impl::string(rhs);
+        case TypeTag::vec:
+            return value_.ptr == rhs.value_.ptr
+                || (Impl::mayEqual(*this, rhs)
+                    && payload<Vec>(value_.ptr) == payload<Vec>(rhs.value_.ptr));
+        case TypeTag::map:
+            return value_.ptr == rhs.value_.ptr
+                || (Impl::mayEqual(*this, rhs)
+                    && payload<Map>(value_.ptr) == payload<Map>(rhs.value_.ptr));
+        case TypeTag::int64_vec:
+        case TypeTag::uint64_vec:
+        case TypeTag::double_vec:
+        case TypeTag::bool_vec:
+            return value_.ptr == rhs.value_.ptr
+                || (Impl::mayEqual(*this, rhs) && Impl::sameElements(*this, rhs));
+        }
+        return false;
+    }
+}
+#pragma GCC diagnostic pop
+#else
+#error The compiler not supported
+#endif
+
+namespace {
+
+struct ArithmeticCheckedEqT {
+    template <typename Lhs, typename Rhs>
+    bool operator()(Lhs lhs, Rhs rhs) const noexcept;
+};
+
+constexpr ArithmeticCheckedEqT arithmeticCheckedEq;
+
+template <typename T, typename U, typename = void>
+struct ArithmeticCheckedEq final : ArithmeticCheckedEq<T, U, When<true>> {
+    static_assert(std::is_arithmetic_v<T> && std::is_arithmetic_v<U>);
+};
+
+template <typename T, typename U>
+struct ArithmeticCheckedEq<T, U, When<
+        !std::is_same_v<T, double> &&
+        !std::is_same_v<T, bool> &&
+        !std::is_same_v<U, double> &&
+        !std::is_same_v<U, bool> &&
+        same_sign_v<T, U> && sizeof(T) >= sizeof(U)>> {
+    static bool apply(T lhs, U rhs) noexcept {
+        return lhs == rhs;
+    }
+};
+
+template <typename T, typename U>
+struct ArithmeticCheckedEq<T, U, When<
+        !std::is_same_v<T, double> &&
+        !std::is_same_v<T, bool> &&
+        !std::is_same_v<U, double> &&
+        !std::is_same_v<U, bool> &&
+        same_sign_v<T, U> && sizeof(T) < sizeof(U)>> {
+    static bool apply(T lhs, U rhs) {
+        return lhs == rhs;
+    }
+};
+
+template <typename T, typename U>
+struct ArithmeticCheckedEq<T, U, When<
+        !std::is_same_v<T, double> &&
+        !std::is_same_v<T, bool> &&
+        !std::is_same_v<U, double> &&
+        !std::is_same_v<U, bool> &&
+        std::is_signed_v<T> && std::is_unsigned_v<U> && (sizeof(T) > sizeof(U))>> {
+    static bool apply(T lhs, U rhs) noexcept {
+        return lhs == rhs;
+    }
+};
+
+template <typename T, typename U>
+struct ArithmeticCheckedEq<T, U, When<
+        !std::is_same_v<T, double> &&
+        !std::is_same_v<T, bool> &&
+        !std::is_same_v<U, double> &&
+        !std::is_same_v<U, bool> &&
+        std::is_signed_v<T> && std::is_unsigned_v<U> && (sizeof(T) <= sizeof(U))>> {
+    static bool apply(T lhs, U rhs) {
+        if (lhs < 0) {
+            return false;
+        } else {
+            return static_cast<U>(lhs) == rhs;
+        }
+    }
+};
+
+template <typename T, typename U>
+struct ArithmeticCheckedEq<T, U, When<
+        !std::is_same_v<T, double> &&
+        !std::is_same_v<T, bool> &&
+        !std::is_same_v<U, double> &&
+        !std::is_same_v<U, bool> &&
+        std::is_unsigned_v<T> && std::is_signed_v<U> && sizeof(T) >= sizeof(U)>> {
+    static bool apply(T lhs, U rhs) {
+        return arithmeticCheckedEq(rhs, lhs);
+    }
+};
+
+template <typename T, typename U>
+struct ArithmeticCheckedEq<T, U, When<
+        !std::is_same_v<T, double> &&
+        !std::is_same_v<T, bool> &&
+        !std::is_same_v<U, double> &&
+        !std::is_same_v<U, bool> &&
+        std::is_unsigned_v<T> && std::is_signed_v<U> && sizeof(T) < sizeof(U)>> {
+    static bool apply(T lhs, U rhs) {
+        return lhs == rhs;
+    }
+};
+
+#if defined(__GNUG__) || defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wfloat-equal"
+template <typename T, typename U>
+struct ArithmeticCheckedEq<T, U, When<
+        std::is_same_v<T, double> &&
+        !std::is_same_v<U, bool>>> {
+    static bool apply(T lhs, U rhs) {
+        return lhs == rhs;
+    }
+};
+
+template <typename T, typename U>
+struct ArithmeticCheckedEq<T, U, When<
+        !std::is_same_v<T, double> &&
+        !std::is_same_v<T, bool> &&
+        std::is_same_v<U, double>>> {
+    static bool apply(T lhs, U rhs) {
+        return lhs == rhs;
+    }
+};
+#pragma GCC diagnostic pop
+#else
+#error The compiler not supported
+#endif
+
+template <typename T, typename U>
+struct ArithmeticCheckedEq<T, U, When<
+        std::is_same_v<T, bool> ^ std::is_same_v<U, bool>>> {
+    static bool apply(T, U) {
+        return false;
+    }
+};
+
+template <typename T, typename U>
+struct ArithmeticCheckedEq<T, U, When<
+        std::is_same_v<T, bool> &&
+        std::is_same_v<U, bool>>> {
+    static bool apply(T lhs, U rhs) {
+        return lhs == rhs;
+    }
+};
+
+template <typename Lhs, typename Rhs>
+bool ArithmeticCheckedEqT::operator()(Lhs lhs, Rhs rhs) const noexcept {
+    return ArithmeticCheckedEq<Lhs, Rhs>::apply(lhs, rhs);
+}
+
+template <class T, class U>
+bool equalArithmetic(T lhs, Variant::TypeTag tag, U const& rhs) {
+    using TypeTag = Variant::TypeTag;
+    static_assert(std::is_arithmetic_v<T>);
+    switch (tag) {
+    case TypeTag::null:
+        return false;
+    case TypeTag::boolean:
+        return arithmeticCheckedEq(lhs, rhs.bool_);
+    case TypeTag::char_:
+        return arithmeticCheckedEq(lhs, rhs.char_);
+    case TypeTag::int8:
+        return arithmeticCheckedEq(lhs, rhs.int8);
+    case TypeTag::uint8:
+        return arithmeticCheckedEq(lhs, rhs.uint8);
     case TypeTag::int16:
         return arithmeticCheckedEq(lhs, rhs.int16);
     case TypeTag::uint16:
@@ -863,8 +1867,11 @@ bool equalArithmetic(T lhs, Variant::TypeTag tag, U const& rhs) {
     case TypeTag::string:
         return false;
     case TypeTag::vec:
-        return false;
     case TypeTag::map:
+    case TypeTag::int64_vec:
+    case TypeTag::uint64_vec:
+    case TypeTag::double_vec:
+    case TypeTag::bool_vec:
         return false;
     }
     assert(false);
@@ -875,7 +1882,6 @@ bool equalArithmetic(T lhs, Variant::TypeTag tag, U const& rhs) {
 
 bool equal(Variant const& lhs, Variant const& rhs) {
     using TypeTag = Variant::TypeTag;
-    using Map = Variant::Map;
 
     switch (lhs.type_tag_) {
     case TypeTag::null:
@@ -896,67 +1902,240 @@ bool equal(Variant const& lhs, Variant const& rhs) {
     case TypeTag::int32:
         return equalArithmetic(lhs.value_.int32, rhs.type_tag_, rhs.value_);
     case TypeTag::uint32:
-        return equalArithmetic(lhs.value_.uint32, rhs.type_tag_, rhs.value_);
+        return equalArithmetic(lhs.value_.uint32, rhs.type_tag_, rhs.value_);
+    case TypeTag::int64:
+        return equalArithmetic(lhs.value_.int64, rhs.type_tag_, rhs.value_);
+    case TypeTag::uint64:
+        return equalArithmetic(lhs.value_.uint64, rhs.type_tag_, rhs.value_);
+    case TypeTag::double_:
+        return equalArithmetic(lhs.value_.double_, rhs.type_tag_, rhs.value_);
+
+    case TypeTag::string:
+        return lhs == rhs;
+    case TypeTag::vec:
+    case TypeTag::int64_vec:
+    case TypeTag::uint64_vec:
+    case TypeTag::double_vec:
+    case TypeTag::bool_vec: {
+        if (!rhs.isVec()) {
+            return false;
+        }
+        if (lhs.type_tag_ != TypeTag::vec || rhs.type_tag_ != TypeTag::vec) {
+            return Variant::Impl::equalVec(lhs, rhs);
+        }
+        auto const& lhs_vec = lhs.vec();
+        auto const& rhs_vec = rhs.vec();
+        return lhs_vec.size() == rhs_vec.size()
+            && std::equal(lhs_vec.begin(), lhs_vec.end(), rhs_vec.begin(), &equal);
+    }
+    case TypeTag::map: {
+        if (TypeTag::map != rhs.type()) {
+            return false;
+        }
+        return lhs.map().equal(rhs.map(), &equal);
+    }
+    }
+    return false;
+}
+
+bool Variant::Impl::sameElements(Variant const& lhs, Variant const& rhs) noexcept {
+    if (!isPacked(lhs.type_tag_)) {
+        return sameElements(rhs, lhs);
+    }
+    auto const n = size(lhs);
+    if (n != size(rhs) || !mayEqual(lhs, rhs)) {
+        return false;
+    }
+    auto const elements = [](Variant const& x, auto&& f) -> bool {
+        if (x.type_tag_ == TypeTag::vec) {
+            return f(payload<Vec>(x.value_.ptr), TypeTag::vec);
+        }
+        return readPacked(x, [&f, type = elementTag(x)](auto const& values) {
+            return f(values, type);
+        });
+    };
+    return elements(lhs, [&rhs, &elements, n](auto const& lhs_values, TypeTag lhs_type) {
+        return elements(rhs, [&lhs_values, lhs_type, n](auto const& values, TypeTag type) {
+            using T = std::decay_t<decltype(values)>;
+            if constexpr (std::is_same_v<T, std::decay_t<decltype(lhs_values)>>) {
+                if (type == lhs_type) {
+                    return values == lhs_values;
+                }
+            }
+            for (std::size_t i = 0; i < n; ++i) {
+                if (at(lhs_values, i, lhs_type) != at(values, i, type)) {
+                    return false;
+                }
+            }
+            return true;
+        });
+    });
+}
+
+bool Variant::Impl::equalVec(Variant const& lhs, Variant const& rhs) {
+    auto const n = size(lhs);
+    if (n != size(rhs)) {
+        return false;
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+        if (!equal(element(lhs, i), element(rhs, i))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+namespace {
+
+std::size_t hashValue(bool x) noexcept {
+    return x;
+}
+
+std::size_t hashValue(int64_t x) noexcept {
+    return static_cast<std::size_t>(x);
+}
+
+std::size_t hashValue(uint64_t x) noexcept {
+    return static_cast<std::size_t>(x);
+}
+
+std::size_t hashValue(double x) noexcept {
+    // 0.0 == -0.0
+    if (std::fpclassify(x) == FP_ZERO) {
+        return 0;
+    }
+    uint64_t bits;
+    std::memcpy(&bits, &x, sizeof(bits));
+    return static_cast<std::size_t>(bits);
+}
+
+} // namespace
+
+std::size_t Variant::Impl::hash(Variant const& x) noexcept {
+    auto const seed = mix(static_cast<uint64_t>(x.type_tag_));
+    switch (x.type_tag_) {
+    case TypeTag::null:
+        return seed;
+    case TypeTag::boolean:
+        return combine(seed, hashValue(x.value_.bool_));
+    case TypeTag::char_:
+        return combine(seed, hashValue(int64_t{x.value_.char_}));
+    case TypeTag::int8:
+        return combine(seed, hashValue(int64_t{x.value_.int8}));
+    case TypeTag::uint8:
+        return combine(seed, hashValue(uint64_t{x.value_.uint8}));
+    case TypeTag::int16:
+        return combine(seed, hashValue(int64_t{x.value_.int16}));
+    case TypeTag::uint16:
+        return combine(seed, hashValue(uint64_t{x.value_.uint16}));
+    case TypeTag::int32:
+        return combine(seed, hashValue(int64_t{x.value_.int32}));
+    case TypeTag::uint32:
+        return combine(seed, hashValue(uint64_t{x.value_.uint32}));
     case TypeTag::int64:
-        return equalArithmetic(lhs.value_.int64, rhs.type_tag_, rhs.value_);
+        return combine(seed, hashValue(x.value_.int64));
     case TypeTag::uint64:
-        return equalArithmetic(lhs.value_.uint64, rhs.type_tag_, rhs.value_);
+        return combine(seed, hashValue(x.value_.uint64));
     case TypeTag::double_:
-        return equalArithmetic(lhs.value_.double_, rhs.type_tag_, rhs.value_);
-
+        return combine(seed, hashValue(x.value_.double_));
     case TypeTag::string:
-        return lhs == rhs;
-    case TypeTag::vec: {
-        if (TypeTag::vec != rhs.type()) {
-            return false;
-        }
-        auto const& lhs_vec = lhs.vec();
-        auto const& rhs_vec = rhs.vec();
-        return lhs_vec.size() == rhs_vec.size()
-            && std::equal(lhs_vec.begin(), lhs_vec.end(), rhs_vec.begin(), &equal);
-    }
-    case TypeTag::map: {
-        if (TypeTag::map != rhs.type()) {
-            return false;
-        }
-        auto const& lhs_map = lhs.map();
-        auto const& rhs_map = rhs.map();
-        if (lhs_map.size() != rhs_map.size()) {
-            return false;
-        }
-        std::vector<Map::const_pointer> lhs(lhs_map.size());
-        std::vector<Map::const_pointer> rhs(rhs_map.size());
-        std::transform(lhs_map.begin(), lhs_map.end(), lhs.begin(), [](auto const& x) {
-            return std::addressof(x);
-        });
-        std::transform(rhs_map.begin(), rhs_map.end(), rhs.begin(), [](auto const& x) {
-            return std::addressof(x);
-        });
-        std::sort(lhs.begin(), lhs.end(), [](auto lhs, auto rhs) {
-            return lhs->first < rhs->first;
+        return combine(seed, std::hash<std::string_view>()(string(x)));
+    case TypeTag::vec:
+        return hashOnce<Vec>(x, [seed](Vec const& vec) {
+            auto ret = seed;
+            for (auto const& y : vec) {
+                ret = combine(ret, hash(y));
+            }
+            return ret;
         });
-        std::sort(rhs.begin(), rhs.end(), [](auto lhs, auto rhs) {
-            return lhs->first < rhs->first;
+    case TypeTag::map:
+        return hashOnce<Map>(x, [seed](Map const& map) {
+            // a sum does not depend on the order of the entries
+            std::size_t sum = 0;
+            for (auto const& [key, value] : map) {
+                sum += combine(key.hash(), hash(value));
+            }
+            return combine(combine(seed, map.size()), sum);
         });
-        return std::equal(lhs.begin(), lhs.end(), rhs.begin(), [](auto lhs, auto rhs) {
-            return lhs->first == rhs->first && equal(lhs->second, rhs->second);
+    case TypeTag::int64_vec:
+    case TypeTag::uint64_vec:
+    case TypeTag::double_vec:
+    case TypeTag::bool_vec:
+        return visitPacked(x, [&x](auto const& packed) {
+            using T = std::decay_t<decltype(packed)>;
+            return hashOnce<T>(x, [](T& packed) {
+                return readValues(packed, [&packed](auto const& values) {
+                    // equal to the hash of the `vec` of the same elements
+                    auto ret = mix(static_cast<uint64_t>(TypeTag::vec));
+                    for (std::size_t i = 0; i < values.size(); ++i) {
+                        ret = combine(ret, hash(at(values, i, packed.element)));
+                    }
+                    return ret;
+                });
+            });
         });
     }
-    }
-    return false;
+    assert(false);
+    return seed;
+}
+
+std::size_t Variant::hash() const noexcept {
+    return Impl::hash(*this);
 }
 
 bool Variant::operator!=(Variant const& rhs) const noexcept {
     return !this->operator==(rhs);
 }
 
-namespace {
+void Variant::Impl::pack(Variant& x, VariantArena* arena) {
+    auto const& vec = payload<Vec>(x.value_.ptr);
+    if (vec.empty()) {
+        return;
+    }
+    auto const type = vec.front().type_tag_;
+    for (auto const& y : vec) {
+        if (y.type_tag_ != type) {
+            return;
+        }
+    }
+    auto const n = vec.size();
+    switch (type) {
+    case TypeTag::boolean:
+        x = packed<BoolVec>(
+                n, [&vec](auto i) { return vec[i].value_.bool_; }, arena, type);
+        break;
+    case TypeTag::char_:
+    case TypeTag::int8:
+    case TypeTag::uint8:
+    case TypeTag::int16:
+    case TypeTag::uint16:
+    case TypeTag::int32:
+    case TypeTag::uint32:
+    case TypeTag::int64:
+        x = packed<Int64Vec>(n, [&vec](auto i) { return vec[i].int64(); }, arena, type);
+        break;
+    case TypeTag::uint64:
+        x = packed<Uint64Vec>(
+                n, [&vec](auto i) { return vec[i].value_.uint64; }, arena, type);
+        break;
+    case TypeTag::double_:
+        x = packed<DoubleVec>(
+                n, [&vec](auto i) { return vec[i].value_.double_; }, arena, type);
+        break;
+    default:
+        break;
+    }
+}
 
 using namespace rapidjson;
 
 /// RapidJSON visitor
 template <typename Encoding>
-struct FromJson : rapidjson::BaseReaderHandler<Encoding, FromJson<Encoding>> {
+struct Variant::Impl::FromJson : rapidjson::BaseReaderHandler<Encoding, FromJson<Encoding>> {
+    explicit FromJson(VariantArena* arena = nullptr)
+            : arena(arena) {
+    }
+
     template <class T>
     void val(T&& x) {
         switch (ptrs.back()->type()) {
@@ -967,106 +2146,868 @@ struct FromJson : rapidjson::BaseReaderHandler<Encoding, FromJson<Encoding>> {
             ptrs.back()->modifyVec().push_back(Variant(std::forward<T>(x)));
             break;
         default:
-            *ptrs.back() = Variant(std::forward<T>(x));
+            *ptrs.back() = Variant(std::forward<T>(x));
+        }
+    }
+
+    template <class T>
+    Variant* val2(T&& x) {
+        switch (ptrs.back()->type()) {
+        case Variant::TypeTag::map:
+            return &(ptrs.back()->modifyMap()[std::move(key)] = Variant(std::forward<T>(x)));
+        case Variant::TypeTag::vec:
+            ptrs.back()->modifyVec().push_back(Variant(std::forward<T>(x)));
+            return &ptrs.back()->modifyVec().back();
+        default:
+            return &(*ptrs.back() = Variant(std::forward<T>(x)));
+        }
+    }
+
+    template <class T>
+    Variant container() const {
+        return arena ? Impl::container<T>(*arena) : Variant(T());
+    }
+
+    bool Null() {
+        val(Variant::NullType());
+        return true;
+    }
+    bool Bool(bool b) {
+        val(b);
+        return true;
+    }
+    bool Int(int32_t i) {
+        val(i);
+        return true;
+    }
+    bool Uint(uint32_t u) {
+        val(u);
+        return true;
+    }
+    bool Int64(int64_t i64) {
+        val(i64);
+        return true;
+    }
+    bool Uint64(uint64_t u64) {
+        val(u64);
+        return true;
+    }
+    bool Double(double d) {
+        val(d);
+        return true;
+    }
+    bool String(typename Encoding::Ch const* str, SizeType length, bool) {
+        Variant x;
+        if (auto const borrowed = borrow(str, length)) {
+            initView(x, std::string_view(borrowed, length));
+        } else if (arena) {
+            initString(x, std::string_view(str, length), *arena);
+        } else {
+            initString(x, std::string_view(str, length));
+        }
+        val(std::move(x));
+        return true;
+    }
+    bool StartObject() {
+        ptrs.push_back(val2(container<Map>()));
+        return true;
+    }
+    bool Key(typename Encoding::Ch const* str, SizeType length, bool) {
+        assert(ptrs.back()->type() == Variant::TypeTag::map);
+        std::string_view const view(str, length);
+        auto it = keys.find(view);
+        if (it == keys.end()) {
+            it = keys.try_emplace(view).first;
+        }
+        key = it->first;
+        return true;
+    }
+    bool EndObject(SizeType n) {
+        assert(ptrs.back()->type() == Variant::TypeTag::map);
+        assert(ptrs.back()->map().size() == n);
+        (void)n;
+        ptrs.pop_back();
+        return true;
+    }
+    bool StartArray() {
+        ptrs.push_back(val2(container<Vec>()));
+        return true;
+    }
+    bool EndArray(SizeType n) {
+        assert(ptrs.back()->type() == Variant::TypeTag::vec);
+        assert(ptrs.back()->vec().size() == n);
+        if (n >= YENXO_PACKED_MIN_SIZE) {
+            pack(*ptrs.back(), arena);
+        }
+        ptrs.pop_back();
+        return true;
+    }
+
+    /// The just parsed string `str` in the `fromJsonView()` or `fromJsonInsitu()` buffer
+    /// or nullptr if it differs from the decoded one
+    char const* borrow(typename Encoding::Ch const* str, SizeType length) const noexcept {
+        if (length <= local_capacity) {
+            return nullptr;
+        }
+        if (insitu) {
+            return str;
+        }
+        if (!source) {
+            return nullptr;
+        }
+        // the reader stands right after the closing quote
+        auto const end = source + stream->Tell() - 1;
+        auto const begin = end - length;
+        // the raw string is longer than `length` if it contains escapes, then either the
+        // opening quote is not at `begin[-1]` or an escape is left in the range
+        if (begin[-1] != '"' || std::memchr(begin, '\\', length)) {
+            return nullptr;
+        }
+        return begin;
+    }
+
+    VariantArena* arena;
+    /// Buffer and stream of `fromJsonView()`
+    char const* source{nullptr};
+    MemoryStream const* stream{nullptr};
+    /// The strings are decoded in the `fromJsonInsitu()` buffer and stay there
+    bool insitu{false};
+    Variant var;
+    std::vector<Variant*> ptrs{&var};
+    Map::key_type key;
+    /// Keys seen by this parse, saves the pool lookup on repeated keys
+    StringMap<NullType> keys;
+};
+
+Variant Variant::from(Value const& json) {
+    Impl::FromJson<Value::EncodingType> ser;
+    json.Accept(ser);
+    assert(ser.ptrs.size() == 1);
+    return std::move(ser).var;
+}
+
+Variant Variant::from(Value const& json, VariantArena& arena) {
+    Impl::FromJson<Value::EncodingType> ser(&arena);
+    json.Accept(ser);
+    assert(ser.ptrs.size() == 1);
+    return std::move(ser).var;
+}
+
+namespace {
+
+/// `rapidjson::InsituStringStream` over a buffer of known size, no terminating NUL needed
+///
+/// The decoded strings are written over the source, each followed by a NUL which takes
+/// at most the place of the closing quote.
+class InsituStream {
+public:
+    using Ch = char;
+
+    InsituStream(Ch* buf, std::size_t len) noexcept
+            : src_(buf)
+            , end_(buf + len)
+            , head_(buf) {
+    }
+
+    Ch Peek() const noexcept {
+        return src_ == end_ ? '\0' : *src_;
+    }
+    Ch Take() noexcept {
+        return src_ == end_ ? '\0' : *src_++;
+    }
+    std::size_t Tell() const noexcept {
+        return static_cast<std::size_t>(src_ - head_);
+    }
+
+    Ch* PutBegin() noexcept {
+        return dst_ = src_;
+    }
+    void Put(Ch c) noexcept {
+        *dst_++ = c;
+    }
+    void Flush() noexcept {
+    }
+    std::size_t PutEnd(Ch* begin) noexcept {
+        return static_cast<std::size_t>(dst_ - begin);
+    }
+
+private:
+    Ch* src_;
+    Ch* end_;
+    Ch* head_;
+    Ch* dst_{nullptr};
+};
+
+template <unsigned Flags = kParseDefaultFlags, class Stream, class Handler>
+void parseJson(Stream& stream, Handler& handler) {
+    rapidjson::Reader reader;
+    reader.Parse<Flags>(stream, handler);
+    if (reader.HasParseError()) {
+        throw std::runtime_error(rapidjson::GetParseError_En(reader.GetParseErrorCode()));
+    }
+}
+
+/// Parse `file` reporting the position of an error as `path:line:column`
+template <class Handler>
+void parseJsonFile(MappedFile const& file, Handler& handler) {
+    rapidjson::Reader reader;
+    rapidjson::MemoryStream ms(file.data(), file.size());
+    reader.Parse(ms, handler);
+    if (!reader.HasParseError()) {
+        return;
+    }
+
+    auto const offset = std::min(reader.GetErrorOffset(), file.size());
+    auto const text = file.view().substr(0, offset);
+    auto const line = std::count(text.begin(), text.end(), '\n') + 1;
+    auto const line_start = text.rfind('\n');
+    auto const column = offset - (line_start == text.npos ? 0 : line_start + 1) + 1;
+    throw std::runtime_error(file.path() + ":" + std::to_string(line) + ":"
+                             + std::to_string(column) + ": "
+                             + rapidjson::GetParseError_En(reader.GetParseErrorCode())
+                             + " (offset " + std::to_string(offset) + ")");
+}
+
+} // namespace
+
+Variant Variant::fromJson(std::string const& json) {
+    return fromJson(json.c_str());
+}
+
+Variant Variant::fromJson(std::string const& json, VariantArena& arena) {
+    return fromJson(json.c_str(), arena);
+}
+
+Variant Variant::fromJson(std::string&& json) {
+    Impl::FromJson<rapidjson::UTF8<>> handler;
+    rapidjson::InsituStringStream ss(json.data());
+    parseJson<kParseInsituFlag>(ss, handler);
+    return std::move(handler).var;
+}
+
+Variant Variant::fromJson(std::string&& json, VariantArena& arena) {
+    Impl::FromJson<rapidjson::UTF8<>> handler(&arena);
+    rapidjson::InsituStringStream ss(json.data());
+    parseJson<kParseInsituFlag>(ss, handler);
+    return std::move(handler).var;
+}
+
+Variant Variant::fromJson(std::string_view json) {
+    Impl::FromJson<rapidjson::UTF8<>> handler;
+    rapidjson::MemoryStream ms(json.data(), json.size());
+    parseJson(ms, handler);
+    return std::move(handler).var;
+}
+
+Variant Variant::fromJson(std::string_view json, VariantArena& arena) {
+    Impl::FromJson<rapidjson::UTF8<>> handler(&arena);
+    rapidjson::MemoryStream ms(json.data(), json.size());
+    parseJson(ms, handler);
+    return std::move(handler).var;
+}
+
+Variant Variant::fromJson(char const* json) {
+    Impl::FromJson<rapidjson::UTF8<>> handler;
+    rapidjson::StringStream ss(json);
+    parseJson(ss, handler);
+    return std::move(handler).var;
+}
+
+Variant Variant::fromJson(char const* json, VariantArena& arena) {
+    Impl::FromJson<rapidjson::UTF8<>> handler(&arena);
+    rapidjson::StringStream ss(json);
+    parseJson(ss, handler);
+    return std::move(handler).var;
+}
+
+Variant Variant::fromJsonInsitu(char* buf, std::size_t len) {
+    Impl::FromJson<rapidjson::UTF8<>> handler;
+    handler.insitu = true;
+    InsituStream ss(buf, len);
+    parseJson<kParseInsituFlag>(ss, handler);
+    return std::move(handler).var;
+}
+
+Variant Variant::fromJsonInsitu(char* buf, std::size_t len, VariantArena& arena) {
+    Impl::FromJson<rapidjson::UTF8<>> handler(&arena);
+    handler.insitu = true;
+    InsituStream ss(buf, len);
+    parseJson<kParseInsituFlag>(ss, handler);
+    return std::move(handler).var;
+}
+
+Variant Variant::fromJsonFile(std::string const& path) {
+    Impl::FromJson<rapidjson::UTF8<>> handler;
+    parseJsonFile(MappedFile(path), handler);
+    return std::move(handler).var;
+}
+
+Variant Variant::fromJsonFile(std::string const& path, VariantArena& arena) {
+    Impl::FromJson<rapidjson::UTF8<>> handler(&arena);
+    parseJsonFile(MappedFile(path), handler);
+    return std::move(handler).var;
+}
+
+Variant Variant::fromJsonView(std::string_view json) {
+    Impl::FromJson<rapidjson::UTF8<>> handler;
+    rapidjson::MemoryStream ms(json.data(), json.size());
+    handler.source = json.data();
+    handler.stream = &ms;
+    parseJson(ms, handler);
+    return std::move(handler).var;
+}
+
+Variant Variant::fromJsonView(std::string_view json, VariantArena& arena) {
+    Impl::FromJson<rapidjson::UTF8<>> handler(&arena);
+    rapidjson::MemoryStream ms(json.data(), json.size());
+    handler.source = json.data();
+    handler.stream = &ms;
+    parseJson(ms, handler);
+    return std::move(handler).var;
+}
+
+struct VariantParser::State {
+    using Handler = Variant::Impl::FromJson<UTF8<>>;
+
+    /// What the next structural character may be
+    enum class Expect : uint8_t {
+        value,
+        value_or_end, ///< after `[`
+        key_or_end,   ///< after `{`
+        key,
+        colon,
+        comma_or_end,
+        nothing ///< after the root value
+    };
+
+    enum class Token : uint8_t { none, string, number, literal };
+
+    /// Position in the grammar of a number
+    enum class Number : uint8_t {
+        start,
+        sign,
+        zero,
+        integer,
+        point,
+        fraction,
+        e,
+        exponent_sign,
+        exponent
+    };
+
+    struct Level {
+        bool object;
+        SizeType size;
+    };
+
+    /// Passes the number parsed by `rapidjson::Reader` to the tree handler
+    struct Numbers : BaseReaderHandler<UTF8<>, Numbers> {
+        bool Int(int x) { return handler.Int(x); }
+        bool Uint(unsigned x) { return handler.Uint(x); }
+        bool Int64(int64_t x) { return handler.Int64(x); }
+        bool Uint64(uint64_t x) { return handler.Uint64(x); }
+        bool Double(double x) { return handler.Double(x); }
+
+        Handler& handler;
+    };
+
+    explicit State(VariantArena* arena)
+            : arena(arena)
+            , handler(arena) {
+    }
+
+    void feed(std::string_view chunk) {
+        std::size_t i = 0;
+        while (i < chunk.size()) {
+            switch (token) {
+            case Token::string:
+                i = string(chunk, i);
+                continue;
+            case Token::number:
+                i = number(chunk, i);
+                continue;
+            case Token::literal:
+                i = literal(chunk, i);
+                continue;
+            case Token::none:
+                break;
+            }
+            auto const c = chunk[i];
+            if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+                ++i;
+            } else {
+                i = structural(c, i);
+            }
+        }
+        offset += chunk.size();
+    }
+
+    Variant finish() {
+        switch (token) {
+        case Token::string:
+            fail(kParseErrorStringMissQuotationMark, 0);
+        case Token::number:
+            endNumber(0);
+            break;
+        case Token::literal:
+            fail(kParseErrorValueInvalid, 0);
+        case Token::none:
+            break;
+        }
+        if (expect == Expect::value && levels.empty()) {
+            fail(kParseErrorDocumentEmpty, 0);
+        }
+        if (expect != Expect::nothing) {
+            fail(expected(), 0);
+        }
+        return std::move(handler.var);
+    }
+
+    /// \param i position in the current chunk
+    [[noreturn]] void fail(ParseErrorCode code, std::size_t i) const {
+        throw std::runtime_error("offset " + std::to_string(offset + i) + ": "
+                                 + GetParseError_En(code));
+    }
+
+    /// The error of an unexpected character
+    ParseErrorCode expected() const noexcept {
+        switch (expect) {
+        case Expect::value:
+        case Expect::value_or_end:
+            return kParseErrorValueInvalid;
+        case Expect::key_or_end:
+        case Expect::key:
+            return kParseErrorObjectMissName;
+        case Expect::colon:
+            return kParseErrorObjectMissColon;
+        case Expect::comma_or_end:
+            return levels.back().object ? kParseErrorObjectMissCommaOrCurlyBracket
+                                        : kParseErrorArrayMissCommaOrSquareBracket;
+        case Expect::nothing:
+            break;
+        }
+        return kParseErrorDocumentRootNotSingular;
+    }
+
+    void startToken(Token x) {
+        token = x;
+        text.clear();
+    }
+
+    /// Handle the character `c` outside of a token
+    /// \return position of the next character
+    std::size_t structural(char c, std::size_t i) {
+        switch (expect) {
+        case Expect::value_or_end:
+            if (c == ']') {
+                endContainer();
+                return i + 1;
+            }
+            [[fallthrough]];
+        case Expect::value:
+            return startValue(c, i);
+        case Expect::key_or_end:
+            if (c == '}') {
+                endContainer();
+                return i + 1;
+            }
+            [[fallthrough]];
+        case Expect::key:
+            if (c != '"') {
+                break;
+            }
+            startToken(Token::string);
+            key = true;
+            return i + 1;
+        case Expect::colon:
+            if (c != ':') {
+                break;
+            }
+            expect = Expect::value;
+            return i + 1;
+        case Expect::comma_or_end: {
+            auto const object = levels.back().object;
+            if (c == ',') {
+                expect = object ? Expect::key : Expect::value;
+                return i + 1;
+            }
+            if (c == (object ? '}' : ']')) {
+                endContainer();
+                return i + 1;
+            }
+            break;
+        }
+        case Expect::nothing:
+            break;
+        }
+        fail(expected(), i);
+    }
+
+    std::size_t startValue(char c, std::size_t i) {
+        switch (c) {
+        case '{':
+            handler.StartObject();
+            levels.push_back({true, 0});
+            expect = Expect::key_or_end;
+            return i + 1;
+        case '[':
+            handler.StartArray();
+            levels.push_back({false, 0});
+            expect = Expect::value_or_end;
+            return i + 1;
+        case '"':
+            startToken(Token::string);
+            key = false;
+            return i + 1;
+        case 't':
+            word = "true";
+            break;
+        case 'f':
+            word = "false";
+            break;
+        case 'n':
+            word = "null";
+            break;
+        default:
+            if (c != '-' && (c < '0' || c > '9')) {
+                fail(kParseErrorValueInvalid, i);
+            }
+            startToken(Token::number);
+            num = Number::start;
+            return i;
         }
+        startToken(Token::literal);
+        matched = 0;
+        return i;
     }
 
-    template <class T>
-    Variant* val2(T&& x) {
-        switch (ptrs.back()->type()) {
-        case Variant::TypeTag::map:
-            return &(ptrs.back()->modifyMap()[std::move(key)] = Variant(std::forward<T>(x)));
-        case Variant::TypeTag::vec:
-            ptrs.back()->modifyVec().push_back(Variant(std::forward<T>(x)));
-            return &ptrs.back()->modifyVec().back();
-        default:
-            return &(*ptrs.back() = Variant(std::forward<T>(x)));
+    void endValue() noexcept {
+        if (levels.empty()) {
+            expect = Expect::nothing;
+        } else {
+            ++levels.back().size;
+            expect = Expect::comma_or_end;
         }
     }
 
-    bool Null() {
-        val(Variant::NullType());
-        return true;
-    }
-    bool Bool(bool b) {
-        val(b);
-        return true;
-    }
-    bool Int(int32_t i) {
-        val(i);
-        return true;
-    }
-    bool Uint(uint32_t u) {
-        val(u);
-        return true;
-    }
-    bool Int64(int64_t i64) {
-        val(i64);
-        return true;
-    }
-    bool Uint64(uint64_t u64) {
-        val(u64);
-        return true;
-    }
-    bool Double(double d) {
-        val(d);
-        return true;
+    void endContainer() {
+        auto const level = levels.back();
+        levels.pop_back();
+        if (level.object) {
+            handler.EndObject(level.size);
+        } else {
+            handler.EndArray(level.size);
+        }
+        endValue();
+    }
+
+    std::size_t string(std::string_view chunk, std::size_t i) {
+        auto const begin = i;
+        for (; i < chunk.size(); ++i) {
+            auto const c = chunk[i];
+            if (escape) {
+                escape = false;
+            } else if (c == '\\') {
+                escape = true;
+            } else if (c == '"') {
+                text.append(chunk.data() + begin, i - begin);
+                endString(i);
+                return i + 1;
+            } else if (static_cast<unsigned char>(c) < 0x20) {
+                fail(c == '\0' ? kParseErrorStringMissQuotationMark
+                               : kParseErrorStringInvalidEncoding,
+                     i);
+            }
+        }
+        text.append(chunk.data() + begin, chunk.size() - begin);
+        return i;
     }
-    bool String(typename Encoding::Ch const* str, SizeType length, bool) {
-        val(std::string(str, length));
-        return true;
+
+    void endString(std::size_t i) {
+        token = Token::none;
+        std::string_view str = text;
+        if (text.find('\\') != std::string::npos) {
+            unescape(i);
+            str = decoded;
+        }
+        auto const size = static_cast<SizeType>(str.size());
+        if (key) {
+            handler.Key(str.data(), size, true);
+            expect = Expect::colon;
+        } else {
+            handler.String(str.data(), size, true);
+            endValue();
+        }
     }
-    bool StartObject() {
-        ptrs.push_back(val2(Variant::Map()));
-        return true;
+
+    /// Decode the escapes of the string `text` into `decoded`
+    void unescape(std::size_t i) {
+        decoded.clear();
+        for (std::size_t j = 0; j < text.size(); ++j) {
+            if (text[j] != '\\') {
+                decoded += text[j];
+                continue;
+            }
+            // a string never ends with the backslash, it would escape the quote
+            switch (text[++j]) {
+            case '"':
+            case '\\':
+            case '/':
+                decoded += text[j];
+                break;
+            case 'b':
+                decoded += '\b';
+                break;
+            case 'f':
+                decoded += '\f';
+                break;
+            case 'n':
+                decoded += '\n';
+                break;
+            case 'r':
+                decoded += '\r';
+                break;
+            case 't':
+                decoded += '\t';
+                break;
+            case 'u': {
+                auto code = hex(j + 1, i);
+                j += 4;
+                if (code >= 0xDC00 && code <= 0xDFFF) {
+                    fail(kParseErrorStringUnicodeSurrogateInvalid, i);
+                }
+                if (code >= 0xD800 && code <= 0xDBFF) {
+                    if (j + 2 >= text.size() || text[j + 1] != '\\'
+                        || text[j + 2] != 'u') {
+                        fail(kParseErrorStringUnicodeSurrogateInvalid, i);
+                    }
+                    auto const low = hex(j + 3, i);
+                    if (low < 0xDC00 || low > 0xDFFF) {
+                        fail(kParseErrorStringUnicodeSurrogateInvalid, i);
+                    }
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                    j += 6;
+                }
+                appendUtf8(code);
+                break;
+            }
+            default:
+                fail(kParseErrorStringEscapeInvalid, i);
+            }
+        }
     }
-    bool Key(typename Encoding::Ch const* str, SizeType length, bool) {
-        assert(ptrs.back()->type() == Variant::TypeTag::map);
-        key = std::string(str, length);
-        return true;
+
+    /// The 4 hex digits of `text` at `j`
+    unsigned hex(std::size_t j, std::size_t i) const {
+        if (j + 4 > text.size()) {
+            fail(kParseErrorStringUnicodeEscapeInvalidHex, i);
+        }
+        unsigned ret = 0;
+        for (auto const c : std::string_view(text).substr(j, 4)) {
+            auto const lower = static_cast<char>(c | 0x20);
+            ret <<= 4;
+            if (c >= '0' && c <= '9') {
+                ret |= static_cast<unsigned>(c - '0');
+            } else if (lower >= 'a' && lower <= 'f') {
+                ret |= static_cast<unsigned>(lower - 'a' + 10);
+            } else {
+                fail(kParseErrorStringUnicodeEscapeInvalidHex, i);
+            }
+        }
+        return ret;
     }
-    bool EndObject(SizeType n) {
-        assert(ptrs.back()->type() == Variant::TypeTag::map);
-        assert(ptrs.back()->map().size() == n);
-        (void)n;
-        ptrs.pop_back();
-        return true;
+
+    void appendUtf8(unsigned code) {
+        if (code < 0x80) {
+            decoded += static_cast<char>(code);
+        } else if (code < 0x800) {
+            decoded += static_cast<char>(0xC0 | (code >> 6));
+            decoded += static_cast<char>(0x80 | (code & 0x3F));
+        } else if (code < 0x10000) {
+            decoded += static_cast<char>(0xE0 | (code >> 12));
+            decoded += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            decoded += static_cast<char>(0x80 | (code & 0x3F));
+        } else {
+            decoded += static_cast<char>(0xF0 | (code >> 18));
+            decoded += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+            decoded += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+            decoded += static_cast<char>(0x80 | (code & 0x3F));
+        }
     }
-    bool StartArray() {
-        ptrs.push_back(val2(Variant::Vec()));
-        return true;
+
+    std::size_t literal(std::string_view chunk, std::size_t i) {
+        for (; i < chunk.size() && matched < word.size(); ++i, ++matched) {
+            if (chunk[i] != word[matched]) {
+                fail(kParseErrorValueInvalid, i);
+            }
+        }
+        if (matched == word.size()) {
+            token = Token::none;
+            if (word[0] == 'n') {
+                handler.Null();
+            } else {
+                handler.Bool(word[0] == 't');
+            }
+            endValue();
+        }
+        return i;
     }
-    bool EndArray(SizeType n) {
-        assert(ptrs.back()->type() == Variant::TypeTag::vec);
-        assert(ptrs.back()->vec().size() == n);
-        (void)n;
-        ptrs.pop_back();
-        return true;
+
+    std::size_t number(std::string_view chunk, std::size_t i) {
+        auto const begin = i;
+        for (; i < chunk.size(); ++i) {
+            if (!advance(chunk[i])) {
+                text.append(chunk.data() + begin, i - begin);
+                endNumber(i);
+                return i;
+            }
+        }
+        text.append(chunk.data() + begin, chunk.size() - begin);
+        return i;
+    }
+
+    /// Move `num` past `c`
+    /// \return false if `c` does not continue the number
+    bool advance(char c) noexcept {
+        auto const digit = c >= '0' && c <= '9';
+        switch (num) {
+        case Number::start:
+            if (c == '-') {
+                num = Number::sign;
+                return true;
+            }
+            [[fallthrough]];
+        case Number::sign:
+            if (!digit) {
+                return false;
+            }
+            num = c == '0' ? Number::zero : Number::integer;
+            return true;
+        case Number::integer:
+            if (digit) {
+                return true;
+            }
+            [[fallthrough]];
+        case Number::zero:
+            if (c == '.') {
+                num = Number::point;
+                return true;
+            }
+            break;
+        case Number::point:
+            if (!digit) {
+                return false;
+            }
+            num = Number::fraction;
+            return true;
+        case Number::fraction:
+            if (digit) {
+                return true;
+            }
+            break;
+        case Number::e:
+            if (c == '+' || c == '-') {
+                num = Number::exponent_sign;
+                return true;
+            }
+            [[fallthrough]];
+        case Number::exponent_sign:
+        case Number::exponent:
+            if (!digit) {
+                return false;
+            }
+            num = Number::exponent;
+            return true;
+        }
+        if (c == 'e' || c == 'E') {
+            num = Number::e;
+            return true;
+        }
+        return false;
     }
 
-    Variant var;
-    std::vector<Variant*> ptrs{&var};
-    std::string key;
+    /// Check the grammar of the number token and pass it to the handler
+    void endNumber(std::size_t i) {
+        token = Token::none;
+        switch (num) {
+        case Number::start:
+        case Number::sign:
+            fail(kParseErrorValueInvalid, i);
+        case Number::point:
+            fail(kParseErrorNumberMissFraction, i);
+        case Number::e:
+        case Number::exponent_sign:
+            fail(kParseErrorNumberMissExponent, i);
+        default:
+            break;
+        }
+
+        // `rapidjson::Reader` converts the complete token, so the types and the rounding
+        // are those of `Variant::fromJson()`
+        StringStream is(text.c_str());
+        Numbers numbers{{}, handler};
+        if (!reader.Parse(is, numbers)) {
+            fail(reader.GetParseErrorCode(), i);
+        }
+        endValue();
+    }
+
+    VariantArena* arena;
+    Handler handler;
+    Reader reader;
+    std::vector<Level> levels;
+    Expect expect{Expect::value};
+    Token token{Token::none};
+    /// The string token is a key
+    bool key{false};
+    /// The last character of the string token is an unescaped backslash
+    bool escape{false};
+    Number num{Number::start};
+    /// The literal token and the number of its characters seen
+    std::string_view word;
+    std::size_t matched{0};
+    /// The characters of the string or number token seen
+    std::string text;
+    std::string decoded;
+    std::size_t offset{0};
 };
 
-} // namespace
+VariantParser::VariantParser()
+        : state_(std::make_unique<State>(nullptr)) {
+}
 
-Variant Variant::from(Value const& json) {
-    FromJson<Value::EncodingType> ser;
-    json.Accept(ser);
-    assert(ser.ptrs.size() == 1);
-    return std::move(ser).var;
+VariantParser::VariantParser(VariantArena& arena)
+        : state_(std::make_unique<State>(&arena)) {
 }
 
-Variant Variant::fromJson(std::string const& json) {
-    FromJson<rapidjson::UTF8<>> handler;
-    rapidjson::Reader reader;
-    rapidjson::StringStream ss(json.c_str());
-    reader.Parse(ss, handler);
-    if (reader.HasParseError()) {
-        throw std::runtime_error(rapidjson::GetParseError_En(reader.GetParseErrorCode()));
+VariantParser::~VariantParser() = default;
+
+VariantParser::VariantParser(VariantParser&&) noexcept = default;
+VariantParser& VariantParser::operator=(VariantParser&&) noexcept = default;
+
+void VariantParser::feed(std::string_view chunk) {
+    try {
+        state_->feed(chunk);
+    } catch (...) {
+        state_ = std::make_unique<State>(state_->arena);
+        throw;
     }
-    return std::move(handler).var;
+}
+
+Variant VariantParser::finish() {
+    auto const arena = state_->arena;
+    try {
+        auto ret = state_->finish();
+        state_ = std::make_unique<State>(arena);
+        return ret;
+    } catch (...) {
+        state_ = std::make_unique<State>(arena);
+        throw;
+    }
+}
+
+std::size_t VariantParser::offset() const noexcept {
+    return state_->offset;
 }
 
 struct Variant::Impl::ToJson {
@@ -1084,7 +3025,6 @@ struct Variant::Impl::ToJson {
 
     template <class Handler>
     static void apply(Handler& dst, Variant const& var) {
-        Document d;
         switch (var.type_tag_) {
         case TypeTag::null:
             dst.Null();
@@ -1123,13 +3063,13 @@ struct Variant::Impl::ToJson {
             dst.Double(var.value_.double_);
             break;
         case TypeTag::string: {
-            auto const str = reinterpret_cast<std::string*>(var.value_.ptr);
-            dst.String(str->c_str(), static_cast<unsigned int>(str->size()), true);
+            auto const str = Impl::string(var);
+            dst.String(str.data(), static_cast<unsigned int>(str.size()), true);
             break;
         }
         case TypeTag::vec: {
             dst.StartArray();
-            auto const vec = reinterpret_cast<Variant::Vec*>(var.value_.ptr);
+            auto const vec = &payload<Variant::Vec>(var.value_.ptr);
             for (auto const& var : *vec) {
                 apply(dst, var);
             }
@@ -1138,7 +3078,7 @@ struct Variant::Impl::ToJson {
         }
         case TypeTag::map: {
             dst.StartObject();
-            auto const map = reinterpret_cast<Variant::Map*>(var.value_.ptr);
+            auto const map = &payload<Variant::Map>(var.value_.ptr);
             for (auto const& [key, var] : *map) {
                 dst.Key(key.c_str(), static_cast<unsigned int>(key.size()), true);
                 apply(dst, var);
@@ -1146,8 +3086,37 @@ struct Variant::Impl::ToJson {
             dst.EndObject(static_cast<unsigned int>(map->size()));
             break;
         }
+        case TypeTag::int64_vec:
+            array(dst, var, [&dst](int64_t x) { dst.Int64(x); });
+            break;
+        case TypeTag::uint64_vec:
+            array(dst, var, [&dst](uint64_t x) { dst.Uint64(x); });
+            break;
+        case TypeTag::double_vec:
+            array(dst, var, [&dst](double x) { dst.Double(x); });
+            break;
+        case TypeTag::bool_vec:
+            array(dst, var, [&dst](bool x) { dst.Bool(x); });
+            break;
         }
     }
+
+    template <class Handler, class F>
+    static void array(Handler& dst, Variant const& var, F f) {
+        readPacked(var, [&dst, &f](auto const& values) {
+            dst.StartArray();
+            if constexpr (std::is_same_v<std::decay_t<decltype(values)>, Vec>) {
+                for (auto const& x : values) {
+                    apply(dst, x);
+                }
+            } else {
+                for (auto const x : values) {
+                    f(x);
+                }
+            }
+            dst.EndArray(static_cast<unsigned int>(values.size()));
+        });
+    }
 };
 
 rapidjson::Document& Variant::to(rapidjson::Document& json) const {
@@ -1156,84 +3125,111 @@ rapidjson::Document& Variant::to(rapidjson::Document& json) const {
     return json;
 }
 
-std::string Variant::toJson() const {
-    rapidjson::StringBuffer sb;
-    rapidjson::Writer<rapidjson::StringBuffer> writer(sb);
-    Impl::ToJson (*this)(writer);
-    return sb.GetString();
-}
+namespace {
 
-std::string Variant::toPrettyJson() const {
-    rapidjson::StringBuffer sb;
-    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(sb);
-    Impl::ToJson (*this)(writer);
-    return sb.GetString();
-}
+/// RapidJSON output stream appending to a `std::string`
+class StringOutput {
+public:
+    using Ch = char;
 
-std::ostream& operator<<(std::ostream& os, Variant const& var) {
-    using TypeTag = Variant::TypeTag;
-    switch (var.type_tag_) {
-    case TypeTag::null:
-        os << "Null";
-        break;
-    case TypeTag::boolean:
-        os  << var.value_.bool_;
-        break;
-    case TypeTag::char_:
-        os << var.value_.char_;
-        break;
-    case TypeTag::int8:
-        os << var.value_.int8;
-        break;
-    case TypeTag::uint8:
-        os << var.value_.uint8;
-        break;
-    case TypeTag::int16:
-        os << var.value_.int16;
-        break;
-    case TypeTag::uint16:
-        os << var.value_.uint16;
-        break;
-    case TypeTag::int32:
-        os << var.value_.int32;
-        break;
-    case TypeTag::uint32:
-        os << var.value_.uint32;
-        break;
-    case TypeTag::int64:
-        os << var.value_.int64;
-        break;
-    case TypeTag::uint64:
-        os << var.value_.uint64;
-        break;
-    case TypeTag::double_:
-        os << var.value_.double_;
-        break;
-    case TypeTag::string:
-        os << *reinterpret_cast<std::string*>(var.value_.ptr);
-        break;
-    case TypeTag::vec: {
-        auto const vec = reinterpret_cast<Variant::Vec*>(var.value_.ptr);
-        auto const l = vec->size() - 1;
-        std::size_t i = 0;
-        os << "[ ";
-        for (auto const& x : *vec) {
-            os << x << ((i++ == l) ? " " : ", ");
-        }
-        os << "]";
-        break;
+    explicit StringOutput(std::string& str) noexcept
+            : str_(str) {
     }
-    case TypeTag::map: {
-        auto const map = reinterpret_cast<Variant::Map*>(var.value_.ptr);
-        os << "{ ";
-        for (auto const& [key, x] : *map) {
-            os << key << ": " << x << "; ";
+
+    void Put(char c) {
+        str_.push_back(c);
+    }
+
+    void Flush() noexcept {
+    }
+
+private:
+    std::string& str_;
+};
+
+/// RapidJSON output stream passing the text to a `JsonSink` through a staging buffer
+///
+/// The writer flushes the stream once the root value is written.
+class SinkOutput {
+public:
+    using Ch = char;
+
+    explicit SinkOutput(JsonSink& sink) noexcept
+            : sink_(sink) {
+    }
+
+    void Put(char c) {
+        if (size_ == sizeof(buffer_)) {
+            Flush();
         }
-        os << "}";
-        break;
+        buffer_[size_++] = c;
     }
+
+    void Flush() {
+        if (size_ != 0) {
+            sink_.write(std::string_view(buffer_, size_));
+            size_ = 0;
+        }
     }
-    return os;
+
+private:
+    JsonSink& sink_;
+    std::size_t size_{0};
+    char buffer_[4096];
+};
+
+/// Allocator of the nesting levels of a writer
+using WriterStackAllocator = rapidjson::MemoryPoolAllocator<rapidjson::CrtAllocator>;
+
+template <class Output>
+using JsonWriter = rapidjson::Writer<Output, UTF8<>, UTF8<>, WriterStackAllocator>;
+
+template <class Output>
+using PrettyJsonWriter =
+        rapidjson::PrettyWriter<Output, UTF8<>, UTF8<>, WriterStackAllocator>;
+
+} // namespace
+
+template <template <class> class Writer, class Output>
+void Variant::Impl::writeJson(Variant const& var, Output& out) {
+    // room for the nesting levels of a deep document, the writer allocates none
+    alignas(std::max_align_t) char levels[2048];
+    WriterStackAllocator allocator(levels, sizeof(levels));
+    Writer<Output> writer(out, &allocator);
+    ToJson{var}(writer);
+}
+
+std::string Variant::toJson() const {
+    std::string ret;
+    appendJson(ret);
+    return ret;
+}
+
+std::string Variant::toPrettyJson() const {
+    std::string ret;
+    StringOutput out(ret);
+    Impl::writeJson<PrettyJsonWriter>(*this, out);
+    return ret;
+}
+
+void Variant::toJson(std::string& out) const {
+    out.clear();
+    appendJson(out);
+}
+
+void Variant::appendJson(std::string& out) const {
+    StringOutput stream(out);
+    Impl::writeJson<JsonWriter>(*this, stream);
+}
+
+void Variant::toJson(JsonSink& sink) const {
+    SinkOutput out(sink);
+    Impl::writeJson<JsonWriter>(*this, out);
+}
+
+void Variant::toPrettyJson(JsonSink& sink) const {
+    SinkOutput out(sink);
+    Impl::writeJson<PrettyJsonWriter>(*this, out);
 }
 
 #if defined(__GNUG__) || defined(__clang__)
@@ -1268,11 +3264,25 @@ std::type_info const& Variant::typeInfo() const noexcept {
     case TypeTag::string:
         return typeid(std::string);
     case TypeTag::vec:
+    // a packed array is a `vec`, like for `type()`
+    case TypeTag::int64_vec:
+    case TypeTag::uint64_vec:
+    case TypeTag::double_vec:
+    case TypeTag::bool_vec:
         return typeid(Vec);
     case TypeTag::map:
         return typeid(Map);
     }
 }
+
+Variant::TypeTag Variant::packedType() const noexcept {
+    if (!Impl::isPacked(type_tag_)) {
+        return type_tag_;
+    }
+    return Impl::visitPacked(*this, [this](auto const& packed) {
+        return packed.isFreed() ? TypeTag::vec : type_tag_;
+    });
+}
 #pragma GCC diagnostic pop
 #else
 #error The compiler not supported
@@ -1282,4 +3292,132 @@ bool Variant::null() const noexcept {
     return type_tag_ == TypeTag::null;
 }
 
+namespace {
+
+template <class T>
+std::size_t bufferBytes(std::vector<T> const&, std::size_t n) noexcept {
+    return n * sizeof(T);
+}
+
+std::size_t bufferBytes(Variant::BoolVec const&, std::size_t n) noexcept {
+    return (n + CHAR_BIT - 1) / CHAR_BIT;
+}
+
+} // namespace
+
+void Variant::Impl::stats(Variant const& x,
+                          std::size_t depth,
+                          VariantStats& ret,
+                          std::unordered_set<void const*>& seen) {
+    ++ret.nodes[static_cast<std::size_t>(x.packedType())];
+    ret.max_depth = std::max(ret.max_depth, depth);
+    if (x.isScalar() && x.type_tag_ != TypeTag::string) {
+        return;
+    }
+
+    auto owned = false;
+    if (x.storage_ == Storage::heap) {
+        owned = seen.insert(x.value_.ptr).second;
+        ret.shared_payloads += !owned;
+    }
+
+    switch (x.type_tag_) {
+    case TypeTag::string: {
+        ret.string_bytes += string(x).size();
+        if (owned) {
+            auto const& str = payload<std::string>(x.value_.ptr);
+            ret.heap_bytes += sizeof(Shared<std::string>);
+            if (str.capacity() > std::string().capacity()) {
+                ret.heap_bytes += str.capacity() + 1;
+            }
+        }
+        break;
+    }
+    case TypeTag::vec: {
+        auto const& vec = payload<Vec>(x.value_.ptr);
+        ret.slack_bytes += (vec.capacity() - vec.size()) * sizeof(Variant);
+        if (owned) {
+            ret.heap_bytes += sizeof(Shared<Vec>) + vec.capacity() * sizeof(Variant);
+        } else if (x.storage_ == Storage::arena) {
+            ret.heap_bytes += vec.capacity() * sizeof(Variant);
+        }
+        for (auto const& y : vec) {
+            stats(y, depth + 1, ret, seen);
+        }
+        break;
+    }
+    case TypeTag::map: {
+        auto const& map = payload<Map>(x.value_.ptr);
+        // an entry, its key hash and up to two slots of the index
+        ret.slack_bytes += (map.capacity() - map.size())
+                         * (sizeof(Map::value_type) + sizeof(uint32_t));
+        if (owned) {
+            auto const index = (map.capacity() + map.bucket_count()) * sizeof(uint32_t);
+            ret.index_bytes += index;
+            ret.heap_bytes += sizeof(Shared<Map>)
+                            + map.capacity() * sizeof(Map::value_type) + index;
+        }
+        for (auto const& [key, y] : map) {
+            ret.key_bytes += key.view().size();
+            stats(y, depth + 1, ret, seen);
+        }
+        break;
+    }
+    default:
+        visitPacked(x, [&](auto& packed) {
+            using T = std::decay_t<decltype(packed)>;
+            if (owned) {
+                ret.heap_bytes += sizeof(Shared<T>);
+                if (auto const vec = packed.unpacked.load(std::memory_order_acquire)) {
+                    ret.heap_bytes += sizeof(Vec) + vec->capacity() * sizeof(Variant);
+                }
+            }
+            readValues(packed, [&](auto const& values) {
+                if constexpr (std::is_same_v<std::decay_t<decltype(values)>, Vec>) {
+                    // freed by `vec()`, counted like the elements of a `vec`
+                    for (auto const& y : values) {
+                        stats(y, depth + 1, ret, seen);
+                    }
+                } else {
+                    ret.packed_elements += values.size();
+                    if (!values.empty()) {
+                        ret.max_depth = std::max(ret.max_depth, depth + 1);
+                    }
+                    ret.slack_bytes +=
+                            bufferBytes(values, values.capacity() - values.size());
+                    if (owned || x.storage_ == Storage::arena) {
+                        ret.heap_bytes += bufferBytes(values, values.capacity());
+                    }
+                }
+            });
+        });
+        break;
+    }
+}
+
+VariantStats stats(Variant const& x) {
+    VariantStats ret;
+    std::unordered_set<void const*> seen;
+    Variant::Impl::stats(x, 1, ret, seen);
+    return ret;
+}
+
+PayloadHook setPayloadHook(PayloadHook hook) noexcept {
+    return payload_hook.exchange(hook);
+}
+
+std::size_t setPayloadPoolLimit(std::size_t limit) noexcept {
+    auto const ret = pool_limit.exchange(limit);
+    pool_epoch.fetch_add(1, std::memory_order_release);
+    if (limit < ret) {
+        for (std::size_t c = 0; c < pool_classes; ++c) {
+            global_pool[c].trim(c, limit * global_pool_factor);
+        }
+        if (!thread_pool_destroyed) {
+            (void)thread_pool.limit();
+        }
+    }
+    return ret;
+}
+
 } // namespace yenxo
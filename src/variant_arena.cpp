@@ -0,0 +1,85 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <yenxo/variant_arena.hpp>
+
+#include <algorithm>
+#include <cstdint>
+#include <new>
+
+namespace yenxo {
+
+VariantArena::VariantArena(std::size_t initial_size)
+        : next_size_(std::max<std::size_t>(initial_size, 64)) {
+}
+
+VariantArena::~VariantArena() {
+    for (auto const& block : blocks_) {
+        ::operator delete(block.data);
+    }
+}
+
+void VariantArena::reset() noexcept {
+    current_ = 0;
+    offset_ = 0;
+    used_ = 0;
+}
+
+std::size_t VariantArena::capacity() const noexcept {
+    std::size_t ret{0};
+    for (auto const& block : blocks_) {
+        ret += block.size;
+    }
+    return ret;
+}
+
+void* VariantArena::do_allocate(std::size_t bytes, std::size_t alignment) {
+    for (; current_ < blocks_.size(); ++current_, offset_ = 0) {
+        auto const& block = blocks_[current_];
+        auto const base = reinterpret_cast<std::uintptr_t>(block.data);
+        auto const begin = ((base + offset_ + alignment - 1) & ~(alignment - 1)) - base;
+        if (begin + bytes <= block.size) {
+            offset_ = begin + bytes;
+            used_ += bytes;
+            return block.data + begin;
+        }
+    }
+
+    auto const size = std::max(next_size_, bytes + alignment);
+    blocks_.reserve(blocks_.size() + 1);
+    blocks_.push_back(Block{static_cast<std::byte*>(::operator new(size)), size});
+    next_size_ = size * 2;
+    current_ = blocks_.size() - 1;
+    offset_ = 0;
+    return do_allocate(bytes, alignment);
+}
+
+void VariantArena::do_deallocate(void*, std::size_t, std::size_t) noexcept {
+}
+
+bool VariantArena::do_is_equal(std::pmr::memory_resource const& other) const noexcept {
+    return this == &other;
+}
+
+} // namespace yenxo
@@ -0,0 +1,239 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include "allocation_counter.hpp"
+
+#include <yenxo/variant.hpp>
+#include <yenxo/variant_arena.hpp>
+#include <yenxo/variant_conversion.hpp>
+#include <yenxo/variant_stats.hpp>
+#include <yenxo/variant_traits.hpp>
+
+#include <catch2/catch_all.hpp>
+
+#include <rapidjson/document.h>
+
+#include <boost/hana.hpp>
+
+#include <future>
+#include <map>
+#include <optional>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+using namespace yenxo;
+
+namespace {
+
+/// Number of global allocations made by `f`
+template <class F>
+size_t countAllocations(F&& f) {
+    auto const start = allocationCount();
+    f();
+    return allocationCount() - start;
+}
+
+struct Point : trait::Var<Point> {
+    int x;
+    int y;
+};
+
+struct Record : trait::Var<Record> {
+    int id;
+    std::string name;
+    Point point;
+    std::optional<double> score;
+    std::pair<int, int> range;
+    std::vector<std::string> tags;
+    std::map<std::string, int> counts;
+};
+
+} // namespace
+
+BOOST_HANA_ADAPT_STRUCT(Point, x, y);
+BOOST_HANA_ADAPT_STRUCT(Record, id, name, point, score, range, tags, counts);
+
+// The strings below fit into `std::string` and `Variant` without a heap allocation, so
+// only the containers of the result are expected to allocate.
+TEST_CASE("Check fromVariant allocations", "[allocations]") {
+    SECTION("collection is reserved") {
+        Variant const var = toVariant(std::vector<std::string>(20, "tag"));
+        std::vector<std::string> ret;
+        REQUIRE(countAllocations(
+                        [&] { ret = fromVariant<std::vector<std::string>>(var); })
+                == 1);
+        REQUIRE(ret.size() == 20);
+    }
+
+    SECTION("map keys are converted directly") {
+        Variant const var = Variant::fromJson(R"({"a": 1, "b": 2, "c": 3})");
+        std::map<std::string, int> ret;
+        REQUIRE(countAllocations(
+                        [&] { ret = fromVariant<std::map<std::string, int>>(var); })
+                == 3);
+        REQUIRE(ret == std::map<std::string, int>{{"a", 1}, {"b", 2}, {"c", 3}});
+    }
+
+    SECTION("struct") {
+        Record const record{{},
+                            7,
+                            "name",
+                            {{}, 1, 2},
+                            0.5,
+                            {3, 4},
+                            {"a", "b", "c"},
+                            {{"x", 1}, {"y", 2}}};
+        Variant const var = toVariant(record);
+        // the first conversion interns the keys
+        (void)fromVariant<Record>(var);
+
+        Record ret;
+        // one for `tags` and one for each node of `counts`
+        REQUIRE(countAllocations([&] { ret = fromVariant<Record>(var); }) == 3);
+        REQUIRE(ret.id == 7);
+        REQUIRE(ret.point.y == 2);
+        REQUIRE(ret.range == std::pair(3, 4));
+        REQUIRE(ret.tags == record.tags);
+        REQUIRE(ret.counts == record.counts);
+    }
+}
+
+TEST_CASE("Check payload pool", "[allocations]") {
+    auto const previous = setPayloadPoolLimit(64);
+    auto const makeMap = [] { Variant const x{Variant::Map()}; };
+    makeMap();
+    REQUIRE(countAllocations(makeMap) == 0);
+
+    setPayloadPoolLimit(0);
+    REQUIRE(countAllocations(makeMap) == 1);
+
+    SECTION("disabling frees the pooled payloads") {
+        setPayloadPoolLimit(64);
+        makeMap();
+        setPayloadPoolLimit(0);
+        setPayloadPoolLimit(64);
+        REQUIRE(countAllocations(makeMap) == 1);
+        REQUIRE(countAllocations(makeMap) == 0);
+    }
+
+    SECTION("the global pool is capped") {
+        constexpr std::size_t limit = 4;
+        setPayloadPoolLimit(limit);
+        std::vector<Variant> maps;
+        maps.reserve(200);
+        std::thread([&maps] {
+            for (std::size_t i = 0; i < maps.capacity(); ++i) {
+                maps.emplace_back(Variant::Map());
+            }
+            // the payloads beyond the limit go to the global pool or are freed
+            maps.clear();
+        }).join();
+        REQUIRE(countAllocations([&maps] {
+                    for (std::size_t i = 0; i < 100; ++i) {
+                        maps.emplace_back(Variant::Map());
+                    }
+                })
+                == 100 - limit * 16);
+        maps.clear();
+    }
+
+    SECTION("another thread trims its pool on its next allocation") {
+        setPayloadPoolLimit(64);
+        std::promise<void> pooled;
+        std::promise<void> lowered;
+        std::size_t allocations = 0;
+        std::thread worker([&] {
+            std::vector<Variant> maps;
+            maps.reserve(10);
+            for (std::size_t i = 0; i < 10; ++i) {
+                maps.emplace_back(Variant::Map());
+            }
+            maps.clear();
+            pooled.set_value();
+            lowered.get_future().wait();
+            allocations = countAllocations([&maps] {
+                for (std::size_t i = 0; i < 10; ++i) {
+                    maps.emplace_back(Variant::Map());
+                }
+            });
+        });
+        pooled.get_future().wait();
+        setPayloadPoolLimit(2);
+        lowered.set_value();
+        worker.join();
+        // the maps beyond the 2 kept
+        REQUIRE(allocations == 8);
+    }
+
+    setPayloadPoolLimit(previous);
+}
+
+TEST_CASE("Check toJson allocations", "[allocations]") {
+    auto const var =
+            Variant::fromJson(R"({"a": [1, 2, {"b": [[["text"]]]}], "c": null})");
+    std::string out;
+    var.toJson(out);
+    REQUIRE(countAllocations([&] { var.toJson(out); }) == 0);
+    REQUIRE(out == var.toJson());
+
+    out = "x";
+    var.appendJson(out);
+    REQUIRE(out == "x" + var.toJson());
+}
+
+// The trees are built once before counting, so their keys are interned and the payload
+// pool is warm. The parse stack and the key cache of the handler are on the heap with
+// and without an arena.
+TEST_CASE("Check VariantArena allocations", "[allocations]") {
+    // heap allocations saved by building the tree of `json` in an arena
+    auto const saved = [](char const* json) {
+        rapidjson::Document doc;
+        doc.Parse(json);
+        VariantArena arena;
+        { auto const var = Variant::from(doc); }
+        { auto const var = Variant::from(doc, arena); }
+        arena.reset();
+        auto const heap = countAllocations([&] { auto const var = Variant::from(doc); });
+        auto const in_arena =
+                countAllocations([&] { auto const var = Variant::from(doc, arena); });
+        return heap - in_arena;
+    };
+
+    SECTION("strings") {
+        REQUIRE(saved(R"(["a string longer than the inline capacity", "short"])") == 1);
+    }
+
+    SECTION("map entries and hashes") {
+        REQUIRE(saved(R"({"a": 1})") == 2);
+        // and their regrowths
+        REQUIRE(saved(R"({"a": 1, "b": 2, "c": 3})") == 6);
+    }
+
+    SECTION("vec buffers are on the heap") {
+        REQUIRE(saved("[1, 2, 3]") == 0);
+        REQUIRE(saved("[[1], [2]]") == 0);
+    }
+}
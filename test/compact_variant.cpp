@@ -0,0 +1,139 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#include <yenxo/compact_variant.hpp>
+#include <yenxo/exception.hpp>
+
+#include <catch2/catch_all.hpp>
+
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+using namespace yenxo;
+
+TEST_CASE("Check CompactVariant", "[compact_variant]") {
+    using TypeTag = CompactVariant::TypeTag;
+
+    SECTION("size") {
+        REQUIRE(sizeof(CompactVariant) == 8);
+    }
+
+    SECTION("scalars") {
+        REQUIRE(CompactVariant().null());
+        REQUIRE(CompactVariant(true).boolean());
+        REQUIRE(CompactVariant('x').character() == 'x');
+        REQUIRE(CompactVariant(int8_t(-8)).int8() == -8);
+        REQUIRE(CompactVariant(uint8_t(200)).uint8() == 200);
+        REQUIRE(CompactVariant(int16_t(-300)).int16() == -300);
+        REQUIRE(CompactVariant(uint16_t(60000)).uint16() == 60000);
+        REQUIRE(CompactVariant(int32_t(-70000)).int32() == -70000);
+        REQUIRE(CompactVariant(uint32_t(4000000000u)).uint32() == 4000000000u);
+        REQUIRE(CompactVariant(2.5).floating() == 2.5);
+        REQUIRE(CompactVariant(-0.0).floating() == 0.0);
+        REQUIRE(CompactVariant(std::numeric_limits<double>::infinity()).floating()
+                == std::numeric_limits<double>::infinity());
+        REQUIRE(CompactVariant(-std::numeric_limits<double>::infinity()).type()
+                == TypeTag::double_);
+        REQUIRE(std::isnan(CompactVariant(-std::nan("")).floating()));
+        REQUIRE(CompactVariant(-std::nan("")).type() == TypeTag::double_);
+
+        REQUIRE(CompactVariant(int8_t(1)).type() == TypeTag::int8);
+        REQUIRE(CompactVariant(uint32_t(1)).type() == TypeTag::uint32);
+        REQUIRE(CompactVariant(1.0).type() == TypeTag::double_);
+    }
+
+    SECTION("64-bit integers") {
+        auto const int64_min = std::numeric_limits<int64_t>::min();
+        auto const int64_max = std::numeric_limits<int64_t>::max();
+        auto const uint64_max = std::numeric_limits<uint64_t>::max();
+        auto const limit48 = int64_t(1) << 47;
+        for (auto x : {int64_t(0),
+                       int64_t(-1),
+                       -limit48,
+                       limit48 - 1,
+                       limit48,
+                       int64_min,
+                       int64_max}) {
+            CompactVariant const var(x);
+            REQUIRE(var.type() == TypeTag::int64);
+            REQUIRE(var.int64() == x);
+            REQUIRE(CompactVariant(var) == var);
+        }
+        auto const ulimit48 = uint64_t(1) << 48;
+        for (auto x : {uint64_t(0), ulimit48 - 1, ulimit48, uint64_max}) {
+            CompactVariant const var(x);
+            REQUIRE(var.type() == TypeTag::uint64);
+            REQUIRE(var.uint64() == x);
+        }
+        REQUIRE(CompactVariant(int64_t(-1)) != CompactVariant(uint64_t(1)));
+    }
+
+    SECTION("conversions and errors as Variant") {
+        REQUIRE(CompactVariant(uint8_t(5)).int64() == 5);
+        REQUIRE(CompactVariant(int64_t(5)).int8() == 5);
+        REQUIRE_THROWS_AS(CompactVariant(int64_t(500)).int8(), VariantIntegralOverflow);
+        REQUIRE_THROWS_AS(CompactVariant().int32(), VariantEmpty);
+        REQUIRE_THROWS_AS(CompactVariant("abc").int32(), VariantBadType);
+        REQUIRE_THROWS_AS(CompactVariant(1).str(), VariantBadType);
+        REQUIRE_THROWS_AS(CompactVariant(1).vec(), VariantBadType);
+        REQUIRE_THROWS_AS(CompactVariant().map(), VariantEmpty);
+        REQUIRE(CompactVariant().int32Or(7) == 7);
+        REQUIRE(CompactVariant().strOr("x") == "x");
+        REQUIRE(CompactVariant(3).int32Or(7) == 3);
+    }
+
+    SECTION("containers") {
+        CompactVariant::Vec const list{CompactVariant(1), CompactVariant("a")};
+        CompactVariant var(CompactVariant::Map{{"list", CompactVariant(list)},
+                                               {"name", CompactVariant("name")}});
+        REQUIRE(var.map().at("list").vec().size() == 2);
+        REQUIRE(var.map().at("name").str() == "name");
+
+        auto copy = var;
+        REQUIRE(&copy.map() == &var.map());
+        copy.modifyMap()["added"] = CompactVariant(2);
+        REQUIRE(&copy.map() != &var.map());
+        REQUIRE(var.map().size() == 2);
+        REQUIRE(copy.map().size() == 3);
+        REQUIRE(copy != var);
+
+        auto const packed = Variant(Variant::Int64Vec{1, -2, 5000000000});
+        REQUIRE(CompactVariant(packed).toJson() == "[1,-2,5000000000]");
+        REQUIRE(CompactVariant(packed).expand() == Variant(packed.vec()));
+    }
+
+    SECTION("JSON round-trip") {
+        auto const json = R"({"a":[1,-2,2.5,5000000000,-5000000000,)"
+                          R"(18446744073709551615],"b":"text","c":null,"d":true,"e":{}})";
+        auto const var = CompactVariant::fromJson(json);
+        REQUIRE(var.toJson() == json);
+        REQUIRE(var.expand() == Variant::fromJson(json));
+        REQUIRE(CompactVariant(Variant::fromJson(json)) == var);
+        REQUIRE(CompactVariant::fromJson(var.toPrettyJson()) == var);
+        REQUIRE_THROWS_AS(CompactVariant::fromJson("[1,"), std::runtime_error);
+    }
+}
@@ -0,0 +1,188 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+// tested
+#include <yenxo/format.hpp>
+
+#include <yenxo/define_enum.hpp>
+#include <yenxo/ostream_traits.hpp>
+#include <yenxo/variant.hpp>
+
+// 3rd
+#include <catch2/catch_all.hpp>
+
+// std
+#include <iomanip>
+#include <limits>
+#include <map>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <variant>
+#include <vector>
+
+using namespace yenxo;
+
+namespace {
+
+YENXO_DEFINE_ENUM(Color, red, (green, , "Green"));
+
+struct Point {
+    friend constexpr std::string_view typeNameImpl(Point const*) {
+        return "Point";
+    }
+
+    int x;
+    double y;
+};
+
+struct Shape : trait::OStream<Shape> {
+    friend constexpr std::string_view typeNameImpl(Shape const*) {
+        return "Shape";
+    }
+
+    Color color;
+    std::vector<Point> points;
+    std::optional<std::string> name;
+};
+
+struct Opaque {
+    friend std::ostream& operator<<(std::ostream& os, Opaque const& x) {
+        return os << "Opaque(" << x.id << ")";
+    }
+
+    int id;
+};
+
+template <class T>
+std::string formatted(T const& x) {
+    Buffer buf;
+    format(buf, x);
+    return buf.str();
+}
+
+template <class T>
+std::string streamed(T const& x) {
+    std::ostringstream os;
+    os << x;
+    return os.str();
+}
+
+} // namespace
+
+BOOST_HANA_ADAPT_STRUCT(Point, x, y);
+BOOST_HANA_ADAPT_STRUCT(Shape, color, points, name);
+
+TEST_CASE("Check format", "[format]") {
+    SECTION("numbers as std::ostream writes them") {
+        REQUIRE(formatted(0) == "0");
+        REQUIRE(formatted(-42) == "-42");
+        REQUIRE(formatted(std::numeric_limits<uint64_t>::max()) == "18446744073709551615");
+        REQUIRE(formatted(std::numeric_limits<int64_t>::min()) == "-9223372036854775808");
+        REQUIRE(formatted(true) == "1");
+        REQUIRE(formatted('a') == "a");
+        REQUIRE(formatted(int8_t{'b'}) == "b");
+        for (double const x : {0.0, -0.0, 0.1, 1.0 / 3, 2.5, 100.0, 1e6, 1234567.0, 1e16, 1e-5,
+                               -3.14159265, std::numeric_limits<double>::max(),
+                               std::numeric_limits<double>::infinity()}) {
+            REQUIRE(formatted(x) == streamed(x));
+        }
+        REQUIRE(formatted(1.5f) == "1.5");
+    }
+
+    SECTION("strings and enums") {
+        REQUIRE(formatted(std::string("abc")) == "abc");
+        REQUIRE(formatted(std::string_view("abc")) == "abc");
+        REQUIRE(formatted("abc") == "abc");
+        REQUIRE(formatted(Color::red) == "red");
+        REQUIRE(formatted(Color::green) == "Green");
+    }
+
+    SECTION("containers") {
+        REQUIRE(formatted(std::vector<int>{}) == "[]");
+        REQUIRE(formatted(std::vector<int>{1, 2, 3}) == "[1, 2, 3]");
+        REQUIRE(formatted(std::map<std::string, int>{}) == "{  }");
+        REQUIRE(formatted(std::map<std::string, int>{{"a", 1}, {"b", 2}})
+                == "{ a: 1; b: 2; }");
+        REQUIRE(formatted(std::optional<int>()) == "None");
+        REQUIRE(formatted(std::optional<int>(5)) == "5");
+        REQUIRE(formatted(std::variant<int, std::string>("x")) == "x");
+        REQUIRE(formatted(std::vector<Opaque>{{1}, {2}}) == "[Opaque(1), Opaque(2)]");
+    }
+
+    SECTION("structs") {
+        Shape const shape{{}, Color::green, {{1, 0.5}, {2, -1}}, std::nullopt};
+        REQUIRE(formatted(Point{1, 0.5}) == "Point { x: 1; y: 0.5; }");
+        REQUIRE(formatted(shape)
+                == "Shape { color: Green; points: [Point { x: 1; y: 0.5; }, "
+                   "Point { x: 2; y: -1; }]; name: None; }");
+        REQUIRE(streamed(shape) == formatted(shape));
+    }
+
+    SECTION("Variant") {
+        Variant const var = Variant::fromJson(R"({
+            "null": null,
+            "text": "abc",
+            "number": 1.25,
+            "list": [1, "two", [], {}],
+            "packed": [1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16]
+        })");
+        REQUIRE(formatted(var)
+                == "{ null: Null; text: abc; number: 1.25; list: [ 1, two, [ ], { } ]; "
+                   "packed: [ 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16 ]; }");
+        REQUIRE(streamed(var) == formatted(var));
+        REQUIRE(formatted(Variant(int8_t{'c'})) == "c");
+        REQUIRE(formatted(Variant(true)) == "1");
+    }
+
+    SECTION("stream format") {
+        Shape const shape{{}, Color::red, {{10, 1.0 / 3}}, std::nullopt};
+        auto const var = Variant::fromJson(R"([0.125, true, 255])");
+        std::ostringstream os;
+        os << std::setprecision(2) << std::boolalpha << std::hex;
+        os << shape << ' ' << var << ' ' << std::setw(7) << Variant(1.0 / 3);
+        REQUIRE(os.str()
+                == "Shape { color: red; points: [Point { x: a; y: 0.33; }]; name: None; } "
+                   "[ 0.12, true, ff ]    0.33");
+        REQUIRE(os.precision() == 2);
+
+        std::ostringstream fixed;
+        fixed << std::fixed << std::setprecision(1) << std::showpos;
+        oStream(fixed, std::vector<double>{2.5, 1});
+        REQUIRE(fixed.str() == "[+2.5, +1.0]");
+    }
+
+    SECTION("buffer reuse") {
+        Buffer buf;
+        format(buf, std::vector<int>(100, 7));
+        auto const capacity = buf.str().capacity();
+        buf.clear();
+        REQUIRE(buf.empty());
+        format(buf, 42);
+        buf.push_back(' ');
+        format(buf, std::string("x"));
+        REQUIRE(buf.view() == "42 x");
+        REQUIRE(buf.str().capacity() == capacity);
+    }
+}
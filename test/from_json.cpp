@@ -0,0 +1,202 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#include <yenxo/exception.hpp>
+#include <yenxo/from_json.hpp>
+#include <yenxo/variant.hpp>
+#include <yenxo/variant_traits.hpp>
+
+#include <catch2/catch_all.hpp>
+
+#include <boost/hana.hpp>
+
+#include <map>
+#include <optional>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+using namespace yenxo;
+namespace hana = boost::hana;
+using namespace hana::literals;
+
+namespace {
+
+struct Hobby : trait::Var<Hobby> {
+    int id;
+    std::string description;
+    std::optional<double> score;
+
+    static auto names() {
+        return hana::make_map(hana::make_pair("description"_s, "desc"));
+    }
+
+    bool operator==(Hobby const& x) const {
+        return id == x.id && description == x.description && score == x.score;
+    }
+};
+
+struct Person : trait::Var<Person> {
+    std::string name;
+    int age;
+    std::vector<Hobby> hobbies;
+    std::map<std::string, int> counts;
+    std::set<int> ids;
+    std::optional<Hobby> best;
+    std::pair<int, int> range;
+    Variant extra;
+    std::vector<std::vector<int>> grid;
+    unsigned level;
+
+    static auto defaults() {
+        return hana::make_map(hana::make_pair("level"_s, 7u));
+    }
+};
+
+struct StrictPolicy : trait::VarPolicy {
+    static auto constexpr allow_additional_properties = false;
+};
+
+struct Strict : trait::Var<Strict, StrictPolicy> {
+    int a;
+};
+
+struct Holder : trait::Var<Holder> {
+    std::vector<Strict> strict;
+    std::unordered_map<std::string, Hobby> byName;
+};
+
+/// The message and the path thrown by `f`
+template <class F>
+std::pair<std::string, std::string> error(F&& f) {
+    try {
+        f();
+    } catch (VariantErr const& e) {
+        return {e.what(), e.path()};
+    } catch (std::exception const& e) {
+        return {e.what(), "-"};
+    }
+    return {"not thrown", {}};
+}
+
+/// `fromJson` fails like the conversion through `Variant`
+template <class T>
+void checkError(std::string const& json) {
+    INFO(json);
+    auto const direct = error([&] { fromJson<T>(json); });
+    auto const variant = error([&] { fromVariant<T>(Variant::fromJson(json)); });
+    REQUIRE(direct.first != "not thrown");
+    REQUIRE(direct == variant);
+}
+
+} // namespace
+
+BOOST_HANA_ADAPT_STRUCT(Hobby, id, description, score);
+BOOST_HANA_ADAPT_STRUCT(
+        Person, name, age, hobbies, counts, ids, best, range, extra, grid, level);
+BOOST_HANA_ADAPT_STRUCT(Strict, a);
+BOOST_HANA_ADAPT_STRUCT(Holder, strict, byName);
+
+TEST_CASE("Check fromJson", "[from_json]") {
+    SECTION("struct") {
+        std::string const json = R"({
+            "name": "Ann",
+            "age": 30,
+            "hobbies": [
+                {"id": 1, "desc": "chess", "score": 2.5},
+                {"id": 2, "desc": "go"}
+            ],
+            "counts": {"a": 1, "b": 2},
+            "ids": [3, 1, 2],
+            "best": {"id": 9, "desc": "x"},
+            "range": {"first": 1, "second": 2},
+            "extra": {"k": [1, "two", null]},
+            "grid": [[1, 2], [], [3]],
+            "unknown": {"deep": [1, {"x": 2}]}
+        })";
+        auto const x = fromJson<Person>(json);
+        auto const y = fromVariant<Person>(Variant::fromJson(json));
+        REQUIRE(x.name == "Ann");
+        REQUIRE(x.age == 30);
+        REQUIRE(x.hobbies == y.hobbies);
+        REQUIRE(!x.hobbies[1].score);
+        REQUIRE(x.counts == y.counts);
+        REQUIRE(x.ids == std::set<int>{1, 2, 3});
+        REQUIRE(x.best == y.best);
+        REQUIRE(x.range == std::pair(1, 2));
+        REQUIRE(x.extra == y.extra);
+        REQUIRE(x.grid == y.grid);
+        REQUIRE(x.level == 7);
+
+        auto const z = fromJson<Holder>(R"({
+            "strict": [{"a": 1}, {"a": 2}],
+            "byName": {"x": {"id": 1, "desc": "d"}}
+        })");
+        REQUIRE(z.strict.size() == 2);
+        REQUIRE(z.strict[1].a == 2);
+        REQUIRE(z.byName.at("x").description == "d");
+    }
+
+    SECTION("other types") {
+        REQUIRE(fromJson<std::vector<int>>("[1, 2, 3]") == std::vector<int>{1, 2, 3});
+        REQUIRE(fromJson<int>("5") == 5);
+        REQUIRE(fromJson<std::optional<int>>("5") == 5);
+        REQUIRE(fromJson<std::string>(R"("text")") == "text");
+        auto const json = R"({"a": [1, {"b": null}], "c": "d"})";
+        REQUIRE(fromJson<Variant>(json) == Variant::fromJson(json));
+    }
+
+    SECTION("errors") {
+        checkError<Person>(R"({"name": 1})");
+        checkError<Person>(R"({"name": "a", "age": "x"})");
+        checkError<Person>(R"({"name": "a", "age": 4294967296})");
+        checkError<Person>(R"({"name": "a", "age": 1,
+            "hobbies": [{"id": 1, "desc": "a"}, {"id": "z", "desc": "b"}]})");
+        checkError<Person>(R"({"name": "a", "age": 1, "hobbies": [{"desc": "b"}]})");
+        checkError<Person>(R"({"name": "a", "age": 1, "hobbies": [],
+            "counts": {"a": "x"}})");
+        checkError<Person>(R"({"name": "a", "age": 1, "hobbies": [], "counts": {},
+            "ids": [1, "x"]})");
+        checkError<Person>(R"({"name": "a", "age": 1, "hobbies": [], "counts": {},
+            "ids": [], "best": {"id": 1}})");
+        checkError<Person>(R"({"name": "a", "age": 1, "hobbies": [], "counts": {},
+            "ids": [], "range": {"first": 1}})");
+        checkError<Person>(R"({"name": "a", "age": 1, "hobbies": [], "counts": {},
+            "ids": [], "range": {"first": 1, "second": 2}, "extra": 1,
+            "grid": [[1], [2, "x"]]})");
+        checkError<Person>(R"({"name": "a", "age": 1, "hobbies": {}})");
+        checkError<Person>(R"([1])");
+        checkError<Person>("null");
+        checkError<Strict>(R"({"a": 1, "b": 2})");
+        checkError<Holder>(R"({"strict": [{"a": 1}, {"a": 1, "b": 2}], "byName": {}})");
+        checkError<Holder>(R"({"strict": [], "byName": {"x": {"id": "bad"}}})");
+        checkError<std::vector<int>>(R"([1, 2, "3"])");
+
+        REQUIRE_THROWS_AS(fromJson<Person>(R"({"name": "a")"), std::runtime_error);
+    }
+}
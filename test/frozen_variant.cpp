@@ -0,0 +1,156 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#include <yenxo/exception.hpp>
+#include <yenxo/frozen_variant.hpp>
+#include <yenxo/variant.hpp>
+
+#include <catch2/catch_all.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+using namespace yenxo;
+
+TEST_CASE("Check FrozenVariant", "[frozen_variant]") {
+    auto const json = R"({
+        "id": "a-rather-long-identifier-string",
+        "list": [1, "two", {"three": 3.5}, []],
+        "flag": true,
+        "empty": {},
+        "none": null,
+        "big": 5000000000
+    })";
+
+    SECTION("freeze") {
+        auto const var = Variant::fromJson(json);
+        auto const frozen = var.freeze();
+        REQUIRE(equal(frozen, var));
+        REQUIRE(equal(var, frozen));
+        REQUIRE(frozen.thaw() == var);
+        REQUIRE(frozen.size() == 6);
+        REQUIRE(frozen.bytes() > 0);
+
+        auto const packed = Variant(Variant::DoubleVec(YENXO_PACKED_MIN_SIZE, 1.5));
+        REQUIRE(packed.freeze().type() == Variant::TypeTag::vec);
+        REQUIRE(equal(packed.freeze(), packed));
+        REQUIRE(packed.freeze().toJson() == packed.toJson());
+    }
+
+    SECTION("fromJson") {
+        auto const frozen = FrozenVariant::fromJson(json);
+        REQUIRE(equal(frozen, Variant::fromJson(json)));
+        REQUIRE(equal(frozen, Variant::fromJson(json).freeze()));
+        REQUIRE_THROWS_AS(FrozenVariant::fromJson("{"), std::runtime_error);
+    }
+
+    SECTION("lookup") {
+        auto const frozen = FrozenVariant::fromJson(json);
+        REQUIRE(frozen.type() == Variant::TypeTag::map);
+        REQUIRE(frozen.at("id").str() == "a-rather-long-identifier-string");
+        REQUIRE(frozen.at("list").at(2).at("three").floating() == 3.5);
+        REQUIRE(frozen.at("list").at(0).int64() == 1);
+        REQUIRE(frozen.at("flag").boolean());
+        REQUIRE(frozen.at("none").null());
+        REQUIRE(frozen.at("big").uint64() == 5000000000u);
+        REQUIRE_FALSE(frozen.find("absent"));
+        REQUIRE_THROWS_AS(frozen.at("absent"), std::out_of_range);
+        REQUIRE_THROWS_AS(frozen.at("list").at(4), std::out_of_range);
+        REQUIRE_THROWS_AS(frozen.at("id").int32(), VariantBadType);
+        REQUIRE_THROWS_AS(frozen.at("big").int32(), VariantIntegralOverflow);
+        REQUIRE_THROWS_AS(frozen.at("none").int32(), VariantEmpty);
+        REQUIRE_THROWS_AS(frozen.at("flag").vec(), VariantBadType);
+    }
+
+    SECTION("iteration") {
+        auto const frozen = FrozenVariant::fromJson(json);
+        std::vector<std::string_view> keys;
+        for (auto const& [key, value] : frozen.map()) {
+            keys.push_back(key);
+        }
+        REQUIRE(keys
+                == std::vector<std::string_view>{
+                        "big", "empty", "flag", "id", "list", "none"});
+
+        std::vector<Variant::TypeTag> types;
+        for (auto const x : frozen.at("list").vec()) {
+            types.push_back(x.type());
+        }
+        REQUIRE(types
+                == std::vector<Variant::TypeTag>{Variant::TypeTag::uint32,
+                                                 Variant::TypeTag::string,
+                                                 Variant::TypeTag::map,
+                                                 Variant::TypeTag::vec});
+        REQUIRE(frozen.at("empty").map().empty());
+        REQUIRE(frozen.at("list").at(3).vec().empty());
+    }
+
+    SECTION("repeated keys") {
+        auto const frozen = FrozenVariant::fromJson(R"({"b": 1, "a": 2, "b": 3})");
+        REQUIRE(frozen.size() == 2);
+        REQUIRE(frozen.at("b").int32() == 3);
+    }
+
+    SECTION("toJson") {
+        auto const frozen = FrozenVariant::fromJson(R"({"b": [1, -2, 2.5], "a": "x"})");
+        REQUIRE(frozen.toJson() == R"({"a":"x","b":[1,-2,2.5]})");
+        REQUIRE(Variant::fromJson(frozen.toPrettyJson()) == frozen.thaw());
+    }
+
+    SECTION("equal") {
+        auto const frozen = FrozenVariant::fromJson(R"({"a": [1, "x"]})");
+        auto const var = Variant(VariantMap{
+                {"a", Variant(VariantVec{Variant(int64_t(1)), Variant("x")})}});
+        REQUIRE(equal(frozen, var));
+        REQUIRE_FALSE(equal(frozen, FrozenVariant::fromJson(R"({"a": [1, "y"]})")));
+        REQUIRE_FALSE(equal(frozen, FrozenVariant::fromJson(R"({"b": [1, "x"]})")));
+        REQUIRE_FALSE(equal(frozen.at("a"), Variant("x")));
+        REQUIRE(equal(FrozenRef(), Variant()));
+    }
+
+    SECTION("copies share the block") {
+        FrozenVariant copy;
+        REQUIRE(copy.null());
+        {
+            auto const frozen = FrozenVariant::fromJson(json);
+            copy = frozen;
+            REQUIRE(&copy.at("id").str()[0] == &frozen.at("id").str()[0]);
+        }
+        REQUIRE(copy.at("id").str() == "a-rather-long-identifier-string");
+
+        std::vector<std::thread> threads;
+        for (int i = 0; i < 4; ++i) {
+            threads.emplace_back([copy] {
+                REQUIRE(copy.at("list").size() == 4);
+            });
+        }
+        for (auto& x : threads) {
+            x.join();
+        }
+    }
+}
@@ -0,0 +1,107 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <yenxo/interned_key.hpp>
+
+#include <catch2/catch_all.hpp>
+
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace yenxo;
+
+TEST_CASE("Check InternedKey", "[interned_key]") {
+    SECTION("equal strings share the pooled string") {
+        auto const size = InternedKey::poolSize();
+        InternedKey const a("interned_key_test");
+        InternedKey const b(std::string("interned_key_test"));
+        REQUIRE(a == b);
+        REQUIRE(a.c_str() == b.c_str());
+        REQUIRE(a.hash() == InternedKey::hash("interned_key_test"));
+        REQUIRE(InternedKey::poolSize() == size + 1);
+        REQUIRE(a != InternedKey("interned_key_test2"));
+    }
+
+    SECTION("released with the last key") {
+        auto const size = InternedKey::poolSize();
+        {
+            InternedKey const a("interned_key_release");
+            InternedKey const copy = a;
+            REQUIRE(InternedKey::poolSize() == size + 1);
+        }
+        REQUIRE(InternedKey::poolSize() == size);
+    }
+
+    SECTION("string comparison") {
+        InternedKey const key("abc");
+        REQUIRE(key == "abc");
+        REQUIRE("abc" == key);
+        REQUIRE(key == std::string("abc"));
+        REQUIRE(key != std::string_view("abd"));
+        REQUIRE(key.view() == "abc");
+        REQUIRE(key.size() == 3);
+        REQUIRE(InternedKey("abb") < key);
+    }
+
+    SECTION("empty") {
+        InternedKey const key;
+        REQUIRE(key.empty());
+        REQUIRE(key == InternedKey(""));
+        REQUIRE(std::string(key.c_str()).empty());
+        REQUIRE(key.hash() == InternedKey::hash(""));
+    }
+
+    SECTION("concurrent interning") {
+        auto const size = InternedKey::poolSize();
+        std::vector<std::vector<InternedKey>> keys(4);
+        std::vector<std::thread> threads;
+        for (auto& x : keys) {
+            threads.emplace_back([&x] {
+                for (int i = 0; i < 1000; ++i) {
+                    x.emplace_back("concurrent_key_" + std::to_string(i % 100));
+                    x.pop_back();
+                    x.emplace_back("concurrent_key_" + std::to_string(i % 100));
+                }
+            });
+        }
+        for (auto& x : threads) {
+            x.join();
+        }
+        REQUIRE(InternedKey::poolSize() == size + 100);
+        for (std::size_t i = 0; i < 1000; ++i) {
+            REQUIRE(keys[0][i] == keys[3][i]);
+            REQUIRE(keys[0][i].c_str() == keys[3][i].c_str());
+        }
+        keys.clear();
+        REQUIRE(InternedKey::poolSize() == size);
+    }
+
+    SECTION("ostream") {
+        std::ostringstream os;
+        os << InternedKey("abc");
+        REQUIRE(os.str() == "abc");
+    }
+}
@@ -0,0 +1,193 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <yenxo/exception.hpp>
+#include <yenxo/json_patch.hpp>
+#include <yenxo/variant.hpp>
+#include <yenxo/variant_traits.hpp>
+
+#include <catch2/catch_all.hpp>
+
+#include <boost/hana.hpp>
+
+#include <optional>
+#include <string>
+
+using namespace yenxo;
+
+namespace {
+
+struct Limits
+        : trait::Var<Limits>
+        , trait::UpdateFromVar<Limits> {
+    int connections;
+    int timeout;
+};
+
+struct Config
+        : trait::Var<Config>
+        , trait::UpdateFromVar<Config> {
+    std::string name;
+    Limits limits;
+    std::optional<std::string> proxy;
+};
+
+} // namespace
+
+BOOST_HANA_ADAPT_STRUCT(Limits, connections, timeout);
+BOOST_HANA_ADAPT_STRUCT(Config, name, limits, proxy);
+
+TEST_CASE("Check JSON Patch", "[json_patch]") {
+    auto const from = Variant::fromJson(R"({
+        "name": "a",
+        "list": [1, 2, 3],
+        "nested": {"x": 1, "y": [true]},
+        "same": {"deep": [{"k": "v"}]}
+    })");
+    auto const to = Variant::fromJson(R"({
+        "name": "b",
+        "list": [1, 5],
+        "nested": {"x": 1, "z": null},
+        "same": {"deep": [{"k": "v"}]},
+        "added": {"q": 1}
+    })");
+
+    SECTION("diff and apply") {
+        auto const patch = diff(from, to);
+        REQUIRE(patch.operations.size() == 6);
+        for (auto const& x : patch.operations) {
+            REQUIRE(x.path.toString().rfind("/same", 0) == std::string::npos);
+        }
+
+        auto target = from;
+        apply(target, patch);
+        REQUIRE(target == to);
+        REQUIRE(from != to);
+
+        REQUIRE(diff(to, to).operations.empty());
+
+        auto const variant = JsonPatch::toVariant(patch);
+        REQUIRE(variant.vec().size() == 6);
+        auto const parsed = JsonPatch::fromVariant(variant);
+        target = from;
+        apply(target, parsed);
+        REQUIRE(target == to);
+    }
+
+    SECTION("operations") {
+        auto target = Variant::fromJson(R"({"a": [1, 2], "b": {"c": 1}})");
+        apply(target, JsonPatch::fromVariant(Variant::fromJson(R"([
+            {"op": "test", "path": "/b/c", "value": 1.0},
+            {"op": "add", "path": "/a/1", "value": 9},
+            {"op": "add", "path": "/a/-", "value": 10},
+            {"op": "copy", "from": "/b", "path": "/d"},
+            {"op": "move", "from": "/b/c", "path": "/e"},
+            {"op": "remove", "path": "/a/0"},
+            {"op": "replace", "path": "/d/c", "value": "x"}
+        ])")));
+        REQUIRE(target
+                == Variant::fromJson(
+                        R"({"a": [9, 2, 10], "b": {}, "d": {"c": "x"}, "e": 1})"));
+    }
+
+    SECTION("failure leaves the target unchanged") {
+        auto target = from;
+        auto const patch = JsonPatch::fromVariant(Variant::fromJson(R"([
+            {"op": "remove", "path": "/name"},
+            {"op": "test", "path": "/list/0", "value": 2}
+        ])"));
+        try {
+            apply(target, patch);
+            FAIL("not thrown");
+        } catch (VariantErr const& e) {
+            REQUIRE(e.path() == "/list/0");
+        }
+        REQUIRE(target == from);
+
+        REQUIRE_THROWS_AS(apply(target,
+                                JsonPatch::fromVariant(Variant::fromJson(
+                                        R"([{"op": "remove", "path": "/missing"}])"))),
+                          VariantErr);
+        REQUIRE_THROWS_AS(apply(target,
+                                JsonPatch::fromVariant(Variant::fromJson(
+                                        R"([{"op": "move", "from": "/nested",
+                                             "path": "/nested/x"}])"))),
+                          VariantErr);
+
+        try {
+            JsonPatch::fromVariant(Variant::fromJson(R"([{"op": "add", "path": "/a"}])"));
+            FAIL("not thrown");
+        } catch (VariantErr const& e) {
+            REQUIRE(e.path() == "/0");
+        }
+    }
+}
+
+TEST_CASE("Check JSON Merge Patch", "[json_patch]") {
+    SECTION("mergeDiff and apply") {
+        auto const from =
+                Variant::fromJson(R"({"a": 1, "b": {"c": 2, "d": 3}, "e": [1]})");
+        auto const to =
+                Variant::fromJson(R"({"a": 1, "b": {"c": 4}, "e": [1, 2], "f": 5})");
+        auto const patch = mergeDiff(from, to);
+        REQUIRE(patch.value
+                == Variant::fromJson(
+                        R"({"b": {"c": 4, "d": null}, "e": [1, 2], "f": 5})"));
+
+        auto target = from;
+        apply(target, patch);
+        REQUIRE(target == to);
+
+        apply(target, mergeDiff(to, to));
+        REQUIRE(target == to);
+
+        apply(target, MergePatch{Variant("scalar")});
+        REQUIRE(target == Variant("scalar"));
+    }
+
+    SECTION("struct") {
+        Config config{{}, {}, "proxy", {{}, {}, 10, 30}, std::string("localhost")};
+        apply(config, MergePatch{Variant::fromJson(R"({
+            "limits": {"timeout": 60},
+            "proxy": "remote"
+        })")});
+        REQUIRE(config.name == "proxy");
+        REQUIRE(config.limits.connections == 10);
+        REQUIRE(config.limits.timeout == 60);
+        REQUIRE(config.proxy == "remote");
+
+        apply(config, MergePatch{Variant::fromJson(R"({"proxy": null})")});
+        REQUIRE(config.proxy == std::nullopt);
+        REQUIRE(config.name == "proxy");
+
+        // `updateVar` keeps converting a null like any other value
+        config.proxy = "remote";
+        REQUIRE_THROWS_AS(config.updateVar(Variant::fromJson(R"({"proxy": null})")),
+                          VariantErr);
+        REQUIRE(config.proxy == "remote");
+        auto const null_timeout = Variant::fromJson(R"({"limits": {"timeout": null}})");
+        REQUIRE_THROWS_AS(apply(config, MergePatch{null_timeout}), VariantErr);
+        REQUIRE(config.limits.timeout == 60);
+    }
+}
@@ -0,0 +1,118 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <yenxo/exception.hpp>
+#include <yenxo/json_pointer.hpp>
+#include <yenxo/variant.hpp>
+
+#include <catch2/catch_all.hpp>
+
+#include <stdexcept>
+#include <string>
+
+using namespace yenxo;
+
+TEST_CASE("Check JsonPointer", "[json_pointer]") {
+    SECTION("parse") {
+        REQUIRE(JsonPointer("").empty());
+        REQUIRE(JsonPointer("/").size() == 1);
+        REQUIRE(JsonPointer("/")[0].key.empty());
+
+        JsonPointer const p("/a~1b/m~0n/0/01/-");
+        REQUIRE(p.size() == 5);
+        REQUIRE(p[0].key == "a/b");
+        REQUIRE(p[1].key == "m~n");
+        REQUIRE(p[0].index == JsonPointer::Token::npos);
+        REQUIRE(p[2].index == 0);
+        REQUIRE(p[3].index == JsonPointer::Token::npos);
+        REQUIRE(p[4].index == JsonPointer::Token::npos);
+        REQUIRE(p.toString() == "/a~1b/m~0n/0/01/-");
+        REQUIRE(p == JsonPointer(p.toString()));
+        REQUIRE(p != JsonPointer("/a~1b"));
+
+        REQUIRE(JsonPointer().push_back("x/y").push_back("1").toString() == "/x~1y/1");
+        InternedKey const key("2");
+        REQUIRE(JsonPointer().push_back(key)[0].key.view().data() == key.view().data());
+        REQUIRE(JsonPointer().push_back(key)[0].index == 2);
+        REQUIRE(JsonPointer().push_back(std::size_t{1}) == JsonPointer("/1"));
+        REQUIRE(JsonPointer().push_back(std::size_t{1})[0].index == 1);
+        REQUIRE(JsonPointer().push_back(std::size_t{12345}).toString() == "/12345");
+        REQUIRE(JsonPointer().push_back(std::size_t{12345})[0].index == 12345);
+
+        REQUIRE_THROWS_AS(JsonPointer("a"), std::invalid_argument);
+        REQUIRE_THROWS_AS(JsonPointer("/a~2"), std::invalid_argument);
+        REQUIRE_THROWS_AS(JsonPointer("/a~"), std::invalid_argument);
+    }
+
+    Variant const doc = Variant::fromJson(R"({
+        "servers": [{"host": "a", "port": 1}, {"host": "b", "port": 2}],
+        "numbers": [1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16],
+        "a/b": {"m~n": true},
+        "": 0,
+        "0": "key"
+    })");
+
+    SECTION("find") {
+        REQUIRE(doc.find(JsonPointer("")) == &doc);
+        REQUIRE(doc.find(JsonPointer("/servers/1/host"))->strView() == "b");
+        REQUIRE(doc.find(JsonPointer("/numbers/15"))->int64() == 16);
+        REQUIRE(doc.find(JsonPointer("/a~1b/m~0n"))->boolean());
+        REQUIRE(doc.find(JsonPointer("/"))->int64() == 0);
+        REQUIRE(doc.find(JsonPointer("/0"))->strView() == "key");
+
+        REQUIRE(doc.find(JsonPointer("/servers/2")) == nullptr);
+        REQUIRE(doc.find(JsonPointer("/servers/-")) == nullptr);
+        REQUIRE(doc.find(JsonPointer("/servers/01")) == nullptr);
+        REQUIRE(doc.find(JsonPointer("/servers/host")) == nullptr);
+        REQUIRE(doc.find(JsonPointer("/servers/0/host/x")) == nullptr);
+        REQUIRE(doc.find(JsonPointer("/missing")) == nullptr);
+    }
+
+    SECTION("at") {
+        JsonPointer const port("/servers/0/port");
+        REQUIRE(doc.at(port).int64() == 1);
+
+        try {
+            doc.at(JsonPointer("/servers/0/user/name"));
+            FAIL("not thrown");
+        } catch (VariantErr const& e) {
+            REQUIRE(e.path() == "/servers/0/user");
+        }
+    }
+
+    SECTION("modification is not visible in copies") {
+        Variant copy = doc;
+        JsonPointer const port("/servers/0/port");
+        copy.at(port) = 8080;
+        REQUIRE(copy.at(port).int64() == 8080);
+        REQUIRE(doc.at(port).int64() == 1);
+
+        *copy.find(JsonPointer("/numbers/0")) = "one";
+        REQUIRE(copy.at(JsonPointer("/numbers/0")).strView() == "one");
+        REQUIRE(doc.at(JsonPointer("/numbers/0")).int64() == 1);
+
+        REQUIRE(copy.find(JsonPointer("/missing/0")) == nullptr);
+        REQUIRE_THROWS_AS(copy.at(JsonPointer("/servers/9")), VariantErr);
+    }
+}
@@ -0,0 +1,96 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <yenxo/json_sink.hpp>
+#include <yenxo/variant.hpp>
+
+#include <catch2/catch_all.hpp>
+
+#include <cstdio>
+#include <sstream>
+#include <string>
+#include <system_error>
+
+using namespace yenxo;
+
+namespace {
+
+Variant document() {
+    Variant::Vec vec;
+    for (int i = 0; i < 1000; ++i) {
+        vec.emplace_back(Variant::Map{{"id", Variant(i)}, {"name", Variant("item")}});
+    }
+    return Variant(std::move(vec));
+}
+
+} // namespace
+
+TEST_CASE("Check JSON sinks", "[json_sink]") {
+    auto const var = document();
+    auto const json = var.toJson();
+
+    SECTION("ostream") {
+        std::ostringstream os;
+        OstreamSink sink(os);
+        var.toJson(sink);
+        REQUIRE(os.str() == json);
+
+        os.str({});
+        var.toPrettyJson(sink);
+        REQUIRE(os.str() == var.toPrettyJson());
+    }
+
+    SECTION("callback") {
+        std::string text;
+        std::size_t chunks = 0;
+        CallbackSink sink([&](std::string_view chunk) {
+            REQUIRE(chunk.size() <= 4096);
+            text += chunk;
+            ++chunks;
+        });
+        var.toJson(sink);
+        REQUIRE(text == json);
+        REQUIRE(chunks == (json.size() + 4095) / 4096);
+
+        text.clear();
+        Variant("abc").toJson(sink);
+        REQUIRE(text == R"("abc")");
+    }
+
+    SECTION("file descriptor") {
+        auto const file = std::tmpfile();
+        REQUIRE(file);
+        FdSink sink(fileno(file));
+        var.toJson(sink);
+
+        std::string text(json.size() + 1, '\0');
+        std::rewind(file);
+        text.resize(std::fread(text.data(), 1, text.size(), file));
+        std::fclose(file);
+        REQUIRE(text == json);
+
+        FdSink bad(-1);
+        REQUIRE_THROWS_AS(Variant(1).toJson(bad), std::system_error);
+    }
+}
@@ -0,0 +1,113 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#include <yenxo/mapped_file.hpp>
+#include <yenxo/variant.hpp>
+#include <yenxo/variant_arena.hpp>
+
+#include <catch2/catch_all.hpp>
+
+#include <cstdio>
+#include <cstdlib>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+
+#include <unistd.h>
+
+using namespace yenxo;
+
+namespace {
+
+/// Temporary file holding `text`, removed on destruction
+struct TempFile {
+    explicit TempFile(std::string const& text) {
+        auto const fd = ::mkstemp(path.data());
+        REQUIRE(fd >= 0);
+        REQUIRE(::write(fd, text.data(), text.size())
+                == static_cast<ssize_t>(text.size()));
+        ::close(fd);
+    }
+
+    ~TempFile() {
+        std::remove(path.c_str());
+    }
+
+    std::string path = "/tmp/yenxo_mapped_file_XXXXXX";
+};
+
+} // namespace
+
+TEST_CASE("Check MappedFile", "[mapped_file]") {
+    std::string const json = R"({"name": "a string not stored inline", "list": [1, 2]})";
+    TempFile const tmp(json);
+
+    SECTION("mapping") {
+        MappedFile file(tmp.path);
+        REQUIRE(file.view() == json);
+        REQUIRE(file.path() == tmp.path);
+
+        auto moved = std::move(file);
+        REQUIRE(moved.view() == json);
+        REQUIRE(file.data() == nullptr);
+        REQUIRE(file.size() == 0);
+
+        TempFile const empty("");
+        REQUIRE(MappedFile(empty.path).view().empty());
+
+        REQUIRE_THROWS_AS(MappedFile("/nonexistent/file.json"), std::system_error);
+    }
+
+    SECTION("backing a tree") {
+        MappedFile const file(tmp.path);
+        auto const var = Variant::fromJsonView(file.view());
+        auto const data = var.map().at("name").strView().data();
+        REQUIRE(data >= file.data());
+        REQUIRE(data < file.data() + file.size());
+        REQUIRE(var == Variant::fromJson(json));
+    }
+
+    SECTION("fromJsonFile") {
+        REQUIRE(Variant::fromJsonFile(tmp.path) == Variant::fromJson(json));
+
+        VariantArena arena;
+        REQUIRE(Variant::fromJsonFile(tmp.path, arena) == Variant::fromJson(json));
+
+        REQUIRE_THROWS_AS(Variant::fromJsonFile("/nonexistent/file.json"),
+                          std::system_error);
+    }
+
+    SECTION("error position") {
+        TempFile const bad("{\n  \"a\": 1,\n  \"b\": x\n}");
+        try {
+            Variant::fromJsonFile(bad.path);
+            FAIL("not thrown");
+        } catch (std::runtime_error const& e) {
+            std::string const what = e.what();
+            REQUIRE(what.rfind(bad.path + ":3:8: ", 0) == 0);
+            REQUIRE(what.find("(offset 19)") != std::string::npos);
+        }
+    }
+}
@@ -0,0 +1,138 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+
+#include <yenxo/exception.hpp>
+#include <yenxo/json_sink.hpp>
+#include <yenxo/ndjson.hpp>
+#include <yenxo/variant.hpp>
+#include <yenxo/variant_traits.hpp>
+
+#include <catch2/catch_all.hpp>
+
+#include <boost/hana.hpp>
+
+#include <algorithm>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+using namespace yenxo;
+
+namespace {
+
+struct Entry : trait::Var<Entry> {
+    int id;
+    std::string name;
+};
+
+bool operator==(Entry const& lhs, Entry const& rhs) {
+    return lhs.id == rhs.id && lhs.name == rhs.name;
+}
+
+std::string records(int n) {
+    std::string ret;
+    for (int i = 0; i < n; ++i) {
+        ret += R"({"id": )" + std::to_string(i) + R"(, "name": "entry"})";
+        // blank lines and CRLF are accepted
+        ret += i % 10 == 0 ? "\r\n\n" : "\n";
+    }
+    return ret;
+}
+
+} // namespace
+
+BOOST_HANA_ADAPT_STRUCT(Entry, id, name);
+
+TEST_CASE("Check NDJSON", "[ndjson]") {
+    auto const text = records(1000);
+    NdjsonOptions options;
+    options.threads = 4;
+    options.chunk_size = GENERATE(1, 100, 1 << 20);
+
+    SECTION("in order") {
+        std::vector<Variant> vars;
+        readNdjson(text, [&](Variant&& x) { vars.push_back(std::move(x)); }, options);
+        REQUIRE(vars.size() == 1000);
+        for (unsigned i = 0; i < 1000; ++i) {
+            // JSON non-negative integers are parsed as `uint32`
+            REQUIRE(vars[i] == Variant(Variant::Map{{"id", Variant(i)},
+                                                    {"name", Variant("entry")}}));
+        }
+
+        std::istringstream is(text);
+        std::vector<Entry> entries;
+        readNdjson<Entry>(
+                is, [&](Entry&& x) { entries.push_back(std::move(x)); }, options);
+        REQUIRE(entries.size() == 1000);
+        for (int i = 0; i < 1000; ++i) {
+            REQUIRE(entries[i] == Entry{{}, i, "entry"});
+        }
+    }
+
+    SECTION("unordered") {
+        options.order = NdjsonOrder::completion;
+        std::vector<int> ids;
+        readNdjson<Entry>(text, [&](Entry&& x) { ids.push_back(x.id); }, options);
+        std::sort(ids.begin(), ids.end());
+        REQUIRE(ids.size() == 1000);
+        for (int i = 0; i < 1000; ++i) {
+            REQUIRE(ids[i] == i);
+        }
+    }
+
+    SECTION("write") {
+        std::vector<Entry> entries;
+        for (int i = 0; i < 1000; ++i) {
+            entries.push_back({{}, i, "entry"});
+        }
+        options.batch_size = 7;
+        std::ostringstream os;
+        OstreamSink sink(os);
+        writeNdjson(entries, sink, options);
+
+        std::vector<Entry> ret;
+        readNdjson<Entry>(os.str(), [&](Entry&& x) { ret.push_back(std::move(x)); });
+        REQUIRE(ret == entries);
+    }
+
+    SECTION("errors") {
+        auto const bad = text + "{\"id\": }\n";
+        try {
+            readNdjson(bad, [](Variant&&) {}, options);
+            FAIL("not thrown");
+        } catch (std::runtime_error const& e) {
+            REQUIRE(std::string(e.what()).rfind("line 1101: ", 0) == 0);
+        }
+
+        try {
+            readNdjson<Entry>(text + R"({"id": "x", "name": "entry"})",
+                              [](Entry&&) {}, options);
+            FAIL("not thrown");
+        } catch (VariantErr const& e) {
+            REQUIRE(e.path() == "/1101/id");
+        }
+    }
+}
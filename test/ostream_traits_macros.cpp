@@ -61,8 +61,8 @@ TEST_CASE("Check YENXO_JSON_OSTREAM_OPERATOR", "[ostream_traits]") {
     std::ostringstream os;
     os << x;
     REQUIRE(os.str() == R"({
-    "y": 1,
-    "x": "1"
+    "x": "1",
+    "y": 1
 })");
 }
 
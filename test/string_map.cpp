@@ -0,0 +1,177 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <yenxo/string_map.hpp>
+
+#include <catch2/catch_all.hpp>
+
+#include <functional>
+#include <string>
+
+using namespace yenxo;
+
+TEST_CASE("Check StringMap", "[string_map]") {
+    SECTION("lookup") {
+        StringMap<int> map{{"a", 1}, {"b", 2}, {"a", 3}};
+        REQUIRE(map.size() == 2);
+        REQUIRE(map.at("a") == 1);
+        REQUIRE(map.at(std::string("b")) == 2);
+        REQUIRE(map.find(std::string_view("c")) == map.end());
+        REQUIRE(map.count("b") == 1);
+        REQUIRE_THROWS_AS(map.at("c"), std::out_of_range);
+        map["c"] = 3;
+        REQUIRE(map.at("c") == 3);
+    }
+
+    SECTION("insertion order") {
+        StringMap<int> map;
+        map.emplace("z", 1);
+        map.try_emplace("y", 2);
+        map.insert({"x", 3});
+        std::string keys;
+        for (auto const& [key, value] : map) {
+            keys += key;
+        }
+        REQUIRE(keys == "zyx");
+    }
+
+    SECTION("large map") {
+        StringMap<int> map;
+        int const n = 1000;
+        for (int i = 0; i < n; ++i) {
+            REQUIRE(map.emplace(std::to_string(i), i).second);
+        }
+        REQUIRE(!map.emplace("10", 0).second);
+        REQUIRE(map.size() == n);
+        for (int i = 0; i < n; ++i) {
+            REQUIRE(map.at(std::to_string(i)) == i);
+        }
+        for (int i = 0; i < n; i += 2) {
+            REQUIRE(map.erase(std::to_string(i)) == 1);
+        }
+        REQUIRE(map.size() == n / 2);
+        for (int i = 0; i < n; ++i) {
+            REQUIRE(map.count(std::to_string(i)) == static_cast<size_t>(i % 2));
+        }
+    }
+
+    SECTION("reserve") {
+        StringMap<int> map;
+        map.reserve(100);
+        REQUIRE(map.capacity() >= 100);
+        REQUIRE(map.bucket_count() > 0);
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(map.emplace(std::to_string(i), i).second);
+        }
+        REQUIRE(map.size() == 100);
+        for (int i = 0; i < 100; ++i) {
+            REQUIRE(map.at(std::to_string(i)) == i);
+        }
+    }
+
+    SECTION("reserve then find") {
+        StringMap<int> map;
+        map.reserve(100);
+        map.emplace("a", 1);
+        map["b"] = 2;
+        REQUIRE(map.find("a") != map.end());
+        REQUIRE(map.at("b") == 2);
+        REQUIRE(map.count(InternedKey("a")) == 1);
+        REQUIRE(map.find("c") == map.end());
+    }
+
+    SECTION("reserve then duplicate") {
+        StringMap<int> map;
+        map.reserve(100);
+        REQUIRE(map.emplace("a", 1).second);
+        REQUIRE(!map.emplace("a", 2).second);
+        REQUIRE(!map.try_emplace("a", 3).second);
+        map["a"] = 4;
+        REQUIRE(map.size() == 1);
+        REQUIRE(map.at("a") == 4);
+    }
+
+    SECTION("erase keeps the index") {
+        StringMap<int> map;
+        int const n = 200;
+        for (int i = 0; i < n; ++i) {
+            map.emplace(std::to_string(i), i);
+        }
+        auto const buckets = map.bucket_count();
+        // from the middle, the front and the back
+        for (int i : {100, 0, n - 1, 50, 51, 49}) {
+            REQUIRE(map.erase(std::to_string(i)) == 1);
+        }
+        REQUIRE(map.bucket_count() == buckets);
+        REQUIRE(map.size() == n - 6);
+        for (int i = 0; i < n; ++i) {
+            auto const erased = i == 100 || i == 0 || i == n - 1 || (i >= 49 && i <= 51);
+            REQUIRE(map.count(std::to_string(i)) == (erased ? 0u : 1u));
+            if (!erased) {
+                REQUIRE(map.at(std::to_string(i)) == i);
+            }
+        }
+        REQUIRE(map.begin()->second == 1);
+        REQUIRE(map.emplace("0", 0).second);
+        REQUIRE(!map.emplace("1", 0).second);
+        REQUIRE((map.end() - 1)->first == "0");
+    }
+
+    SECTION("equality ignores order") {
+        StringMap<int> const a{{"a", 1}, {"b", 2}};
+        StringMap<int> const b{{"b", 2}, {"a", 1}};
+        StringMap<int> const c{{"b", 2}, {"a", 2}};
+        REQUIRE(a == b);
+        REQUIRE(a != c);
+    }
+
+    SECTION("equal with a predicate") {
+        StringMap<int> a;
+        StringMap<int> b;
+        for (int i = 0; i < 100; ++i) {
+            a.emplace(std::to_string(i), i);
+        }
+        for (int i = 100; i-- > 0;) {
+            b.emplace(std::to_string(i), -i);
+        }
+        auto const negated = [](int lhs, int rhs) { return lhs == -rhs; };
+        REQUIRE(a.equal(b, negated));
+        REQUIRE(!a.equal(b, std::equal_to<>()));
+        b.erase("42");
+        b.emplace("x", -42);
+        REQUIRE(!a.equal(b, negated));
+        REQUIRE(!a.equal(StringMap<int>(), negated));
+    }
+
+    SECTION("interned key lookup") {
+        StringMap<int> map{{"a", 1}, {"b", 2}};
+        InternedKey const key("b");
+        REQUIRE(map.find(key)->first.c_str() == key.c_str());
+        REQUIRE(map.at(key) == 2);
+        map[key] = 3;
+        REQUIRE(map.at("b") == 3);
+        REQUIRE(map.erase(key) == 1);
+        REQUIRE(map.count(key) == 0);
+    }
+}
@@ -25,6 +25,7 @@
 #include <yenxo/exception.hpp>
 #include <yenxo/type_name.hpp>
 #include <yenxo/variant.hpp>
+#include <yenxo/variant_arena.hpp>
 
 #include <catch2/catch_all.hpp>
 
@@ -32,8 +33,13 @@
 
 #include <boost/hana.hpp>
 
+#include <algorithm>
 #include <limits.h>
+#include <limits>
 #include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_set>
 
 namespace hana = boost::hana;
 
@@ -148,12 +154,54 @@ TEST_CASE("Check Variant", "[Variant]") {
     SECTION("string") {
         std::string const expected = "ab";
         auto const x = Variant(expected);
-        REQUIRE(expected == x.str());
-        REQUIRE_THROWS_AS(Variant().str(), VariantEmpty);
-        REQUIRE_THROWS_AS(Variant(5).str(), VariantBadType);
+        REQUIRE(expected == x.strView());
+        REQUIRE_THROWS_AS(Variant().strView(), VariantEmpty);
+        REQUIRE_THROWS_AS(Variant(5).strView(), VariantBadType);
         REQUIRE(Variant().strOr("abc") == "abc");
     }
 
+    SECTION("short and long string") {
+        std::string const short_str = "abcdefghijklm";
+        std::string const long_str = "abcdefghijklmn";
+        Variant const a(short_str);
+        Variant const b(long_str);
+        REQUIRE(a.strView() == short_str);
+        REQUIRE(b.strView() == long_str);
+        REQUIRE(a != b);
+
+        Variant c = a;
+        Variant d = b;
+        REQUIRE(c == a);
+        REQUIRE(d == b);
+
+        c = std::move(d);
+        REQUIRE(c.strView() == long_str);
+
+        REQUIRE(Variant::fromJson(R"(["abc", "abcdefghijklmnopqrstuvwxyz"])")
+                == Variant(Variant::Vec{Variant("abc"),
+                                        Variant("abcdefghijklmnopqrstuvwxyz")}));
+        REQUIRE(Variant("abc").toJson() == R"("abc")");
+    }
+
+    SECTION("str is a copy") {
+#if defined(__GNUG__) || defined(__clang__)
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wdeprecated-declarations"
+#endif
+        std::string const json = R"(["abc", "a string not stored inline"])";
+        auto const view = Variant::fromJsonView(json);
+        REQUIRE(view.vec()[0].str() == "abc");
+        REQUIRE(view.vec()[1].str() == "a string not stored inline");
+        REQUIRE(view.vec()[1].str().data() != json.data() + 9);
+        REQUIRE(view.vec()[1].strView().data() == json.data() + 9);
+        REQUIRE_THROWS_AS(Variant().str(), VariantEmpty);
+#if defined(__GNUG__) || defined(__clang__)
+#pragma GCC diagnostic pop
+#endif
+        REQUIRE(static_cast<std::string>(view.vec()[0]) == "abc");
+        REQUIRE(static_cast<std::string_view>(view.vec()[0]) == "abc");
+    }
+
     SECTION("string_view") {
         std::string_view const sv = "ab";
         std::string const s = static_cast<std::string>(sv);
@@ -273,6 +321,30 @@ TEST_CASE("Check Variant", "[Variant]") {
         });
     }
 
+    SECTION("copy on write") {
+        Variant const original(VariantMap{
+                {"list", Variant(VariantVec{Variant(1), Variant("a string not stored inline")})},
+                {"nested", Variant(VariantMap{{"x", Variant(1)}})}});
+
+        Variant copy = original;
+        REQUIRE(&copy.map() == &original.map());
+        REQUIRE(copy.map().at("list").vec()[1].strView().data()
+                == original.map().at("list").vec()[1].strView().data());
+
+        copy.modifyMap().at("nested").modifyMap()["y"] = Variant(2);
+        REQUIRE(&copy.map() != &original.map());
+        REQUIRE(&copy.map().at("list").vec() == &original.map().at("list").vec());
+        REQUIRE(original.map().at("nested") == Variant(VariantMap{{"x", Variant(1)}}));
+        REQUIRE(copy.map().at("nested")
+                == Variant(VariantMap{{"x", Variant(1)}, {"y", Variant(2)}}));
+
+        auto const& vec = copy.map().at("list").vec();
+        copy.modifyMap().at("list").modifyVec().push_back(Variant(3));
+        REQUIRE(original.map().at("list").vec().size() == 2);
+        REQUIRE(copy.map().at("list").vec().size() == 3);
+        REQUIRE(&vec == &original.map().at("list").vec());
+    }
+
     SECTION("representable integral type conversions") {
         auto const from = hana::tuple_t<char,
                                         int8_t,
@@ -433,6 +505,23 @@ TEST_CASE("Check Variant", "[Variant]") {
         REQUIRE(Variant(VariantVec{}) == Variant(VariantVec{}));
     }
 
+    SECTION("compare NaN") {
+        auto const nan = std::numeric_limits<double>::quiet_NaN();
+        REQUIRE(Variant(nan) != Variant(nan));
+
+        // copies sharing a container are identical, separately built trees are compared
+        Variant const tree(VariantMap{{"x", Variant(VariantVec{Variant(nan)})}});
+        Variant const copy = tree;
+        REQUIRE(copy == tree);
+        REQUIRE(copy.map().at("x") == tree.map().at("x"));
+        REQUIRE(Variant(VariantMap{{"x", Variant(VariantVec{Variant(nan)})}}) != tree);
+
+        Variant const packed(Variant::DoubleVec{nan, 1.0});
+        REQUIRE(packed.packedType() == Variant::TypeTag::double_vec);
+        REQUIRE(Variant(packed) == packed);
+        REQUIRE(Variant(Variant::DoubleVec{nan, 1.0}) != packed);
+    }
+
     SECTION("from JSON") {
         SECTION("int") {
             auto const raw = R"(5)";
@@ -601,6 +690,257 @@ TEST_CASE("Check Variant", "[Variant]") {
                 == Variant(Variant::Vec{Variant(Variant::Map{{"abc", Variant(1)}})}));
     }
 
+    SECTION("From JSON view") {
+        std::string json = R"({"name": "a string not stored inline", "short": "abc",)"
+                           R"( "escaped": "a \"quoted\" string not stored inline",)"
+                           R"( "list": ["another string not stored inline", 1]})";
+        auto const expected = Variant(VariantMap{
+                {"name", Variant("a string not stored inline")},
+                {"short", Variant("abc")},
+                {"escaped", Variant("a \"quoted\" string not stored inline")},
+                {"list", Variant(VariantVec{Variant("another string not stored inline"),
+                                            Variant(1u)})}});
+
+        auto const borrowed = [&](Variant const& x) {
+            auto const data = x.strView().data();
+            return data >= json.data() && data < json.data() + json.size();
+        };
+
+        auto var = Variant::fromJsonView(json);
+        REQUIRE(var == expected);
+        REQUIRE(var.map().at("name").strView().data() == json.data() + 10);
+        REQUIRE(borrowed(var.map().at("list").vec()[0]));
+        REQUIRE_FALSE(borrowed(var.map().at("escaped")));
+
+        auto const copy = var;
+        REQUIRE(borrowed(copy.map().at("name")));
+        var.materialize();
+        REQUIRE(&var.map() != &copy.map());
+        REQUIRE_FALSE(borrowed(var.map().at("name")));
+        REQUIRE_FALSE(borrowed(var.map().at("list").vec()[0]));
+        std::fill(json.begin(), json.end(), ' ');
+        REQUIRE(var == expected);
+
+        VariantArena arena;
+        json = R"(["a string not stored inline"])";
+        auto const in_arena = Variant::fromJsonView(json, arena);
+        REQUIRE(in_arena.vec()[0].strView().data() == json.data() + 2);
+
+        REQUIRE_THROWS_AS(Variant::fromJsonView(std::string_view(json).substr(0, 5)),
+                          std::runtime_error);
+    }
+
+    SECTION("From JSON in place") {
+        std::string const json = R"({"name": "a string not stored inline",)"
+                                 R"( "escaped": "a \"quoted\" string not stored inline",)"
+                                 R"( "short": "a\tb", "list": [1, "x"]})";
+        auto const expected = Variant(VariantMap{
+                {"name", Variant("a string not stored inline")},
+                {"escaped", Variant("a \"quoted\" string not stored inline")},
+                {"short", Variant("a\tb")},
+                {"list", Variant(VariantVec{Variant(1u), Variant("x")})}});
+
+        REQUIRE(Variant::fromJson(std::string(json)) == expected);
+        REQUIRE(Variant::fromJson(std::string_view(json)) == expected);
+        REQUIRE(Variant::fromJson(json.c_str()) == expected);
+        REQUIRE(Variant::fromJson(std::string_view("[1] trailing", 3))
+                == Variant(VariantVec{Variant(1u)}));
+
+        // no terminating NUL after the parsed range
+        std::string buf = json + "garbage";
+        auto const borrowed = [&](Variant const& x) {
+            auto const data = x.strView().data();
+            return data >= buf.data() && data < buf.data() + buf.size();
+        };
+        auto var = Variant::fromJsonInsitu(buf.data(), json.size());
+        REQUIRE(var == expected);
+        REQUIRE(borrowed(var.map().at("name")));
+        REQUIRE(borrowed(var.map().at("escaped")));
+        REQUIRE_FALSE(borrowed(var.map().at("short")));
+        var.materialize();
+        std::fill(buf.begin(), buf.end(), ' ');
+        REQUIRE(var == expected);
+
+        VariantArena arena;
+        buf = R"(["a string not stored inline"])";
+        auto const in_arena = Variant::fromJsonInsitu(buf.data(), buf.size(), arena);
+        REQUIRE(in_arena.vec()[0].strView().data() == buf.data() + 2);
+
+        buf = R"(["unterminated)";
+        REQUIRE_THROWS_AS(Variant::fromJsonInsitu(buf.data(), buf.size()),
+                          std::runtime_error);
+        REQUIRE_THROWS_AS(Variant::fromJson(std::string_view("[1]", 2)),
+                          std::runtime_error);
+    }
+
+    SECTION("Packed arrays") {
+        auto const json = [](std::string const& x, std::size_t n) {
+            std::string ret = "[";
+            for (std::size_t i = 0; i < n; ++i) {
+                ret += (i == 0 ? "" : ",") + x;
+            }
+            return ret + "]";
+        };
+        constexpr std::size_t n = YENXO_PACKED_MIN_SIZE;
+
+        REQUIRE_FALSE(Variant::fromJson(json("1", n - 1)).isPacked());
+        REQUIRE(Variant::fromJson(json("1", n)).type() == Variant::TypeTag::vec);
+        REQUIRE(Variant::fromJson(json("1", n)).packedType()
+                == Variant::TypeTag::int64_vec);
+        REQUIRE(Variant::fromJson(json("-1", n)).packedType()
+                == Variant::TypeTag::int64_vec);
+        REQUIRE(Variant::fromJson(json("1.5", n)).packedType()
+                == Variant::TypeTag::double_vec);
+        REQUIRE(Variant::fromJson(json("true", n)).packedType()
+                == Variant::TypeTag::bool_vec);
+        REQUIRE(Variant::fromJson(json("18446744073709551615", n)).packedType()
+                == Variant::TypeTag::uint64_vec);
+        REQUIRE(Variant::fromJson("[" + json("1", n) + "]").vec()[0].packedType()
+                == Variant::TypeTag::int64_vec);
+        REQUIRE(Variant::fromJson("[1.5," + json("1", n).substr(1)).packedType()
+                == Variant::TypeTag::vec);
+        REQUIRE(Variant::fromJson("[-1," + json("1", n).substr(1)).packedType()
+                == Variant::TypeTag::vec);
+        REQUIRE(Variant::fromJson("[true," + json("1", n).substr(1)).packedType()
+                == Variant::TypeTag::vec);
+        REQUIRE(Variant::fromJson("[null," + json("1", n).substr(1)).packedType()
+                == Variant::TypeTag::vec);
+        REQUIRE(Variant::fromJson("[-1," + json("18446744073709551615", n).substr(1))
+                        .packedType()
+                == Variant::TypeTag::vec);
+
+        auto const var = Variant::fromJson(json("1.5", n));
+        REQUIRE(var.doubleVec() == Variant::DoubleVec(n, 1.5));
+        REQUIRE_THROWS_AS(var.int64Vec(), VariantBadType);
+        REQUIRE_THROWS_AS(var.map(), VariantBadType);
+        REQUIRE_THROWS_AS(var.floating(), VariantBadType);
+        REQUIRE(var.isVec());
+        REQUIRE_FALSE(var.isScalar());
+        REQUIRE(var.toJson() == json("1.5", n));
+        REQUIRE(var.typeInfo() == typeid(Variant::Vec));
+
+        auto const& vec = var.vec();
+        REQUIRE(vec == Variant::Vec(n, Variant(1.5)));
+        REQUIRE(&var.vec() == &vec);
+        REQUIRE(equal(var, Variant(vec)));
+        REQUIRE(var == Variant(vec));
+        REQUIRE(Variant(vec) == var);
+        REQUIRE(var.hash() == Variant(vec).hash());
+        REQUIRE(var == Variant(Variant::DoubleVec(n, 1.5)));
+        REQUIRE(var != Variant(Variant::Vec(n, Variant(2.5))));
+        REQUIRE(var != Variant(Variant::Vec(n - 1, Variant(1.5))));
+        REQUIRE(var != Variant(Variant::Vec(n, Variant(1))));
+
+        auto const uints = Variant::fromJson(json("1", n));
+        REQUIRE(uints.vec()[0].type() == Variant::TypeTag::uint32);
+        REQUIRE(uints == Variant(Variant::Vec(n, Variant(1u))));
+        REQUIRE(uints.hash() == Variant(Variant::Vec(n, Variant(1u))).hash());
+        REQUIRE(uints != Variant(Variant::Vec(n, Variant(1))));
+        REQUIRE(uints != Variant(Variant::Int64Vec(n, 1)));
+        REQUIRE(uints == Variant(Variant::Int64Vec(n, 1), Variant::TypeTag::uint32));
+        REQUIRE(Variant::fromJson(json("-1", n)).vec()[0].type()
+                == Variant::TypeTag::int32);
+        REQUIRE_FALSE(equal(var, Variant::fromJson(json("2.5", n))));
+
+        auto copy = var;
+        copy.modifyVec().push_back(Variant(2));
+        REQUIRE_FALSE(copy.isPacked());
+        REQUIRE(copy.vec().size() == n + 1);
+        REQUIRE(var.packedType() == Variant::TypeTag::double_vec);
+
+        REQUIRE(var.vecAs<double>() == std::vector<double>(n, 1.5));
+        REQUIRE_THROWS_AS(var.vecAs<int32_t>(), VariantIntegralOverflow);
+        auto const ints = Variant(Variant::Int64Vec{1, 2, 300});
+        REQUIRE(ints.vecAs<int16_t>() == std::vector<int16_t>{1, 2, 300});
+        REQUIRE(Variant(ints.vec()).vecAs<int16_t>() == std::vector<int16_t>{1, 2, 300});
+        REQUIRE_THROWS_AS(ints.vecAs<bool>(), VariantBadType);
+        try {
+            ints.vecAs<uint8_t>();
+            FAIL();
+        } catch (VariantErr const& e) {
+            REQUIRE(e.path() == "/2");
+        }
+
+        std::ostringstream os;
+        os << Variant(Variant::BoolVec{true, false}) << ' '
+           << Variant(Variant::Int64Vec{'a', 'b'}, Variant::TypeTag::char_);
+        REQUIRE(os.str() == "[ 1, 0 ] [ a, b ]");
+
+        // `doubleVec()` above keeps the values of `var`, `vec()` frees the unused ones
+        auto const unpacked = Variant::fromJson(json("1.5", n));
+        auto const shared = unpacked;
+        REQUIRE(unpacked.vec() == vec);
+        REQUIRE(unpacked.type() == Variant::TypeTag::vec);
+        REQUIRE(shared.packedType() == Variant::TypeTag::vec);
+        REQUIRE_THROWS_AS(shared.doubleVec(), VariantBadType);
+        REQUIRE(shared.vecAs<double>() == std::vector<double>(n, 1.5));
+        REQUIRE(shared.toJson() == json("1.5", n));
+        REQUIRE(shared == var);
+        REQUIRE(shared.hash() == var.hash());
+        REQUIRE(var.packedType() == Variant::TypeTag::double_vec);
+        REQUIRE(&var.doubleVec() == &var.doubleVec());
+
+        // copies share the values, `vec()` of one frees them while the others read them
+        auto const parallel = Variant::fromJson(json("1", n));
+        std::vector<std::thread> threads;
+        std::vector<char> same(4);
+        for (std::size_t i = 0; i < same.size(); ++i) {
+            threads.emplace_back([copy = parallel, &same, i, expected = json("1", n)] {
+                same[i] = i == 0 ? copy.vec().size() == n : copy.toJson() == expected;
+            });
+        }
+        for (auto& x : threads) {
+            x.join();
+        }
+        REQUIRE(same == std::vector<char>(same.size(), true));
+
+        VariantArena arena;
+        auto const in_arena = Variant::fromJson(json("-1", n), arena);
+        REQUIRE(in_arena.int64Vec() == Variant::Int64Vec(n, -1));
+        auto const heap = in_arena;
+        REQUIRE(heap == in_arena);
+        REQUIRE(&heap.int64Vec() != &in_arena.int64Vec());
+    }
+
+    SECTION("hash") {
+        auto const json = R"({"a": [1, "a string not stored inline", {"b": null}],)"
+                          R"( "c": 2.5, "d": true})";
+        auto const var = Variant::fromJson(json);
+        REQUIRE(var.hash() == Variant::fromJson(json).hash());
+        auto const reordered = R"({"d": true, "c": 2.5,)"
+                               R"( "a": [1, "a string not stored inline", {"b": null}]})";
+        REQUIRE(var.hash() == Variant::fromJson(reordered).hash());
+        REQUIRE(var.hash()
+                != Variant::fromJson(R"({"a": [1], "c": 2.5, "d": true})").hash());
+        REQUIRE(Variant(0.0).hash() == Variant(-0.0).hash());
+        REQUIRE(Variant(1).hash() != Variant(2).hash());
+        REQUIRE(Variant(VariantVec{Variant(1), Variant(2)}).hash()
+                != Variant(VariantVec{Variant(2), Variant(1)}).hash());
+        REQUIRE(Variant(Variant::Int64Vec{1, 2}).hash()
+                == Variant(Variant::Int64Vec{1, 2}).hash());
+
+        VariantArena arena;
+        auto const in_arena = Variant::fromJson(json, arena);
+        REQUIRE(in_arena.hash() == var.hash());
+        REQUIRE(Variant(in_arena).hash() == var.hash());
+
+        auto copy = var;
+        REQUIRE(copy.hash() == var.hash());
+        copy.modifyMap()["c"] = Variant(3.5);
+        REQUIRE(copy.hash() != var.hash());
+        REQUIRE(copy != var);
+        copy.modifyMap()["c"] = Variant(2.5);
+        REQUIRE(copy.hash() == var.hash());
+        REQUIRE(copy == var);
+        copy.modifyMap()["a"].modifyVec().pop_back();
+        REQUIRE(copy.hash() != var.hash());
+
+        std::unordered_set<Variant> set{var, Variant(1), Variant("x")};
+        REQUIRE(set.count(Variant::fromJson(json)) == 1);
+        REQUIRE(set.count(Variant(1)) == 1);
+        REQUIRE(set.count(Variant(1u)) == 0);
+    }
+
     SECTION("typeInfo") {
         using uchar = unsigned char;
         REQUIRE(Variant().typeInfo() == typeid(Variant::NullType));
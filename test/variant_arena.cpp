@@ -0,0 +1,99 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <yenxo/variant.hpp>
+#include <yenxo/variant_arena.hpp>
+
+#include <catch2/catch_all.hpp>
+
+#include <rapidjson/document.h>
+
+#include <type_traits>
+#include <vector>
+
+using namespace yenxo;
+
+// the arena stays an implementation detail of the storage
+static_assert(std::is_same_v<Variant::Vec, std::vector<Variant>>);
+static_assert(std::is_same_v<VariantVec, std::vector<Variant>>);
+
+TEST_CASE("Check VariantArena", "[variant_arena]") {
+    auto const json = R"({
+        "id": "a-rather-long-identifier-string",
+        "short": "abc",
+        "list": [1, "two", {"three": 3.5}],
+        "a-key-longer-than-small-string-buffer": null
+    })";
+
+    SECTION("fromJson") {
+        VariantArena arena;
+        auto const var = Variant::fromJson(json, arena);
+        REQUIRE(var == Variant::fromJson(json));
+        REQUIRE(var.map().at("id").strView() == "a-rather-long-identifier-string");
+        REQUIRE(arena.used() > 0);
+    }
+
+    SECTION("from") {
+        rapidjson::Document doc;
+        doc.Parse(json);
+        VariantArena arena;
+        REQUIRE(Variant::from(doc, arena) == Variant::from(doc));
+    }
+
+    SECTION("copy is independent of the arena") {
+        Variant copy;
+        {
+            VariantArena arena;
+            auto const var = Variant::fromJson(json, arena);
+            copy = var;
+        }
+        REQUIRE(copy == Variant::fromJson(json));
+    }
+
+    SECTION("vec is a plain std::vector") {
+        VariantArena arena;
+        auto const var = Variant::fromJson(json, arena);
+        std::vector<Variant> const list = var.map().at("list").vec();
+        REQUIRE(list == Variant::fromJson(json).map().at("list").vec());
+    }
+
+    SECTION("modify") {
+        VariantArena arena;
+        auto var = Variant::fromJson(json, arena);
+        var.modifyMap()["added"] = Variant("a string which does not fit inline");
+        var.modifyMap().at("list").modifyVec().push_back(Variant(4));
+        REQUIRE(var.map().at("added") == Variant("a string which does not fit inline"));
+        REQUIRE(var.map().at("list").vec().size() == 4);
+    }
+
+    SECTION("reset reuses the memory") {
+        VariantArena arena(64);
+        { auto const var = Variant::fromJson(json, arena); }
+        auto const capacity = arena.capacity();
+        arena.reset();
+        REQUIRE(arena.used() == 0);
+        { auto const var = Variant::fromJson(json, arena); }
+        REQUIRE(arena.capacity() == capacity);
+    }
+}
@@ -32,6 +32,7 @@
 
 #include <boost/hana/fuse.hpp>
 
+#include <deque>
 #include <map>
 #include <set>
 #include <string_view>
@@ -152,6 +153,37 @@ TEST_CASE("Check toVariant/fromVariant", "[variant_conversion]") {
                         Variant(VariantVec{Variant("e1"), Variant("e3")})),
                 VariantBadType,
                 ExceptionIs<VariantBadType>("'e3' is not of type 'E'", "/1"));
+
+        std::vector<int> ints(YENXO_PACKED_MIN_SIZE, 1);
+        ints.back() = -1;
+        REQUIRE(toVariant(ints).packedType() == Variant::TypeTag::int64_vec);
+        REQUIRE(toVariant(ints).vec().back() == Variant(-1));
+        REQUIRE(toVariant(ints) == Variant(VariantVec(ints.begin(), ints.end())));
+        REQUIRE(fromVariant<std::vector<int>>(toVariant(ints)) == ints);
+        REQUIRE(fromVariant<std::vector<int>>(Variant(toVariant(ints).vec())) == ints);
+        REQUIRE_THROWS_MATCHES(
+                fromVariant<std::vector<unsigned>>(toVariant(ints)),
+                VariantIntegralOverflow,
+                ExceptionIs<VariantIntegralOverflow>(
+                        "The type 'uint32' can not hold the value '-1'",
+                        "/" + std::to_string(YENXO_PACKED_MIN_SIZE - 1)));
+        REQUIRE(fromVariant<std::deque<int>>(toVariant(ints))
+                == std::deque<int>(ints.begin(), ints.end()));
+
+        std::vector<double> const doubles(YENXO_PACKED_MIN_SIZE, 1.5);
+        REQUIRE(toVariant(doubles).doubleVec()
+                == Variant::DoubleVec(doubles.begin(), doubles.end()));
+        REQUIRE(fromVariant<std::vector<double>>(toVariant(doubles)) == doubles);
+
+        std::vector<bool> const bools(YENXO_PACKED_MIN_SIZE, true);
+        REQUIRE(toVariant(bools).packedType() == Variant::TypeTag::bool_vec);
+        REQUIRE(fromVariant<std::vector<bool>>(toVariant(bools)) == bools);
+
+        std::vector<uint64_t> const big(YENXO_PACKED_MIN_SIZE, UINT64_MAX);
+        REQUIRE(toVariant(big).packedType() == Variant::TypeTag::uint64_vec);
+        REQUIRE(fromVariant<std::vector<uint64_t>>(toVariant(big)) == big);
+
+        REQUIRE(toVariant(std::vector<int>{1}) == Variant(VariantVec{Variant(1)}));
     }
 
     SECTION("std::set") {
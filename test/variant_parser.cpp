@@ -0,0 +1,177 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <yenxo/variant.hpp>
+#include <yenxo/variant_arena.hpp>
+#include <yenxo/variant_parser.hpp>
+
+#include <catch2/catch_all.hpp>
+
+#include <stdexcept>
+#include <string>
+#include <string_view>
+
+using namespace yenxo;
+
+namespace {
+
+Variant parse(VariantParser& parser, std::string_view json, std::size_t chunk) {
+    for (std::size_t i = 0; i < json.size(); i += chunk) {
+        parser.feed(json.substr(i, chunk));
+    }
+    return parser.finish();
+}
+
+/// The types of `v` and its nodes, `operator==` compares numbers across types
+std::string types(Variant const& v) {
+    std::string result = v.typeInfo().name();
+    if (v.isVec()) {
+        for (auto const& x : v.vec()) {
+            result += ' ' + types(x);
+        }
+    } else if (v.type() == Variant::TypeTag::map) {
+        for (auto const& [k, x] : v.map()) {
+            result += ' ' + types(x);
+        }
+    }
+    return result;
+}
+
+std::string error(std::string_view json) {
+    VariantParser parser;
+    try {
+        parser.feed(json);
+        parser.finish();
+    } catch (std::runtime_error const& e) {
+        return e.what();
+    }
+    return {};
+}
+
+} // namespace
+
+TEST_CASE("Check VariantParser", "[variant_parser]") {
+    std::string const json = R"( {
+        "numbers": [0, 1, -2, 3.5, -0, 1e2, 4294967296, -2147483649,
+                    18446744073709551615, 18446744073709551616],
+        "literals": [true, false, null],
+        "strings": ["", "short", "a string longer than the inline capacity",
+                    "esc\"aped\\\/\b\f\n\r\t", "é😀"],
+        "packed": [1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15, 16, 17],
+        "nested": {"empty": {}, "list": [[], [{}]]}
+    } )";
+    auto const expected = Variant::fromJson(json);
+
+    SECTION("any chunk boundary") {
+        VariantParser parser;
+        for (std::size_t chunk = 1; chunk <= json.size(); ++chunk) {
+            CAPTURE(chunk);
+            REQUIRE(parse(parser, json, chunk) == expected);
+        }
+        REQUIRE(parser.offset() == 0);
+    }
+
+    SECTION("arena") {
+        VariantArena arena;
+        VariantParser parser(arena);
+        REQUIRE(parse(parser, json, 7) == expected);
+        REQUIRE(arena.used() > 0);
+    }
+
+    SECTION("scalar") {
+        VariantParser parser;
+        parser.feed("12");
+        parser.feed("34");
+        REQUIRE(parser.offset() == 4);
+        REQUIRE(parser.finish() == Variant::fromJson("1234"));
+    }
+
+    SECTION("errors") {
+        // the messages of `rapidjson::GetParseError_En()` follow the offsets
+        REQUIRE(error("") == "offset 0: The document is empty.");
+        REQUIRE(error("[1,") == "offset 3: Invalid value.");
+        REQUIRE(error("[1 2]").rfind("offset 3: ", 0) == 0);
+        REQUIRE(error(R"({"a" 1})").rfind("offset 5: ", 0) == 0);
+        REQUIRE(error("1 2").rfind("offset 2: ", 0) == 0);
+        REQUIRE(error("01").rfind("offset 1: ", 0) == 0);
+        REQUIRE(error("1.").rfind("offset 2: ", 0) == 0);
+        REQUIRE(error("1e999").rfind("offset 5: ", 0) == 0);
+        REQUIRE(error(R"("\x")").rfind("offset 3: ", 0) == 0);
+        REQUIRE(error(R"("\ud800")").rfind("offset 7: ", 0) == 0);
+        REQUIRE(error(R"("abc)").rfind("offset 4: ", 0) == 0);
+
+        VariantParser parser;
+        REQUIRE_THROWS_AS(parser.feed("[nul!"), std::runtime_error);
+        parser.feed("[null]");
+        REQUIRE(parser.finish() == Variant::fromJson("[null]"));
+    }
+}
+
+TEST_CASE("Check VariantParser against fromJson", "[variant_parser]") {
+    char const* const corpus[] = {
+            "0",
+            "-0",
+            "-0.0",
+            "0e0",
+            "-0e-5",
+            "0.1",
+            "1e-400",
+            "-1e-400",
+            "4.9406564584124654e-324",
+            "2.2250738585072011e-308",
+            "1.7976931348623157e308",
+            "3.14159265358979323846",
+            "0.30000000000000004",
+            "123456789.123456789e-3",
+            "9007199254740993",
+            "2147483647",
+            "2147483648",
+            "-2147483648",
+            "-2147483649",
+            "4294967295",
+            "4294967296",
+            "9223372036854775807",
+            "-9223372036854775808",
+            "-9223372036854775809",
+            "18446744073709551615",
+            "18446744073709551616",
+            "123456789012345678901234567890",
+            "1E+2",
+            R"([-0, 0.5, -1, 1e2, [2.5e-3, {"a": -0.0, "b": [1, -1, 1.5]}]])",
+            R"({"x": {"y": [18446744073709551616, -9223372036854775809, 7]}})"};
+
+    VariantParser parser;
+    for (auto const json : corpus) {
+        CAPTURE(json);
+        auto const expected = Variant::fromJson(json);
+        auto const size = std::string_view(json).size();
+        for (std::size_t chunk : {std::size_t(1), std::size_t(3), size}) {
+            CAPTURE(chunk);
+            auto const actual = parse(parser, json, chunk);
+            REQUIRE(actual == expected);
+            REQUIRE(types(actual) == types(expected));
+            REQUIRE(actual.toJson() == expected.toJson());
+        }
+    }
+}
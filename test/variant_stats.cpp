@@ -0,0 +1,138 @@
+/*
+  MIT License
+
+  Copyright (c) 2018 Nicolai Trandafil
+
+  Permission is hereby granted, free of charge, to any person obtaining a copy
+  of this software and associated documentation files (the "Software"), to deal
+  in the Software without restriction, including without limitation the rights
+  to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  copies of the Software, and to permit persons to whom the Software is
+  furnished to do so, subject to the following conditions:
+
+  The above copyright notice and this permission notice shall be included in all
+  copies or substantial portions of the Software.
+
+  THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  SOFTWARE.
+*/
+
+#include <yenxo/variant.hpp>
+#include <yenxo/variant_stats.hpp>
+
+#include <catch2/catch_all.hpp>
+
+#include <atomic>
+#include <cstddef>
+#include <string>
+#include <utility>
+
+using namespace yenxo;
+
+namespace {
+
+using TypeTag = Variant::TypeTag;
+
+std::atomic<std::ptrdiff_t> payload_bytes{0};
+std::atomic<std::size_t> payload_allocations{0};
+
+void countPayload(std::ptrdiff_t bytes) noexcept {
+    payload_bytes += bytes;
+    payload_allocations += bytes > 0;
+}
+
+} // namespace
+
+TEST_CASE("Check stats", "[variant_stats]") {
+    SECTION("scalar") {
+        auto const x = stats(Variant(5));
+        REQUIRE(x.total() == 1);
+        REQUIRE(x.count(TypeTag::int32) == 1);
+        REQUIRE(x.max_depth == 1);
+        REQUIRE(x.heap_bytes == 0);
+    }
+
+    SECTION("tree") {
+        auto const x = stats(Variant::fromJson(
+                R"({"name": "a", "list": [1, "two", null], "nested": {"deep": [[]]}})"));
+        REQUIRE(x.total() == 9);
+        REQUIRE(x.count(TypeTag::map) == 2);
+        REQUIRE(x.count(TypeTag::vec) == 3);
+        REQUIRE(x.count(TypeTag::string) == 2);
+        REQUIRE(x.count(TypeTag::null) == 1);
+        REQUIRE(x.max_depth == 4);
+        REQUIRE(x.string_bytes == 4);
+        REQUIRE(x.key_bytes == 18);
+        REQUIRE(x.shared_payloads == 0);
+        REQUIRE(x.heap_bytes > 5 * sizeof(Variant));
+    }
+
+    SECTION("shared payloads are counted once") {
+        auto const sub = Variant::fromJson(R"({"k": [1, 2]})");
+        auto const one = stats(Variant(Variant::Vec{sub}));
+        auto const two = stats(Variant(Variant::Vec{sub, sub}));
+        REQUIRE(two.count(TypeTag::map) == 2);
+        REQUIRE(two.shared_payloads == 2);
+        REQUIRE(two.heap_bytes == one.heap_bytes + sizeof(Variant));
+    }
+
+    SECTION("packed array") {
+        Variant const x(Variant::Int64Vec{1, 2, 3});
+        auto const before = stats(x);
+        REQUIRE(before.total() == 1);
+        REQUIRE(before.count(TypeTag::int64_vec) == 1);
+        REQUIRE(before.packed_elements == 3);
+        REQUIRE(before.max_depth == 2);
+        REQUIRE(before.heap_bytes >= 3 * sizeof(int64_t));
+
+        // the values are freed once unpacked
+        (void)x.vec();
+        auto const after = stats(x);
+        REQUIRE(after.count(TypeTag::vec) == 1);
+        REQUIRE(after.count(TypeTag::int64) == 3);
+        REQUIRE(after.packed_elements == 0);
+        REQUIRE(after.heap_bytes
+                == before.heap_bytes - 3 * sizeof(int64_t) + sizeof(Variant::Vec)
+                           + 3 * sizeof(Variant));
+    }
+
+    SECTION("slack and index") {
+        Variant::Vec vec;
+        vec.reserve(10);
+        vec.emplace_back(1);
+        REQUIRE(stats(Variant(std::move(vec))).slack_bytes == 9 * sizeof(Variant));
+
+        Variant::Map map;
+        for (int i = 0; i < 100; ++i) {
+            map.try_emplace(std::to_string(i), i);
+        }
+        auto const buckets = map.bucket_count();
+        REQUIRE(buckets >= 200);
+        auto const x = stats(Variant(std::move(map)));
+        REQUIRE(x.index_bytes >= buckets * sizeof(uint32_t));
+        REQUIRE(x.heap_bytes > x.index_bytes + 100 * sizeof(Variant));
+    }
+}
+
+TEST_CASE("Check payload hook", "[variant_stats]") {
+    auto const previous = setPayloadHook(countPayload);
+    payload_bytes = 0;
+    payload_allocations = 0;
+    {
+        Variant::Vec list{Variant(1), Variant(2)};
+        Variant const x(Variant::Map{{"list", Variant(std::move(list))},
+                                     {"text", Variant(std::string(40, 'x'))}});
+        auto const copy = x;
+        // the string, the `Vec` and the `Map`, the copy shares them
+        REQUIRE(payload_allocations == 3);
+        REQUIRE(payload_bytes > 0);
+    }
+    REQUIRE(payload_bytes == 0);
+    bool const restored = setPayloadHook(previous) == &countPayload;
+    REQUIRE(restored);
+}
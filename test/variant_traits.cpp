@@ -404,7 +404,8 @@ struct Pol2 : trait::VarPolicy {
 
 struct Pol3 : trait::VarPolicy {
     static auto constexpr from_variant = [](auto& x, Variant const& var) {
-        x = yenxo::fromString<std::remove_reference_t<decltype(x)>>(var.str());
+        x = yenxo::fromString<std::remove_reference_t<decltype(x)>>(
+                std::string(var.strView()));
     };
     static auto constexpr to_variant = [](Variant& var, auto&& x) {
         var = Variant(
@@ -504,6 +505,29 @@ struct AutoCamelCase
     BOOST_HANA_DEFINE_STRUCT(AutoCamelCase, (std::string, hello_world_2_boo));
 };
 
+/// Prefix of the keys of `Prefixed`, changed at runtime
+std::string key_prefix;
+
+struct PrefixPolicy : trait::VarPolicy {
+    static constexpr auto rename = [](auto, auto name) {
+        return key_prefix + boost::hana::to<char const*>(name);
+    };
+};
+
+struct Prefixed
+        : trait::Var<Prefixed, PrefixPolicy>
+        , trait::EqualityComparison<Prefixed> {
+    BOOST_HANA_DEFINE_STRUCT(Prefixed, (int, x));
+};
+
+struct UpperPolicy : trait::VarPolicy {
+    static constexpr auto rename = [](auto, auto) { return "X"; };
+};
+
+struct Upper : trait::Var<Upper, UpperPolicy> {
+    BOOST_HANA_DEFINE_STRUCT(Upper, (int, x));
+};
+
 struct AdditionalProp
         : trait::Var<AdditionalProp, AllowAdditionalPropertiesPolicy>
         , trait::EqualityComparison<AdditionalProp> {
@@ -603,6 +627,24 @@ TEST_CASE("Check trait::Var", "[variant_traits]") {
         REQUIRE(fromVariant<AutoCamelCase>(var) == st);
     }
 
+    SECTION("runtime rename policy") {
+        using Name = std::decay_t<decltype("x"_s)>;
+        static_assert(trait::detail::cachedKey<Upper, UpperPolicy, Name>);
+        static_assert(!trait::detail::cachedKey<Prefixed, PrefixPolicy, Name>);
+        REQUIRE(toVariant(Upper{{}, 1}) == Variant(VariantMap{{"X", Variant(1)}}));
+
+        Prefixed st;
+        st.x = 1;
+        key_prefix = "a_";
+        REQUIRE(toVariant(st) == Variant(VariantMap{{"a_x", Variant(1)}}));
+        key_prefix = "b_";
+        REQUIRE(toVariant(st) == Variant(VariantMap{{"b_x", Variant(1)}}));
+        REQUIRE(fromVariant<Prefixed>(Variant(VariantMap{{"b_x", Variant(1)}})) == st);
+        REQUIRE_THROWS_WITH(fromVariant<Prefixed>(Variant(VariantMap{{"a_x", Variant(1)}})),
+                            "'b_x' is required");
+        key_prefix.clear();
+    }
+
     SECTION("additional prop policy") {
         Variant var(VariantMap{{"x", Variant(1)}, {"z", Variant(2)}});
 
@@ -62,7 +62,7 @@ namespace yenxo {
 template <>
 struct FromVariantImpl<UserDefinedStr> {
     static UserDefinedStr apply(Variant const& x) {
-        return x.str();
+        return std::string(x.strView());
     }
 };
 